@@ -16,17 +16,21 @@
 #define MIDI_CLIENT_PRIVATE_H
 
 #include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "midi_broadcast_ring.h"
 #include "midi_client.h"
 #include "midi_service_interface.h"
 #include "midi_shared_ring.h"
+#include "midi_utils.h"
 #include "midi_callback_stub.h"
 #include "midi_device_open_callback_stub.h"
 namespace OHOS {
@@ -42,34 +46,73 @@ class MidiClientCallback;
 class MidiInputPort {
 public:
     MidiInputPort(OH_MIDIDevice_OnReceived callback, void *userData, OH_MIDIProtocol protocol);
+    // delivers once per audio period, without a callback there is no thread and the app reads each period
+    MidiInputPort(const OH_MIDIPeriodConfig &config, OH_MIDIDevice_OnPeriodReceived callback, void *userData,
+        OH_MIDIProtocol protocol);
     ~MidiInputPort();
     std::shared_ptr<MidiSharedRing> &GetRingBuffer();
+    std::shared_ptr<MidiBroadcastRing> &GetBroadcastRing();
 
     bool StartReceiverThread();
     bool StopReceiverThread();
 
+    // without a callback the port has no thread and the app reads it, the events stay in the ring until the next read
+    OH_MIDIStatusCode ReadEvents(OH_MIDIEvent *events, size_t capacity, size_t *eventCount);
+
+    bool IsPeriodic() const;
+    void SetPeriodClock(const Timestamp &reference);
+    OH_MIDIStatusCode ReadPeriodEvents(int64_t periodFramePosition, OH_MIDIPeriodEvent *events, size_t capacity,
+        size_t *eventCount);
+
 private:
     void ReceiverThreadLoop();
 
+    void BroadcastReceiverLoop();
+
     void DrainRingAndDispatch();
 
+    void DrainBroadcastAndDispatch();
+
+    void Dispatch(const std::vector<MidiEvent> &midiEvents);
+
     bool ShouldWakeForReadOrExit() const;
 
+    bool StartPeriodDelivery();
+
+    void PeriodReceiverLoop();
+
+    // moves up to maxEvents events of the period before periodStart into periodEvents_, under periodMutex_,
+    // bounded by the capacity reserved at open so it never allocates
+    size_t CollectPeriod(int64_t periodStart, size_t maxEvents);
+
     std::atomic<bool> running_ = false;
     OH_MIDIDevice_OnReceived callback_ = nullptr;
     std::shared_ptr<MidiSharedRing> ringBuffer_ = nullptr;
+    std::shared_ptr<MidiBroadcastRing> broadcastRing_ = nullptr;
+    MidiBroadcastRing::Cursor broadcastCursor_;
     std::thread receiverThread_;
     void *userData_ = nullptr;
     OH_MIDIProtocol protocol_;
+    OH_MIDIDevice_OnPeriodReceived periodCallback_ = nullptr;
+    std::unique_ptr<MidiPeriodClock> periodClock_ = nullptr;
+    std::mutex periodMutex_;
+    std::condition_variable periodCondition_;
+    std::vector<OH_MIDIPeriodEvent> periodEvents_;
+    std::vector<uint32_t> periodWords_; // payloads of periodEvents_
+    std::mutex readMutex_; // only try-locked, ReadEvents has one reader per port
+    MidiSharedRing::PeekedEvent lastRead_{}; // last event handed out by ReadEvents, committed on the next read
+    bool hasLastRead_ = false;
 };
 
 class MidiOutputPort {
 public:
     MidiOutputPort(OH_MIDIProtocol protocol);
     ~MidiOutputPort();
-    int32_t Send(OH_MIDIEvent *events, uint32_t eventCount, uint32_t *eventsWritten);
+    int32_t Send(OH_MIDIEvent *events, uint32_t eventCount, uint32_t *eventsWritten, uint16_t tag = 0);
     int32_t SendSysEx(uint32_t portIndex, uint8_t *data, uint32_t byteSize);
+    int32_t AppendTimeline(OH_MIDIEvent *events, uint32_t eventCount, uint32_t *eventsWritten);
     std::shared_ptr<MidiSharedRing> &GetRingBuffer();
+    std::shared_ptr<MidiSharedTimeline> &GetTimeline();
 private:
     void PrepareSysExPackets(uint8_t group, uint8_t *data, uint32_t byteSize, uint32_t totalPkts,
             SysExPacketData &packetData);
@@ -77,6 +120,7 @@ private:
             const std::chrono::steady_clock::time_point &start);
 
     std::shared_ptr<MidiSharedRing> ringBuffer_ = nullptr;
+    std::shared_ptr<MidiSharedTimeline> timeline_ = nullptr;
     OH_MIDIProtocol protocol_;
 };
 
@@ -87,6 +131,17 @@ public:
     OH_MIDIStatusCode CloseDevice() override;
     OH_MIDIStatusCode OpenInputPort(OH_MIDIPortDescriptor descriptor,
                                     OH_MIDIDevice_OnReceived callback, void *userData) override;
+    OH_MIDIStatusCode OpenInputPortBroadcast(OH_MIDIPortDescriptor descriptor,
+                                             OH_MIDIDevice_OnReceived callback, void *userData) override;
+    OH_MIDIStatusCode OpenInputPortWithFilter(OH_MIDIPortDescriptor descriptor, const OH_MIDIInputFilter &filter,
+                                              OH_MIDIDevice_OnReceived callback, void *userData) override;
+    OH_MIDIStatusCode ReadEvents(uint32_t portIndex, OH_MIDIEvent *events, size_t capacity,
+                                 size_t *eventCount) override;
+    OH_MIDIStatusCode OpenInputPortPeriodic(OH_MIDIPortDescriptor descriptor, const OH_MIDIPeriodConfig &config,
+                                            OH_MIDIDevice_OnPeriodReceived callback, void *userData) override;
+    OH_MIDIStatusCode SetPeriodClock(uint32_t portIndex, uint64_t framePosition, uint64_t timestamp) override;
+    OH_MIDIStatusCode ReadPeriodEvents(uint32_t portIndex, uint64_t periodFramePosition, OH_MIDIPeriodEvent *events,
+                                       size_t capacity, size_t *eventCount) override;
     OH_MIDIStatusCode OpenOutputPort(OH_MIDIPortDescriptor descriptor) override;
     OH_MIDIStatusCode CloseInputPort(uint32_t portIndex) override;
     OH_MIDIStatusCode CloseOutputPort(uint32_t portIndex) override;
@@ -94,9 +149,29 @@ public:
                             uint32_t eventCount, uint32_t *eventsWritten) override;
     OH_MIDIStatusCode SendSysEx(uint32_t portIndex, uint8_t *data, uint32_t byteSize) override;
     OH_MIDIStatusCode FlushOutputPort(uint32_t portIndex) override;
+    OH_MIDIStatusCode SendTagged(uint32_t portIndex, OH_MIDIEvent *events, uint32_t eventCount,
+                                 uint16_t tag, uint32_t *eventsWritten) override;
+    OH_MIDIStatusCode CancelScheduledEvents(uint32_t portIndex, uint16_t tag, uint64_t beginTimestamp,
+                                            uint64_t endTimestamp) override;
+    OH_MIDIStatusCode OpenOutputTimeline(uint32_t portIndex, uint32_t capacityBytes) override;
+    OH_MIDIStatusCode AppendTimeline(uint32_t portIndex, OH_MIDIEvent *events, uint32_t eventCount,
+                                     uint32_t *eventsWritten) override;
+    OH_MIDIStatusCode SetTimelineLoop(uint32_t portIndex, uint64_t loopBegin, uint64_t loopEnd) override;
+    OH_MIDIStatusCode StartTimeline(uint32_t portIndex, uint64_t startTimestamp, uint64_t startPosition) override;
+    OH_MIDIStatusCode StopTimeline(uint32_t portIndex) override;
+    OH_MIDIStatusCode ClearTimeline(uint32_t portIndex) override;
+    OH_MIDIStatusCode SetOutputPortExclusive(uint32_t portIndex, bool exclusive) override;
+    OH_MIDIStatusCode SetPortNotifyModeration(uint32_t portIndex, OH_MIDIPortDirection direction,
+                                              uint32_t maxPendingEvents, uint32_t maxDelayUs) override;
     void SetInValid();
 
 private:
+    // openPort asks the service for the port and hands the ring to the MidiInputPort
+    OH_MIDIStatusCode OpenInputPortInner(OH_MIDIPortDescriptor descriptor, std::shared_ptr<MidiInputPort> inputPort,
+        const std::function<OH_MIDIStatusCode(MidiServiceInterface &, MidiInputPort &)> &openPort);
+    std::shared_ptr<MidiInputPort> GetInputPort(uint32_t portIndex);
+    std::shared_ptr<MidiSharedTimeline> GetOutputTimeline(uint32_t portIndex);
+
     std::weak_ptr<MidiServiceInterface> ipc_;
     int64_t deviceId_;
     std::mutex inputPortsMutex_;
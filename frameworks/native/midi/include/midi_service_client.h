@@ -41,6 +41,15 @@ public:
     OH_MIDIStatusCode OpenOutputPort(std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId,
                                     uint32_t portIndex) override;
     OH_MIDIStatusCode FlushOutputPort(int64_t deviceId, uint32_t portIndex) override;
+    OH_MIDIStatusCode CancelScheduledEvents(int64_t deviceId, uint32_t portIndex, uint16_t tag,
+                                            uint64_t beginTimestamp, uint64_t endTimestamp) override;
+    OH_MIDIStatusCode OpenOutputTimeline(std::shared_ptr<MidiSharedTimeline> &timeline, int64_t deviceId,
+                                         uint32_t portIndex, uint32_t capacityBytes) override;
+    OH_MIDIStatusCode SetOutputPortExclusive(int64_t deviceId, uint32_t portIndex, bool exclusive) override;
+    OH_MIDIStatusCode OpenInputPortBroadcast(std::shared_ptr<MidiBroadcastRing> &ring, int64_t deviceId,
+                                             uint32_t portIndex) override;
+    OH_MIDIStatusCode OpenInputPortWithFilter(std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId,
+                                              uint32_t portIndex, const MidiInputFilter &filter) override;
     OH_MIDIStatusCode CloseInputPort(int64_t deviceId, uint32_t portIndex) override;
     OH_MIDIStatusCode CloseOutputPort(int64_t deviceId, uint32_t portIndex) override;
     OH_MIDIStatusCode DestroyMidiClient() override;
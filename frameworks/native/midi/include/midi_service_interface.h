@@ -18,8 +18,10 @@
 #include "imidi_service.h"
 #include "midi_callback_stub.h"
 #include "midi_device_open_callback_stub.h"
+#include "midi_broadcast_ring.h"
 #include "midi_info.h"
 #include "midi_shared_ring.h"
+#include "midi_shared_timeline.h"
 #include "native_midi_base.h"
 #include <memory>
 namespace OHOS {
@@ -38,6 +40,15 @@ public:
     virtual OH_MIDIStatusCode OpenOutputPort(std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId,
                                     uint32_t portIndex) = 0;
     virtual OH_MIDIStatusCode FlushOutputPort(int64_t deviceId, uint32_t portIndex) = 0;
+    virtual OH_MIDIStatusCode CancelScheduledEvents(int64_t deviceId, uint32_t portIndex, uint16_t tag,
+                                                    uint64_t beginTimestamp, uint64_t endTimestamp) = 0;
+    virtual OH_MIDIStatusCode OpenOutputTimeline(std::shared_ptr<MidiSharedTimeline> &timeline, int64_t deviceId,
+                                                 uint32_t portIndex, uint32_t capacityBytes) = 0;
+    virtual OH_MIDIStatusCode SetOutputPortExclusive(int64_t deviceId, uint32_t portIndex, bool exclusive) = 0;
+    virtual OH_MIDIStatusCode OpenInputPortBroadcast(std::shared_ptr<MidiBroadcastRing> &ring, int64_t deviceId,
+                                                     uint32_t portIndex) = 0;
+    virtual OH_MIDIStatusCode OpenInputPortWithFilter(std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId,
+                                                      uint32_t portIndex, const MidiInputFilter &filter) = 0;
     virtual OH_MIDIStatusCode CloseInputPort(int64_t deviceId, uint32_t portIndex) = 0;
     virtual OH_MIDIStatusCode CloseOutputPort(int64_t deviceId, uint32_t portIndex) = 0;
     virtual OH_MIDIStatusCode DestroyMidiClient() = 0;
@@ -17,8 +17,11 @@
 #define LOG_TAG "MidiClient"
 #endif
 
+#include <algorithm>
+#include <cinttypes>
 #include <cstring>
 #include <chrono>
+#include <limits>
 
 #include "midi_log.h"
 #include "midi_client_private.h"
@@ -30,6 +33,17 @@ namespace MIDI {
 namespace {
     constexpr uint32_t MAX_EVENTS_NUMS = 1000;
     constexpr uint32_t PORT_GROUP_RANGE = 16;
+    constexpr size_t PERIOD_EVENTS_RESERVED = 256;
+    constexpr size_t PERIOD_WORDS_RESERVED = 1024;
+
+    Timestamp MakeTimestamp(uint64_t framePosition, uint64_t timeNs)
+    {
+        Timestamp timestamp;
+        timestamp.framePosition = framePosition;
+        timestamp.time.tv_sec = static_cast<time_t>(timeNs / MIDI_NS_PER_SECOND);
+        timestamp.time.tv_nsec = static_cast<long>(timeNs % MIDI_NS_PER_SECOND);
+        return timestamp;
+    }
 }  // namespace
 class MidiClientCallback : public MidiCallbackStub {
 public:
@@ -162,6 +176,49 @@ OH_MIDIStatusCode MidiDevicePrivate::CloseDevice()
 
 OH_MIDIStatusCode MidiDevicePrivate::OpenInputPort(OH_MIDIPortDescriptor descriptor,
     OH_MIDIDevice_OnReceived callback, void *userData)
+{
+    auto inputPort = std::make_shared<MidiInputPort>(callback, userData, descriptor.protocol);
+    return OpenInputPortInner(descriptor, inputPort, [this, &descriptor](auto &ipc, auto &inputPort) {
+        return ipc.OpenInputPort(inputPort.GetRingBuffer(), deviceId_, descriptor.portIndex);
+    });
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::OpenInputPortBroadcast(OH_MIDIPortDescriptor descriptor,
+    OH_MIDIDevice_OnReceived callback, void *userData)
+{
+    auto inputPort = std::make_shared<MidiInputPort>(callback, userData, descriptor.protocol);
+    return OpenInputPortInner(descriptor, inputPort, [this, &descriptor](auto &ipc, auto &inputPort) {
+        return ipc.OpenInputPortBroadcast(inputPort.GetBroadcastRing(), deviceId_, descriptor.portIndex);
+    });
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::OpenInputPortWithFilter(OH_MIDIPortDescriptor descriptor,
+    const OH_MIDIInputFilter &filter, OH_MIDIDevice_OnReceived callback, void *userData)
+{
+    const MidiInputFilter inputFilter(filter);
+    auto inputPort = std::make_shared<MidiInputPort>(callback, userData, descriptor.protocol);
+    return OpenInputPortInner(descriptor, inputPort,
+        [this, &descriptor, &inputFilter](auto &ipc, auto &inputPort) {
+            return ipc.OpenInputPortWithFilter(inputPort.GetRingBuffer(), deviceId_, descriptor.portIndex,
+                inputFilter);
+        });
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::OpenInputPortPeriodic(OH_MIDIPortDescriptor descriptor,
+    const OH_MIDIPeriodConfig &config, OH_MIDIDevice_OnPeriodReceived callback, void *userData)
+{
+    CHECK_AND_RETURN_RET_LOG(MidiPeriodClock::IsValidConfig(config.framesPerPeriod, config.sampleRate),
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "invalid period %{public}u frames at %{public}u Hz",
+        config.framesPerPeriod, config.sampleRate);
+    auto inputPort = std::make_shared<MidiInputPort>(config, callback, userData, descriptor.protocol);
+    return OpenInputPortInner(descriptor, inputPort, [this, &descriptor](auto &ipc, auto &inputPort) {
+        return ipc.OpenInputPort(inputPort.GetRingBuffer(), deviceId_, descriptor.portIndex);
+    });
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::OpenInputPortInner(OH_MIDIPortDescriptor descriptor,
+    std::shared_ptr<MidiInputPort> inputPort,
+    const std::function<OH_MIDIStatusCode(MidiServiceInterface &, MidiInputPort &)> &openPort)
 {
     std::lock_guard<std::mutex> lock(inputPortsMutex_);
     auto ipc = ipc_.lock();
@@ -169,14 +226,15 @@ OH_MIDIStatusCode MidiDevicePrivate::OpenInputPort(OH_MIDIPortDescriptor descrip
 
     auto iter = inputPortsMap_.find(descriptor.portIndex);
     CHECK_AND_RETURN_RET(iter == inputPortsMap_.end(), OH_MIDI_STATUS_PORT_ALREADY_OPEN);
-    auto inputPort = std::make_shared<MidiInputPort>(callback, userData, descriptor.protocol);
 
-    std::shared_ptr<MidiSharedRing> &buffer = inputPort->GetRingBuffer();
-    auto ret = ipc->OpenInputPort(buffer, deviceId_, descriptor.portIndex);
+    auto ret = openPort(*ipc, *inputPort);
     CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "open inputport fail");
 
-    CHECK_AND_RETURN_RET_LOG(
-        inputPort->StartReceiverThread() == true, OH_MIDI_STATUS_SYSTEM_ERROR, "start receiver thread fail");
+    if (!inputPort->StartReceiverThread()) {
+        MIDI_ERR_LOG("start receiver thread fail");
+        (void)ipc->CloseInputPort(deviceId_, descriptor.portIndex);
+        return OH_MIDI_STATUS_SYSTEM_ERROR;
+    }
 
     inputPortsMap_.emplace(descriptor.portIndex, std::move(inputPort));
     MIDI_INFO_LOG("port[%{public}u] success", descriptor.portIndex);
@@ -235,6 +293,169 @@ OH_MIDIStatusCode MidiDevicePrivate::FlushOutputPort(uint32_t portIndex)
     return OH_MIDI_STATUS_OK;
 }
 
+OH_MIDIStatusCode MidiDevicePrivate::SendTagged(uint32_t portIndex, OH_MIDIEvent *events,
+    uint32_t eventCount, uint16_t tag, uint32_t *eventsWritten)
+{
+    std::lock_guard<std::mutex> lock(outputPortsMutex_);
+    auto iter = outputPortsMap_.find(portIndex);
+    CHECK_AND_RETURN_RET_LOG(iter != outputPortsMap_.end(), OH_MIDI_STATUS_INVALID_PORT, "invalid port");
+    CHECK_AND_RETURN_RET_LOG(isValid_ != false, OH_MIDI_STATUS_GENERIC_IPC_FAILURE, "ipc failed");
+    auto outputPort = iter->second;
+    return (OH_MIDIStatusCode)outputPort->Send(events, eventCount, eventsWritten, tag);
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::CancelScheduledEvents(uint32_t portIndex, uint16_t tag,
+    uint64_t beginTimestamp, uint64_t endTimestamp)
+{
+    CHECK_AND_RETURN_RET_LOG(beginTimestamp <= endTimestamp, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "invalid time range");
+    std::lock_guard<std::mutex> lock(outputPortsMutex_);
+    auto ipc = ipc_.lock();
+    auto iter = outputPortsMap_.find(portIndex);
+    CHECK_AND_RETURN_RET_LOG(ipc != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "ipc_ is nullptr");
+    CHECK_AND_RETURN_RET_LOG(iter != outputPortsMap_.end(), OH_MIDI_STATUS_INVALID_PORT, "invalid port");
+    auto ret = ipc->CancelScheduledEvents(deviceId_, portIndex, tag, beginTimestamp, endTimestamp);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "cancel scheduled events fail");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::OpenOutputTimeline(uint32_t portIndex, uint32_t capacityBytes)
+{
+    CHECK_AND_RETURN_RET_LOG(capacityBytes > 0 && capacityBytes <= MIDI_TIMELINE_MAX_CAPACITY,
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "invalid timeline capacity");
+    std::lock_guard<std::mutex> lock(outputPortsMutex_);
+    auto ipc = ipc_.lock();
+    auto iter = outputPortsMap_.find(portIndex);
+    CHECK_AND_RETURN_RET_LOG(ipc != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "ipc_ is nullptr");
+    CHECK_AND_RETURN_RET_LOG(iter != outputPortsMap_.end(), OH_MIDI_STATUS_INVALID_PORT, "invalid port");
+    std::shared_ptr<MidiSharedTimeline> &timeline = iter->second->GetTimeline();
+    auto ret = ipc->OpenOutputTimeline(timeline, deviceId_, portIndex, capacityBytes);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "open output timeline fail");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::AppendTimeline(uint32_t portIndex, OH_MIDIEvent *events, uint32_t eventCount,
+    uint32_t *eventsWritten)
+{
+    std::lock_guard<std::mutex> lock(outputPortsMutex_);
+    auto iter = outputPortsMap_.find(portIndex);
+    CHECK_AND_RETURN_RET_LOG(iter != outputPortsMap_.end(), OH_MIDI_STATUS_INVALID_PORT, "invalid port");
+    CHECK_AND_RETURN_RET_LOG(isValid_ != false, OH_MIDI_STATUS_GENERIC_IPC_FAILURE, "ipc failed");
+    return (OH_MIDIStatusCode)iter->second->AppendTimeline(events, eventCount, eventsWritten);
+}
+
+std::shared_ptr<MidiSharedTimeline> MidiDevicePrivate::GetOutputTimeline(uint32_t portIndex)
+{
+    std::lock_guard<std::mutex> lock(outputPortsMutex_);
+    auto iter = outputPortsMap_.find(portIndex);
+    CHECK_AND_RETURN_RET(iter != outputPortsMap_.end(), nullptr);
+    return iter->second->GetTimeline();
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::SetTimelineLoop(uint32_t portIndex, uint64_t loopBegin, uint64_t loopEnd)
+{
+    CHECK_AND_RETURN_RET_LOG(loopBegin <= loopEnd, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "invalid loop range");
+    auto timeline = GetOutputTimeline(portIndex);
+    CHECK_AND_RETURN_RET_LOG(timeline != nullptr, OH_MIDI_STATUS_INVALID_PORT, "timeline not opened");
+    timeline->SetLoop(loopBegin, loopEnd);
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::StartTimeline(uint32_t portIndex, uint64_t startTimestamp,
+    uint64_t startPosition)
+{
+    auto timeline = GetOutputTimeline(portIndex);
+    CHECK_AND_RETURN_RET_LOG(timeline != nullptr, OH_MIDI_STATUS_INVALID_PORT, "timeline not opened");
+    CHECK_AND_RETURN_RET_LOG(isValid_ != false, OH_MIDI_STATUS_GENERIC_IPC_FAILURE, "ipc failed");
+    timeline->Start(startTimestamp, startPosition);
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::StopTimeline(uint32_t portIndex)
+{
+    auto timeline = GetOutputTimeline(portIndex);
+    CHECK_AND_RETURN_RET_LOG(timeline != nullptr, OH_MIDI_STATUS_INVALID_PORT, "timeline not opened");
+    timeline->Stop();
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::ClearTimeline(uint32_t portIndex)
+{
+    auto timeline = GetOutputTimeline(portIndex);
+    CHECK_AND_RETURN_RET_LOG(timeline != nullptr, OH_MIDI_STATUS_INVALID_PORT, "timeline not opened");
+    timeline->Clear();
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::SetOutputPortExclusive(uint32_t portIndex, bool exclusive)
+{
+    std::lock_guard<std::mutex> lock(outputPortsMutex_);
+    auto ipc = ipc_.lock();
+    auto iter = outputPortsMap_.find(portIndex);
+    CHECK_AND_RETURN_RET_LOG(ipc != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "ipc_ is nullptr");
+    CHECK_AND_RETURN_RET_LOG(iter != outputPortsMap_.end(), OH_MIDI_STATUS_INVALID_PORT, "invalid port");
+    auto ret = ipc->SetOutputPortExclusive(deviceId_, portIndex, exclusive);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "set output port exclusive fail");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::SetPortNotifyModeration(uint32_t portIndex, OH_MIDIPortDirection direction,
+    uint32_t maxPendingEvents, uint32_t maxDelayUs)
+{
+    CHECK_AND_RETURN_RET_LOG(maxDelayUs <= MIDI_NOTIFY_MAX_DELAY_US, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "delay %{public}u us too long", maxDelayUs);
+    std::shared_ptr<MidiSharedRing> ring = nullptr;
+    if (direction == MIDI_PORT_DIRECTION_INPUT) {
+        std::lock_guard<std::mutex> lock(inputPortsMutex_);
+        auto iter = inputPortsMap_.find(portIndex);
+        CHECK_AND_RETURN_RET_LOG(iter != inputPortsMap_.end(), OH_MIDI_STATUS_INVALID_PORT, "invalid input port");
+        ring = iter->second->GetRingBuffer();
+    } else {
+        std::lock_guard<std::mutex> lock(outputPortsMutex_);
+        auto iter = outputPortsMap_.find(portIndex);
+        CHECK_AND_RETURN_RET_LOG(iter != outputPortsMap_.end(), OH_MIDI_STATUS_INVALID_PORT, "invalid output port");
+        ring = iter->second->GetRingBuffer();
+    }
+    // broadcast input ports share one ring between clients and are not moderated
+    CHECK_AND_RETURN_RET_LOG(ring != nullptr, OH_MIDI_STATUS_INVALID_PORT, "port has no ring of its own");
+    // the header is shared, the service side follows the setting on its next write or wait
+    ring->SetNotifyModeration(maxPendingEvents, maxDelayUs);
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::ReadEvents(uint32_t portIndex, OH_MIDIEvent *events, size_t capacity,
+    size_t *eventCount)
+{
+    auto inputPort = GetInputPort(portIndex);
+    CHECK_AND_RETURN_RET_LOG(inputPort != nullptr, OH_MIDI_STATUS_INVALID_PORT, "invalid input port");
+    return inputPort->ReadEvents(events, capacity, eventCount);
+}
+
+std::shared_ptr<MidiInputPort> MidiDevicePrivate::GetInputPort(uint32_t portIndex)
+{
+    std::lock_guard<std::mutex> lock(inputPortsMutex_);
+    auto iter = inputPortsMap_.find(portIndex);
+    CHECK_AND_RETURN_RET(iter != inputPortsMap_.end(), nullptr);
+    return iter->second;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::SetPeriodClock(uint32_t portIndex, uint64_t framePosition, uint64_t timestamp)
+{
+    auto inputPort = GetInputPort(portIndex);
+    CHECK_AND_RETURN_RET_LOG(inputPort != nullptr && inputPort->IsPeriodic(), OH_MIDI_STATUS_INVALID_PORT,
+        "invalid periodic input port");
+    inputPort->SetPeriodClock(MakeTimestamp(framePosition, timestamp));
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode MidiDevicePrivate::ReadPeriodEvents(uint32_t portIndex, uint64_t periodFramePosition,
+    OH_MIDIPeriodEvent *events, size_t capacity, size_t *eventCount)
+{
+    auto inputPort = GetInputPort(portIndex);
+    CHECK_AND_RETURN_RET_LOG(inputPort != nullptr, OH_MIDI_STATUS_INVALID_PORT, "invalid input port");
+    return inputPort->ReadPeriodEvents(static_cast<int64_t>(periodFramePosition), events, capacity, eventCount);
+}
+
 OH_MIDIStatusCode MidiDevicePrivate::CloseInputPort(uint32_t portIndex)
 {
     auto ipc = ipc_.lock();
@@ -276,11 +497,35 @@ MidiInputPort::MidiInputPort(OH_MIDIDevice_OnReceived callback, void *userData,
     MIDI_INFO_LOG("InputPort created");
 }
 
+MidiInputPort::MidiInputPort(const OH_MIDIPeriodConfig &config, OH_MIDIDevice_OnPeriodReceived callback,
+    void *userData, OH_MIDIProtocol protocol)
+    : userData_(userData), protocol_(protocol), periodCallback_(callback),
+      periodClock_(std::make_unique<MidiPeriodClock>(config.framesPerPeriod, config.sampleRate))
+{
+    periodEvents_.reserve(PERIOD_EVENTS_RESERVED);
+    periodWords_.reserve(PERIOD_WORDS_RESERVED);
+    MIDI_INFO_LOG("InputPort created, %{public}u frames per period at %{public}u Hz",
+        config.framesPerPeriod, config.sampleRate);
+}
+
 bool MidiInputPort::StartReceiverThread()
 {
     CHECK_AND_RETURN_RET_LOG(running_.load() != true, false, "already start");
-    CHECK_AND_RETURN_RET_LOG(ringBuffer_ != nullptr && callback_ != nullptr, false, "buffer or callback is nullptr");
+    if (periodClock_ != nullptr) {
+        return StartPeriodDelivery();
+    }
+    if (callback_ == nullptr && ringBuffer_ != nullptr && broadcastRing_ == nullptr) {
+        // read by the app with ReadEvents, nothing to start
+        return true;
+    }
+    CHECK_AND_RETURN_RET_LOG((ringBuffer_ != nullptr || broadcastRing_ != nullptr) && callback_ != nullptr, false,
+        "buffer or callback is nullptr");
     running_.store(true);
+    if (broadcastRing_ != nullptr) {
+        broadcastRing_->AttachCursor(broadcastCursor_);
+        receiverThread_ = std::thread(&MidiInputPort::BroadcastReceiverLoop, this);
+        return true;
+    }
     receiverThread_ = std::thread(&MidiInputPort::ReceiverThreadLoop, this);
     return true;
 }
@@ -297,6 +542,13 @@ bool MidiInputPort::StopReceiverThread()
             (void)FutexTool::FutexWake(futexPtr, IS_PRE_EXIT);
         }
     }
+    if (broadcastRing_) {
+        broadcastRing_->WakeReaders();
+    }
+    if (periodClock_ != nullptr) {
+        std::lock_guard<std::mutex> lock(periodMutex_);
+        periodCondition_.notify_all();
+    }
     if (receiverThread_.joinable()) {
         receiverThread_.join();
     }
@@ -319,7 +571,8 @@ void MidiInputPort::ReceiverThreadLoop()
     constexpr int64_t kWaitForever = -1;
 
     while (running_.load()) {
-        (void)FutexTool::FutexWait(futexPtr, kWaitForever, [this]() { return ShouldWakeForReadOrExit(); });
+        // on a moderated ring WaitFor also wakes up by itself to collect events the server held back
+        (void)ringBuffer_->WaitFor(kWaitForever, [this]() { return ShouldWakeForReadOrExit(); });
 
         if (!running_.load()) {
             break;
@@ -329,6 +582,23 @@ void MidiInputPort::ReceiverThreadLoop()
     }
 }
 
+void MidiInputPort::BroadcastReceiverLoop()
+{
+    // the mapping is read-only, a wake from StopReceiverThread can slip in before the wait starts,
+    // so wait in slices and look at running_ again after each one
+    constexpr int64_t kWaitSliceNs = 100000000; // 100ms
+    while (running_.load()) {
+        (void)broadcastRing_->Wait(kWaitSliceNs,
+            [this]() { return !running_.load() || broadcastRing_->HasEvents(broadcastCursor_); });
+
+        if (!running_.load()) {
+            break;
+        }
+
+        DrainBroadcastAndDispatch();
+    }
+}
+
 bool MidiInputPort::ShouldWakeForReadOrExit() const
 {
     if (!running_.load()) {
@@ -353,7 +623,29 @@ void MidiInputPort::DrainRingAndDispatch()
     std::vector<std::vector<uint32_t>> payloadBuffers;
 
     ringBuffer_->DrainToBatch(midiEvents, payloadBuffers, 0);
+    Dispatch(midiEvents);
+}
+
+void MidiInputPort::DrainBroadcastAndDispatch()
+{
+    if (!broadcastRing_ || callback_ == nullptr) {
+        return;
+    }
+
+    std::vector<MidiEvent> midiEvents;
+    std::vector<std::vector<uint32_t>> payloadBuffers;
 
+    const uint64_t lostBefore = broadcastCursor_.lost;
+    (void)broadcastRing_->Read(broadcastCursor_, midiEvents, payloadBuffers);
+    if (broadcastCursor_.lost != lostBefore) {
+        MIDI_WARNING_LOG("lost %{public}" PRIu64 " events, total %{public}" PRIu64,
+            broadcastCursor_.lost - lostBefore, broadcastCursor_.lost);
+    }
+    Dispatch(midiEvents);
+}
+
+void MidiInputPort::Dispatch(const std::vector<MidiEvent> &midiEvents)
+{
     if (midiEvents.empty()) {
         return;
     }
@@ -374,6 +666,145 @@ void MidiInputPort::DrainRingAndDispatch()
     callback_(userData_, callbackEvents.data(), callbackEvents.size());
 }
 
+bool MidiInputPort::StartPeriodDelivery()
+{
+    CHECK_AND_RETURN_RET_LOG(ringBuffer_ != nullptr, false, "buffer is nullptr");
+    if (periodCallback_ == nullptr) {
+        // read by the app, its first read anchors the periods unless it sets the clock before
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(periodMutex_);
+        if (!periodClock_->HasReference()) {
+            periodClock_->SetReference(MakeTimestamp(0, static_cast<uint64_t>(ClockTime::GetCurNano())));
+        }
+    }
+    running_.store(true);
+    receiverThread_ = std::thread(&MidiInputPort::PeriodReceiverLoop, this);
+    return true;
+}
+
+void MidiInputPort::PeriodReceiverLoop()
+{
+    // the thread sleeps until period boundaries and never waits on the ring futex, so writes cost no wakeups
+    std::unique_lock<std::mutex> lock(periodMutex_);
+    while (running_.load()) {
+        const int64_t periodStart = periodClock_->NextPeriodStart(ClockTime::GetCurNano());
+        const std::chrono::steady_clock::time_point deadline(
+            std::chrono::nanoseconds(periodClock_->TimeOfFrame(periodStart)));
+        if (periodCondition_.wait_until(lock, deadline, [this]() { return !running_.load(); })) {
+            break;
+        }
+        const size_t count = CollectPeriod(periodStart, std::numeric_limits<size_t>::max());
+        if (count == 0 || (protocol_ != MIDI_PROTOCOL_1_0 && protocol_ != MIDI_PROTOCOL_2_0)) {
+            continue;
+        }
+        // periodEvents_ is only touched by this thread in callback mode
+        lock.unlock();
+        periodCallback_(userData_, static_cast<uint64_t>(periodStart), periodEvents_.data(), count);
+        lock.lock();
+    }
+}
+
+size_t MidiInputPort::CollectPeriod(int64_t periodStart, size_t maxEvents)
+{
+    periodEvents_.clear();
+    periodWords_.clear();
+    // never grow the buffers reserved at open, what does not fit follows with the next period
+    maxEvents = std::min(maxEvents, periodEvents_.capacity());
+    MidiSharedRing::PeekedEvent peekedEvent{};
+    while (periodEvents_.size() < maxEvents && ringBuffer_->PeekNext(peekedEvent) == MidiStatusCode::OK) {
+        OH_MIDIPeriodEvent periodEvent{};
+        // events sit in the ring in arrival order, the first one of a later period ends the batch
+        if (!periodClock_->GetFrameOffset(static_cast<int64_t>(peekedEvent.timestamp), periodStart,
+            periodEvent.frameOffset)) {
+            break;
+        }
+        const size_t wordBegin = periodWords_.size();
+        if (wordBegin + peekedEvent.length > periodWords_.capacity()) {
+            if (wordBegin != 0) {
+                break;
+            }
+            // larger than any client ring event, it would block the port forever
+            MIDI_ERR_LOG("drop event of %{public}u words", peekedEvent.length);
+            ringBuffer_->CommitRead(peekedEvent);
+            continue;
+        }
+        periodEvent.event.timestamp = peekedEvent.timestamp;
+        periodEvent.event.length = peekedEvent.length;
+        periodEvent.event.data = periodWords_.data() + wordBegin;
+        periodWords_.resize(wordBegin + peekedEvent.length);
+        if (peekedEvent.length > 0) {
+            (void)memcpy_s(periodWords_.data() + wordBegin, peekedEvent.length * sizeof(uint32_t),
+                peekedEvent.payloadPtr, peekedEvent.length * sizeof(uint32_t));
+        }
+        periodEvents_.push_back(periodEvent);
+        ringBuffer_->CommitRead(peekedEvent);
+    }
+    return periodEvents_.size();
+}
+
+OH_MIDIStatusCode MidiInputPort::ReadEvents(OH_MIDIEvent *events, size_t capacity, size_t *eventCount)
+{
+    CHECK_AND_RETURN_RET_LOG(callback_ == nullptr && periodClock_ == nullptr && ringBuffer_ != nullptr,
+        OH_MIDI_STATUS_INVALID_PORT, "port is not read by the app");
+    // a port has a single reader, a concurrent call gets nothing instead of blocking the render thread
+    std::unique_lock<std::mutex> lock(readMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        *eventCount = 0;
+        return OH_MIDI_STATUS_OK;
+    }
+    // the events handed out last time pointed into the ring, their space is released only now
+    if (hasLastRead_) {
+        ringBuffer_->CommitRead(lastRead_);
+        hasLastRead_ = false;
+    }
+    size_t count = 0;
+    MidiSharedRing::PeekedEvent peekedEvent{};
+    MidiStatusCode status = ringBuffer_->PeekNext(peekedEvent);
+    while (count < capacity && status == MidiStatusCode::OK) {
+        events[count].timestamp = peekedEvent.timestamp;
+        events[count].length = peekedEvent.length;
+        events[count].data = reinterpret_cast<uint32_t *>(const_cast<uint8_t *>(peekedEvent.payloadPtr));
+        count++;
+        lastRead_ = peekedEvent;
+        hasLastRead_ = true;
+        if (count < capacity) {
+            status = ringBuffer_->PeekAfter(lastRead_, peekedEvent);
+        }
+    }
+    *eventCount = count;
+    return OH_MIDI_STATUS_OK;
+}
+
+bool MidiInputPort::IsPeriodic() const
+{
+    return periodClock_ != nullptr;
+}
+
+void MidiInputPort::SetPeriodClock(const Timestamp &reference)
+{
+    CHECK_AND_RETURN(periodClock_ != nullptr);
+    std::lock_guard<std::mutex> lock(periodMutex_);
+    periodClock_->SetReference(reference);
+}
+
+OH_MIDIStatusCode MidiInputPort::ReadPeriodEvents(int64_t periodFramePosition, OH_MIDIPeriodEvent *events,
+    size_t capacity, size_t *eventCount)
+{
+    CHECK_AND_RETURN_RET_LOG(periodClock_ != nullptr && periodCallback_ == nullptr && ringBuffer_ != nullptr,
+        OH_MIDI_STATUS_INVALID_PORT, "port is not read per period");
+    std::lock_guard<std::mutex> lock(periodMutex_);
+    if (!periodClock_->HasReference()) {
+        periodClock_->SetReference(MakeTimestamp(static_cast<uint64_t>(periodFramePosition),
+            static_cast<uint64_t>(ClockTime::GetCurNano())));
+    }
+    const size_t count = CollectPeriod(periodFramePosition, capacity);
+    std::copy_n(periodEvents_.begin(), count, events);
+    *eventCount = count;
+    return OH_MIDI_STATUS_OK;
+}
+
 MidiInputPort::~MidiInputPort()
 {
     (void)StopReceiverThread();
@@ -384,12 +815,17 @@ std::shared_ptr<MidiSharedRing> &MidiInputPort::GetRingBuffer()
     return ringBuffer_;
 }
 
+std::shared_ptr<MidiBroadcastRing> &MidiInputPort::GetBroadcastRing()
+{
+    return broadcastRing_;
+}
+
 MidiOutputPort::MidiOutputPort(OH_MIDIProtocol protocol) : protocol_(protocol)
 {
     MIDI_INFO_LOG("OutputPort created");
 }
 
-int32_t MidiOutputPort::Send(OH_MIDIEvent *events, uint32_t eventCount, uint32_t *eventsWritten)
+int32_t MidiOutputPort::Send(OH_MIDIEvent *events, uint32_t eventCount, uint32_t *eventsWritten, uint16_t tag)
 {
     CHECK_AND_RETURN_RET_LOG(events && eventsWritten, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
         "parameter is nullptr");
@@ -403,7 +839,7 @@ int32_t MidiOutputPort::Send(OH_MIDIEvent *events, uint32_t eventCount, uint32_t
     innerEvents.resize(eventCount);
 
     for (uint32_t i = 0; i < eventCount; ++i) {
-        innerEvents[i] = MidiEventInner{events[i].timestamp, events[i].length, events[i].data};
+        innerEvents[i] = MidiEventInner{events[i].timestamp, events[i].length, events[i].data, tag};
     }
     MIDI_DEBUG_LOG("[client] send midi events");
     MIDI_DEBUG_LOG("%{public}s", DumpMidiEvents(innerEvents).c_str());
@@ -500,6 +936,29 @@ std::shared_ptr<MidiSharedRing> &MidiOutputPort::GetRingBuffer()
     return ringBuffer_;
 }
 
+int32_t MidiOutputPort::AppendTimeline(OH_MIDIEvent *events, uint32_t eventCount, uint32_t *eventsWritten)
+{
+    CHECK_AND_RETURN_RET_LOG(events && eventsWritten, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "parameter is nullptr");
+    CHECK_AND_RETURN_RET_LOG(eventCount > 0 && eventCount <= MAX_EVENTS_NUMS, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "parameter is invalid");
+    CHECK_AND_RETURN_RET_LOG(timeline_ != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "timeline not opened");
+
+    thread_local std::vector<MidiEventInner> innerEvents;
+    innerEvents.clear();
+    innerEvents.resize(eventCount);
+    for (uint32_t i = 0; i < eventCount; ++i) {
+        innerEvents[i] = MidiEventInner{events[i].timestamp, events[i].length, events[i].data};
+    }
+    auto ret = timeline_->Append(innerEvents.data(), eventCount, eventsWritten);
+    return GetStatusCode(ret);
+}
+
+std::shared_ptr<MidiSharedTimeline> &MidiOutputPort::GetTimeline()
+{
+    return timeline_;
+}
+
 MidiOutputPort::~MidiOutputPort()
 {
     MIDI_INFO_LOG("OutputPort destroy");
@@ -135,6 +135,51 @@ OH_MIDIStatusCode MidiServiceClient::FlushOutputPort(int64_t deviceId, uint32_t
     return GetMidiStatusCode(ret);
 }
 
+OH_MIDIStatusCode MidiServiceClient::CancelScheduledEvents(int64_t deviceId, uint32_t portIndex, uint16_t tag,
+                                                           uint64_t beginTimestamp, uint64_t endTimestamp)
+{
+    std::lock_guard lock(lock_);
+    CHECK_AND_RETURN_RET_LOG(ipc_ != nullptr, OH_MIDI_STATUS_GENERIC_IPC_FAILURE, "ipc_ is NULL.");
+    auto ret = ipc_->CancelScheduledEvents(deviceId, portIndex, tag, beginTimestamp, endTimestamp);
+    return GetMidiStatusCode(ret);
+}
+
+OH_MIDIStatusCode MidiServiceClient::OpenOutputTimeline(std::shared_ptr<MidiSharedTimeline> &timeline,
+                                                        int64_t deviceId, uint32_t portIndex, uint32_t capacityBytes)
+{
+    std::lock_guard lock(lock_);
+    CHECK_AND_RETURN_RET_LOG(ipc_ != nullptr, OH_MIDI_STATUS_GENERIC_IPC_FAILURE, "ipc_ is NULL.");
+    auto ret = ipc_->OpenOutputTimeline(timeline, deviceId, portIndex, capacityBytes);
+    return GetMidiStatusCode(ret);
+}
+
+OH_MIDIStatusCode MidiServiceClient::SetOutputPortExclusive(int64_t deviceId, uint32_t portIndex, bool exclusive)
+{
+    std::lock_guard lock(lock_);
+    CHECK_AND_RETURN_RET_LOG(ipc_ != nullptr, OH_MIDI_STATUS_GENERIC_IPC_FAILURE, "ipc_ is NULL.");
+    auto ret = ipc_->SetOutputPortExclusive(deviceId, portIndex, exclusive);
+    return GetMidiStatusCode(ret);
+}
+
+OH_MIDIStatusCode MidiServiceClient::OpenInputPortBroadcast(std::shared_ptr<MidiBroadcastRing> &ring,
+                                                            int64_t deviceId, uint32_t portIndex)
+{
+    std::lock_guard lock(lock_);
+    CHECK_AND_RETURN_RET_LOG(ipc_ != nullptr, OH_MIDI_STATUS_GENERIC_IPC_FAILURE, "ipc_ is NULL.");
+    auto ret = ipc_->OpenInputPortBroadcast(ring, deviceId, portIndex);
+    return GetMidiStatusCode(ret);
+}
+
+OH_MIDIStatusCode MidiServiceClient::OpenInputPortWithFilter(std::shared_ptr<MidiSharedRing> &buffer,
+                                                             int64_t deviceId, uint32_t portIndex,
+                                                             const MidiInputFilter &filter)
+{
+    std::lock_guard lock(lock_);
+    CHECK_AND_RETURN_RET_LOG(ipc_ != nullptr, OH_MIDI_STATUS_GENERIC_IPC_FAILURE, "ipc_ is NULL.");
+    auto ret = ipc_->OpenInputPortWithFilter(buffer, deviceId, portIndex, filter);
+    return GetMidiStatusCode(ret);
+}
+
 OH_MIDIStatusCode MidiServiceClient::CloseInputPort(int64_t deviceId, uint32_t portIndex)
 {
     std::lock_guard lock(lock_);
@@ -97,7 +97,7 @@ public:
         time.tv_nsec = 0;
     }
     virtual ~Timestamp() = default;
-    uint32_t framePosition;
+    uint64_t framePosition;
     struct timespec time;
 
     /**
@@ -114,6 +114,40 @@ public:
     };
 };
 
+constexpr uint32_t MIDI_PERIOD_MAX_FRAMES = 16384;
+constexpr uint32_t MIDI_PERIOD_MIN_SAMPLE_RATE = 8000;
+constexpr uint32_t MIDI_PERIOD_MAX_SAMPLE_RATE = 384000;
+
+/**
+ * @brief Maps CLOCK_MONOTONIC times to frame positions of an audio stream and back.
+ * The stream is pinned by a reference Timestamp, the frame it played at a known time, periods start at
+ * multiples of framesPerPeriod. Events are placed one period late: an event that arrived during the period
+ * before periodStart keeps its distance to the start of that period as its frame offset.
+ */
+class MidiPeriodClock {
+public:
+    MidiPeriodClock(uint32_t framesPerPeriod, uint32_t sampleRate);
+    static bool IsValidConfig(uint32_t framesPerPeriod, uint32_t sampleRate);
+
+    uint32_t GetFramesPerPeriod() const { return framesPerPeriod_; }
+    bool HasReference() const { return hasReference_; }
+    void SetReference(const Timestamp &reference);
+
+    int64_t FrameAt(int64_t timeNs) const;
+    int64_t TimeOfFrame(int64_t framePosition) const;
+    // start of the first period beginning after timeNs
+    int64_t NextPeriodStart(int64_t timeNs) const;
+    // false if the event belongs to periodStart or later, late events get offset 0
+    bool GetFrameOffset(int64_t eventTimeNs, int64_t periodStart, uint32_t &frameOffset) const;
+
+private:
+    uint32_t framesPerPeriod_ = 0;
+    uint32_t sampleRate_ = 0;
+    int64_t referenceFrame_ = 0;
+    int64_t referenceTimeNs_ = 0;
+    bool hasReference_ = false;
+};
+
 class UniqueFd {
 public:
     UniqueFd() = default;
@@ -43,6 +43,16 @@ namespace {
     constexpr size_t HEAD_STR_LEN = 2;
     constexpr size_t TAIL_STR_LEN = 5;
     constexpr size_t WIDE_LEN = 2;
+
+    // rounds towards negative infinity, times before the reference map to earlier frames
+    int64_t FloorDiv(int64_t value, int64_t divisor)
+    {
+        int64_t quotient = value / divisor;
+        if ((value % divisor != 0) && (value < 0)) {
+            quotient--;
+        }
+        return quotient;
+    }
 } // namespace
 
 int64_t ClockTime::GetCurNano()
@@ -174,6 +184,61 @@ std::array<uint32_t, SYSEX7_WORD_COUNT> PackSysEx7Ump64(uint8_t group, uint8_t s
     return {w0, w1};
 }
 
+// ====== MidiPeriodClock ======
+MidiPeriodClock::MidiPeriodClock(uint32_t framesPerPeriod, uint32_t sampleRate)
+    : framesPerPeriod_(framesPerPeriod), sampleRate_(sampleRate)
+{}
+
+bool MidiPeriodClock::IsValidConfig(uint32_t framesPerPeriod, uint32_t sampleRate)
+{
+    return framesPerPeriod > 0 && framesPerPeriod <= MIDI_PERIOD_MAX_FRAMES &&
+        sampleRate >= MIDI_PERIOD_MIN_SAMPLE_RATE && sampleRate <= MIDI_PERIOD_MAX_SAMPLE_RATE;
+}
+
+void MidiPeriodClock::SetReference(const Timestamp &reference)
+{
+    referenceFrame_ = static_cast<int64_t>(reference.framePosition);
+    referenceTimeNs_ = static_cast<int64_t>(reference.time.tv_sec) * static_cast<int64_t>(MIDI_NS_PER_SECOND) +
+        reference.time.tv_nsec;
+    hasReference_ = true;
+}
+
+int64_t MidiPeriodClock::FrameAt(int64_t timeNs) const
+{
+    // split at whole seconds so the products stay far from overflowing
+    const int64_t nsPerSecond = static_cast<int64_t>(MIDI_NS_PER_SECOND);
+    const int64_t delta = timeNs - referenceTimeNs_;
+    const int64_t seconds = FloorDiv(delta, nsPerSecond);
+    const int64_t remainNs = delta - seconds * nsPerSecond;
+    return referenceFrame_ + seconds * sampleRate_ + remainNs * sampleRate_ / nsPerSecond;
+}
+
+int64_t MidiPeriodClock::TimeOfFrame(int64_t framePosition) const
+{
+    const int64_t nsPerSecond = static_cast<int64_t>(MIDI_NS_PER_SECOND);
+    const int64_t rate = static_cast<int64_t>(sampleRate_);
+    const int64_t delta = framePosition - referenceFrame_;
+    const int64_t seconds = FloorDiv(delta, rate);
+    const int64_t remainFrames = delta - seconds * rate;
+    // round up, FrameAt of the result is framePosition again
+    return referenceTimeNs_ + seconds * nsPerSecond + (remainFrames * nsPerSecond + rate - 1) / rate;
+}
+
+int64_t MidiPeriodClock::NextPeriodStart(int64_t timeNs) const
+{
+    const int64_t frames = static_cast<int64_t>(framesPerPeriod_);
+    return (FloorDiv(FrameAt(timeNs), frames) + 1) * frames;
+}
+
+bool MidiPeriodClock::GetFrameOffset(int64_t eventTimeNs, int64_t periodStart, uint32_t &frameOffset) const
+{
+    const int64_t frame = FrameAt(eventTimeNs);
+    CHECK_AND_RETURN_RET(frame < periodStart, false);
+    const int64_t offset = frame - (periodStart - static_cast<int64_t>(framesPerPeriod_));
+    frameOffset = offset > 0 ? static_cast<uint32_t>(offset) : 0;
+    return true;
+}
+
 // ====== UniqueFd ======
 UniqueFd::~UniqueFd()
 {
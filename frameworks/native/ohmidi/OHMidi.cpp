@@ -139,7 +139,8 @@ OH_MIDIStatusCode OH_MIDIDevice_OpenInputPort(
 {
     OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
     CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
-    CHECK_AND_RETURN_RET_LOG(callback != nullptr && userData != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+    // without a callback the port is read with OH_MIDIDevice_ReadEvents
+    CHECK_AND_RETURN_RET_LOG(callback == nullptr || userData != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
         "Invalid parameter");
 
     OH_MIDIStatusCode ret = midiDevice->OpenInputPort(descriptor, callback, userData);
@@ -147,6 +148,76 @@ OH_MIDIStatusCode OH_MIDIDevice_OpenInputPort(
     return OH_MIDI_STATUS_OK;
 }
 
+OH_MIDIStatusCode OH_MIDIDevice_OpenInputPortBroadcast(
+    OH_MIDIDevice *device, OH_MIDIPortDescriptor descriptor, OH_MIDIDevice_OnReceived callback, void *userData)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    CHECK_AND_RETURN_RET_LOG(callback != nullptr && userData != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "Invalid parameter");
+
+    OH_MIDIStatusCode ret = midiDevice->OpenInputPortBroadcast(descriptor, callback, userData);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "OpenInputPortBroadcast failed");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_OpenInputPortWithFilter(OH_MIDIDevice *device, OH_MIDIPortDescriptor descriptor,
+    const OH_MIDIInputFilter *filter, OH_MIDIDevice_OnReceived callback, void *userData)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    CHECK_AND_RETURN_RET_LOG(filter != nullptr && callback != nullptr && userData != nullptr,
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "Invalid parameter");
+
+    OH_MIDIStatusCode ret = midiDevice->OpenInputPortWithFilter(descriptor, *filter, callback, userData);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "OpenInputPortWithFilter failed");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_ReadEvents(OH_MIDIDevice *device, uint32_t portIndex, OH_MIDIEvent *events,
+    size_t capacity, size_t *eventCount)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    CHECK_AND_RETURN_RET_LOG(events != nullptr && eventCount != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "Invalid parameter");
+    // polled from the render thread, failures are left to the caller to report
+    return midiDevice->ReadEvents(portIndex, events, capacity, eventCount);
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_OpenInputPortPeriodic(OH_MIDIDevice *device, OH_MIDIPortDescriptor descriptor,
+    const OH_MIDIPeriodConfig *config, OH_MIDIDevice_OnPeriodReceived callback, void *userData)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    CHECK_AND_RETURN_RET_LOG(config != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "Invalid parameter");
+
+    OH_MIDIStatusCode ret = midiDevice->OpenInputPortPeriodic(descriptor, *config, callback, userData);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "OpenInputPortPeriodic failed");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_SetPeriodClock(OH_MIDIDevice *device, uint32_t portIndex,
+    uint64_t framePosition, uint64_t timestamp)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    OH_MIDIStatusCode ret = midiDevice->SetPeriodClock(portIndex, framePosition, timestamp);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "SetPeriodClock failed");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_ReadPeriodEvents(OH_MIDIDevice *device, uint32_t portIndex,
+    uint64_t periodFramePosition, OH_MIDIPeriodEvent *events, size_t capacity, size_t *eventCount)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    CHECK_AND_RETURN_RET_LOG(events != nullptr && eventCount != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "Invalid parameter");
+    // called once per audio period, failures are left to the caller to report
+    return midiDevice->ReadPeriodEvents(portIndex, periodFramePosition, events, capacity, eventCount);
+}
+
 OH_MIDIStatusCode OH_MIDIDevice_OpenOutputPort(OH_MIDIDevice *device, OH_MIDIPortDescriptor descriptor)
 {
     OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
@@ -197,6 +268,96 @@ OH_MIDIStatusCode OH_MIDIDevice_SendSysEx(OH_MIDIDevice *device, uint32_t portIn
     return OH_MIDI_STATUS_OK;
 }
 
+OH_MIDIStatusCode OH_MIDIDevice_SendTagged(OH_MIDIDevice *device, uint32_t portIndex, OH_MIDIEvent *events,
+    uint32_t eventCount, uint16_t tag, uint32_t *eventsWritten)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    OH_MIDIStatusCode ret = midiDevice->SendTagged(portIndex, events, eventCount, tag, eventsWritten);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "send tagged failed");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_CancelScheduledEvents(OH_MIDIDevice *device, uint32_t portIndex, uint16_t tag,
+    uint64_t beginTimestamp, uint64_t endTimestamp)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    OH_MIDIStatusCode ret = midiDevice->CancelScheduledEvents(portIndex, tag, beginTimestamp, endTimestamp);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "CancelScheduledEvents failed");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_OpenOutputTimeline(OH_MIDIDevice *device, uint32_t portIndex, uint32_t capacityBytes)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    OH_MIDIStatusCode ret = midiDevice->OpenOutputTimeline(portIndex, capacityBytes);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "OpenOutputTimeline failed");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_AppendTimeline(OH_MIDIDevice *device, uint32_t portIndex, OH_MIDIEvent *events,
+    uint32_t eventCount, uint32_t *eventsWritten)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    OH_MIDIStatusCode ret = midiDevice->AppendTimeline(portIndex, events, eventCount, eventsWritten);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "AppendTimeline failed");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_SetTimelineLoop(OH_MIDIDevice *device, uint32_t portIndex, uint64_t loopBegin,
+    uint64_t loopEnd)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    return midiDevice->SetTimelineLoop(portIndex, loopBegin, loopEnd);
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_StartTimeline(OH_MIDIDevice *device, uint32_t portIndex, uint64_t startTimestamp,
+    uint64_t startPosition)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    return midiDevice->StartTimeline(portIndex, startTimestamp, startPosition);
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_StopTimeline(OH_MIDIDevice *device, uint32_t portIndex)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    return midiDevice->StopTimeline(portIndex);
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_ClearTimeline(OH_MIDIDevice *device, uint32_t portIndex)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    return midiDevice->ClearTimeline(portIndex);
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_SetOutputPortExclusive(OH_MIDIDevice *device, uint32_t portIndex, bool exclusive)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    OH_MIDIStatusCode ret = midiDevice->SetOutputPortExclusive(portIndex, exclusive);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "SetOutputPortExclusive failed");
+    return OH_MIDI_STATUS_OK;
+}
+
+OH_MIDIStatusCode OH_MIDIDevice_SetPortNotifyModeration(OH_MIDIDevice *device, uint32_t portIndex,
+    OH_MIDIPortDirection direction, uint32_t maxPendingEvents, uint32_t maxDelayUs)
+{
+    OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
+    CHECK_AND_RETURN_RET_LOG(midiDevice != nullptr, OH_MIDI_STATUS_INVALID_DEVICE_HANDLE, "Invalid device");
+    CHECK_AND_RETURN_RET_LOG(direction == MIDI_PORT_DIRECTION_INPUT || direction == MIDI_PORT_DIRECTION_OUTPUT,
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "Invalid direction");
+    OH_MIDIStatusCode ret = midiDevice->SetPortNotifyModeration(portIndex, direction, maxPendingEvents, maxDelayUs);
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "SetPortNotifyModeration failed");
+    return OH_MIDI_STATUS_OK;
+}
+
 OH_MIDIStatusCode OH_MIDIDevice_FlushOutputPort(OH_MIDIDevice *device, uint32_t portIndex)
 {
     OHOS::MIDI::MidiDevice *midiDevice = (OHOS::MIDI::MidiDevice *)device;
@@ -25,6 +25,19 @@ public:
     virtual OH_MIDIStatusCode CloseDevice();
     virtual OH_MIDIStatusCode OpenInputPort(OH_MIDIPortDescriptor descriptor,
                                                 OH_MIDIDevice_OnReceived callback, void *userData);
+    virtual OH_MIDIStatusCode OpenInputPortBroadcast(OH_MIDIPortDescriptor descriptor,
+                                                     OH_MIDIDevice_OnReceived callback, void *userData);
+    virtual OH_MIDIStatusCode OpenInputPortWithFilter(OH_MIDIPortDescriptor descriptor,
+                                                      const OH_MIDIInputFilter &filter,
+                                                      OH_MIDIDevice_OnReceived callback, void *userData);
+    virtual OH_MIDIStatusCode ReadEvents(uint32_t portIndex, OH_MIDIEvent *events, size_t capacity,
+                                         size_t *eventCount);
+    virtual OH_MIDIStatusCode OpenInputPortPeriodic(OH_MIDIPortDescriptor descriptor,
+                                                    const OH_MIDIPeriodConfig &config,
+                                                    OH_MIDIDevice_OnPeriodReceived callback, void *userData);
+    virtual OH_MIDIStatusCode SetPeriodClock(uint32_t portIndex, uint64_t framePosition, uint64_t timestamp);
+    virtual OH_MIDIStatusCode ReadPeriodEvents(uint32_t portIndex, uint64_t periodFramePosition,
+                                               OH_MIDIPeriodEvent *events, size_t capacity, size_t *eventCount);
     virtual OH_MIDIStatusCode OpenOutputPort(OH_MIDIPortDescriptor descriptor);
     virtual OH_MIDIStatusCode CloseInputPort(uint32_t portIndex);
     virtual OH_MIDIStatusCode CloseOutputPort(uint32_t portIndex);
@@ -32,6 +45,20 @@ public:
                                     uint32_t eventCount, uint32_t *eventsWritten);
     virtual OH_MIDIStatusCode SendSysEx(uint32_t portIndex, uint8_t *data, uint32_t byteSize);
     virtual OH_MIDIStatusCode FlushOutputPort(uint32_t portIndex);
+    virtual OH_MIDIStatusCode SendTagged(uint32_t portIndex, OH_MIDIEvent *events, uint32_t eventCount,
+                                          uint16_t tag, uint32_t *eventsWritten);
+    virtual OH_MIDIStatusCode CancelScheduledEvents(uint32_t portIndex, uint16_t tag, uint64_t beginTimestamp,
+                                                     uint64_t endTimestamp);
+    virtual OH_MIDIStatusCode OpenOutputTimeline(uint32_t portIndex, uint32_t capacityBytes);
+    virtual OH_MIDIStatusCode AppendTimeline(uint32_t portIndex, OH_MIDIEvent *events, uint32_t eventCount,
+                                              uint32_t *eventsWritten);
+    virtual OH_MIDIStatusCode SetTimelineLoop(uint32_t portIndex, uint64_t loopBegin, uint64_t loopEnd);
+    virtual OH_MIDIStatusCode StartTimeline(uint32_t portIndex, uint64_t startTimestamp, uint64_t startPosition);
+    virtual OH_MIDIStatusCode StopTimeline(uint32_t portIndex);
+    virtual OH_MIDIStatusCode ClearTimeline(uint32_t portIndex);
+    virtual OH_MIDIStatusCode SetOutputPortExclusive(uint32_t portIndex, bool exclusive);
+    virtual OH_MIDIStatusCode SetPortNotifyModeration(uint32_t portIndex, OH_MIDIPortDirection direction,
+                                                       uint32_t maxPendingEvents, uint32_t maxDelayUs);
 };
 
 class MidiClient {
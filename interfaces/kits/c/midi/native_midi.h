@@ -241,6 +241,34 @@ OH_MIDIStatusCode OH_MIDIClient_GetPortInfos(OH_MIDIClient *client,
  * @brief Opens a MIDI input port (Receive data).
  *
  * Registers a callback to receive MIDI data in batches.
+ * Without a callback the port has no receiving thread, the application polls it with
+ * {@link #OH_MIDIDevice_ReadEvents}, e.g. at the top of each audio render cycle.
+ *
+ * @note Use {@link #OH_MIDIDevice_CloseInputPort} to close the input port.
+ *
+ * @param device Target device handle.
+ * @param descriptor Port index and protocol configuration.
+ * @param callback Callback function invoked when data is available, or NULL to read the events instead.
+ * @param userData Context pointer passed to the callback.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds.
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if the port is invalid or not an input port.
+ *     or {@link #OH_MIDI_STATUS_PORT_ALREADY_OPEN} if the port is already opened by this client.
+ *     or {@link #OH_MIDI_STATUS_TOO_MANY_OPEN_PORTS} if the maximum number of open ports has been reached.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if a callback is given without userData.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_IPC_FAILURE} if connection to system service fails.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_OpenInputPort(
+    OH_MIDIDevice *device, OH_MIDIPortDescriptor descriptor, OH_MIDIDevice_OnReceived callback, void *userData);
+
+/**
+ * @brief Opens a MIDI input port that shares one broadcast ring with the other listeners of the port.
+ *
+ * Behaves like {@link #OH_MIDIDevice_OpenInputPort}, but the service writes each input event once into a ring
+ * mapped read-only by every application that opened the port this way, instead of copying it per application.
+ * The service never waits for a slow reader: an application that falls more than a ring behind loses
+ * the oldest unread events.
  *
  * @note Use {@link #OH_MIDIDevice_CloseInputPort} to close the input port.
  *
@@ -257,9 +285,131 @@ OH_MIDIStatusCode OH_MIDIClient_GetPortInfos(OH_MIDIClient *client,
  *     or {@link #OH_MIDI_STATUS_GENERIC_IPC_FAILURE} if connection to system service fails.
  * @since 24
  */
-OH_MIDIStatusCode OH_MIDIDevice_OpenInputPort(
+OH_MIDIStatusCode OH_MIDIDevice_OpenInputPortBroadcast(
     OH_MIDIDevice *device, OH_MIDIPortDescriptor descriptor, OH_MIDIDevice_OnReceived callback, void *userData);
 
+/**
+ * @brief Opens a MIDI input port whose events are filtered by the service.
+ *
+ * Behaves like {@link #OH_MIDIDevice_OpenInputPort}, but messages matching the filter are dropped
+ * before they are written for the application, so they never wake its receiving thread.
+ * For example, dropping realtime messages removes timing clock and active sensing traffic.
+ * The filter applies to the first packet of each event and cannot be changed while the port is open.
+ *
+ * @note Use {@link #OH_MIDIDevice_CloseInputPort} to close the input port.
+ *
+ * @param device Target device handle.
+ * @param descriptor Port index and protocol configuration.
+ * @param filter Messages to drop, see {@link #OH_MIDIInputFilter}.
+ * @param callback Callback function invoked when data is available.
+ * @param userData Context pointer passed to the callback.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds.
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if the port is invalid or not an input port.
+ *     or {@link #OH_MIDI_STATUS_PORT_ALREADY_OPEN} if the port is already opened by this client.
+ *     or {@link #OH_MIDI_STATUS_TOO_MANY_OPEN_PORTS} if the maximum number of open ports has been reached.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if filter or callback is null.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_IPC_FAILURE} if connection to system service fails.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_OpenInputPortWithFilter(OH_MIDIDevice *device, OH_MIDIPortDescriptor descriptor,
+    const OH_MIDIInputFilter *filter, OH_MIDIDevice_OnReceived callback, void *userData);
+
+/**
+ * @brief Reads the events received on an input port, without blocking.
+ *
+ * The events are not copied, their data pointers point into the port buffer and stay valid
+ * until the next call for the port, which releases them. Events that do not fit into the buffer
+ * stay for the next call. The function neither blocks nor allocates memory, so it can be called
+ * from an audio render thread.
+ * Each port has a single reader: call it from one thread at a time, a call made while another one
+ * is still reading the same port returns no events.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target input port index, opened with {@link #OH_MIDIDevice_OpenInputPort} without a callback.
+ * @param events Buffer for the events.
+ * @param capacity Number of events the buffer holds.
+ * @param eventCount Returns the number of events read, 0 if none are pending.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if portIndex is invalid or the port delivers through a callback.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if events or eventCount is null.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_ReadEvents(OH_MIDIDevice *device, uint32_t portIndex, OH_MIDIEvent *events,
+    size_t capacity, size_t *eventCount);
+
+/**
+ * @brief Opens a MIDI input port whose events are delivered once per audio period.
+ *
+ * Events are collected per period of the audio stream and handed over with the frame of the period
+ * at which each should be rendered. An event that arrives during one period is rendered in the next one,
+ * at the same distance from the period start, so the timing between events is kept to the frame.
+ * With a callback the events arrive on a system thread right after each period starts. Without one
+ * the port has no thread and the audio thread reads them with {@link #OH_MIDIDevice_ReadPeriodEvents}.
+ * Periods follow the monotonic clock until {@link #OH_MIDIDevice_SetPeriodClock} ties them to the audio clock.
+ *
+ * @note Use {@link #OH_MIDIDevice_CloseInputPort} to close the input port.
+ *
+ * @param device Target device handle.
+ * @param descriptor Port index and protocol configuration.
+ * @param config Period size and sample rate of the audio stream.
+ * @param callback Callback invoked once per period that has events, or NULL to read the events instead.
+ * @param userData Context pointer passed to the callback.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds.
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if the port is invalid or not an input port.
+ *     or {@link #OH_MIDI_STATUS_PORT_ALREADY_OPEN} if the port is already opened by this client.
+ *     or {@link #OH_MIDI_STATUS_TOO_MANY_OPEN_PORTS} if the maximum number of open ports has been reached.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if config is null or out of range.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_IPC_FAILURE} if connection to system service fails.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_OpenInputPortPeriodic(OH_MIDIDevice *device, OH_MIDIPortDescriptor descriptor,
+    const OH_MIDIPeriodConfig *config, OH_MIDIDevice_OnPeriodReceived callback, void *userData);
+
+/**
+ * @brief Ties the periods of a periodic input port to the audio clock.
+ *
+ * Pass the frame position and time reported by the audio stream, e.g. by OH_AudioRenderer_GetTimestamp.
+ * Calling it again from time to time follows the drift between the audio and the monotonic clock.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target input port index, opened with {@link #OH_MIDIDevice_OpenInputPortPeriodic}.
+ * @param framePosition Frame position of the audio stream.
+ * @param timestamp Time at which framePosition was played (CLOCK_MONOTONIC, nanoseconds).
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if portIndex is invalid or the port is not periodic.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_SetPeriodClock(OH_MIDIDevice *device, uint32_t portIndex,
+    uint64_t framePosition, uint64_t timestamp);
+
+/**
+ * @brief Reads the events to render in one audio period, without blocking.
+ *
+ * Returns the events that arrived before the period starts, with their frame offsets in it.
+ * Events that do not fit into the buffer stay for the next call, a call returns at most 256 events.
+ * Unless {@link #OH_MIDIDevice_SetPeriodClock} was called first, the first call takes its period to start now.
+ * The data pointers of the events stay valid until the next call for the port.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target input port index, opened with {@link #OH_MIDIDevice_OpenInputPortPeriodic}
+ *     without a callback.
+ * @param periodFramePosition Frame position at which the period starts.
+ * @param events Buffer for the events.
+ * @param capacity Number of events the buffer holds.
+ * @param eventCount Returns the number of events read.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if portIndex is invalid or the port delivers through a callback.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if events or eventCount is null.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_ReadPeriodEvents(OH_MIDIDevice *device, uint32_t portIndex,
+    uint64_t periodFramePosition, OH_MIDIPeriodEvent *events, size_t capacity, size_t *eventCount);
+
 /**
  * @brief Opens a MIDI output port (Send data).
  *
@@ -380,6 +530,203 @@ OH_MIDIStatusCode OH_MIDIDevice_SendSysEx(OH_MIDIDevice *device, uint32_t portIn
  */
 OH_MIDIStatusCode OH_MIDIDevice_FlushOutputPort(OH_MIDIDevice *device, uint32_t portIndex);
 
+/**
+ * @brief Sends MIDI messages with a tag (Batch, Non-blocking & Atomic).
+ *
+ * Same as {@link OH_MIDIDevice_Send}, but every event in the array carries the tag, e.g. a clip or track id.
+ * Scheduled events with a tag can later be retracted with {@link OH_MIDIDevice_CancelScheduledEvents}
+ * without flushing the rest of the port.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target port index.
+ * @param events Pointer to the array of events to send.
+ * @param eventCount Number of events in the array.
+ * @param tag Tag of the events, 0 means untagged.
+ * @param eventsWritten Returns the number of events successfully consumed.
+ * @return {@link #OH_MIDI_STATUS_OK} if all events were written.
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if portIndex is invalid, or not open.
+ *     or {@link #OH_MIDI_STATUS_WOULD_BLOCK} if buffer is full (check eventsWritten).
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if arguments are invalid.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_IPC_FAILURE} if connection to system service fails.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_SendTagged(OH_MIDIDevice *device, uint32_t portIndex, OH_MIDIEvent *events,
+    uint32_t eventCount, uint16_t tag, uint32_t *eventsWritten);
+
+/**
+ * @brief Cancels scheduled messages that have not been sent yet.
+ *
+ * Discards the events of this client on the port whose timestamp lies in [beginTimestamp, endTimestamp]
+ * and whose tag matches. Events sent with timestamp 0 ("send immediately") are never cancelled.
+ * To cancel a whole clip pass its tag with the range [0, UINT64_MAX]; to cancel a time range regardless
+ * of tags pass tag 0.
+ *
+ * @note Like {@link OH_MIDIDevice_FlushOutputPort}, this does not send "Note Off" for notes already started.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target port index.
+ * @param tag Tag of the events to cancel, 0 matches every tag.
+ * @param beginTimestamp First timestamp to cancel in nanoseconds, inclusive.
+ * @param endTimestamp Last timestamp to cancel in nanoseconds, inclusive.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if portIndex invalid or not an output port.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if beginTimestamp is greater than endTimestamp.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_IPC_FAILURE} if connection to system service fails.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_CancelScheduledEvents(OH_MIDIDevice *device, uint32_t portIndex, uint16_t tag,
+    uint64_t beginTimestamp, uint64_t endTimestamp);
+
+/**
+ * @brief Opens a timeline on an output port for pre-scheduled sequences.
+ *
+ * A timeline is a shared buffer written once by the application and played by the system service,
+ * so long sequences and loops do not go through {@link OH_MIDIDevice_Send} again and again.
+ * Opening the timeline again with the same capacity returns the existing one.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target output port index, the port must be open.
+ * @param capacityBytes Size of the buffer; each event takes 16 bytes plus its payload.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if portIndex invalid or not an output port.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if capacityBytes is 0, too large,
+ *         or differs from an already opened timeline.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_IPC_FAILURE} if connection to system service fails.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_OpenOutputTimeline(OH_MIDIDevice *device, uint32_t portIndex, uint32_t capacityBytes);
+
+/**
+ * @brief Appends events to the timeline of an output port (Batch, Non-blocking).
+ *
+ * The timestamp of each event is its position in nanoseconds from the start of the timeline,
+ * positions must not decrease. Events may be appended while the timeline plays.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target port index.
+ * @param events Pointer to the array of events to append.
+ * @param eventCount Number of events in the array.
+ * @param eventsWritten Returns the number of events appended.
+ * @return {@link #OH_MIDI_STATUS_OK} if all events were appended.
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if portIndex is invalid, or not open.
+ *     or {@link #OH_MIDI_STATUS_WOULD_BLOCK} if the timeline is full (check eventsWritten).
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if the timeline is not opened or a position goes back.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_AppendTimeline(OH_MIDIDevice *device, uint32_t portIndex, OH_MIDIEvent *events,
+    uint32_t eventCount, uint32_t *eventsWritten);
+
+/**
+ * @brief Sets the loop region of the timeline.
+ *
+ * When playback reaches loopEnd it continues at loopBegin. Events of the loop region must be appended
+ * before playback reaches loopEnd. Pass loopBegin equal to loopEnd to play without a loop.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target port index.
+ * @param loopBegin Loop start position in nanoseconds, inclusive.
+ * @param loopEnd Loop end position in nanoseconds, exclusive.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if the timeline is not opened.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if loopBegin is greater than loopEnd.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_SetTimelineLoop(OH_MIDIDevice *device, uint32_t portIndex, uint64_t loopBegin,
+    uint64_t loopEnd);
+
+/**
+ * @brief Starts (or restarts) timeline playback.
+ *
+ * The event at startPosition plays at startTimestamp (CLOCK_MONOTONIC, nanoseconds), later events follow
+ * relative to it. Events already due are sent immediately.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target port index.
+ * @param startTimestamp Time at which startPosition plays.
+ * @param startPosition Timeline position in nanoseconds to start from.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if the timeline is not opened.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_IPC_FAILURE} if connection to system service fails.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_StartTimeline(OH_MIDIDevice *device, uint32_t portIndex, uint64_t startTimestamp,
+    uint64_t startPosition);
+
+/**
+ * @brief Stops timeline playback, the events stay in the timeline.
+ *
+ * @note Like {@link OH_MIDIDevice_FlushOutputPort}, this does not send "Note Off" for notes already started.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target port index.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if the timeline is not opened.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_StopTimeline(OH_MIDIDevice *device, uint32_t portIndex);
+
+/**
+ * @brief Stops playback and removes all events and the loop region from the timeline.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target port index.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if the timeline is not opened.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_ClearTimeline(OH_MIDIDevice *device, uint32_t portIndex);
+
+/**
+ * @brief Requests exclusive direct mode on an output port for the lowest output latency.
+ *
+ * While the application is the only one using the port, its messages are handed to the driver
+ * in the order they were sent, skipping the service's scheduling and fairness between applications.
+ * A scheduled message that is not due yet holds back the messages behind it, so timestamps should be
+ * in ascending order. When another application opens the port the service falls back to shared mode,
+ * and returns to direct mode once that application closes it.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target output port index, the port must be open.
+ * @param exclusive true to request direct mode, false to return to shared mode.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if portIndex invalid or not an output port.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_IPC_FAILURE} if connection to system service fails.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_SetOutputPortExclusive(OH_MIDIDevice *device, uint32_t portIndex, bool exclusive);
+
+/**
+ * @brief Sets how often the receiving side of a port is woken up for new messages.
+ *
+ * By default every write wakes the receiver. With moderation the wakeup is held back until
+ * maxPendingEvents messages are pending or the first of them has waited maxDelayUs, whichever comes first.
+ * A receiver that has gone idle and a port buffer that is filling up are still woken at once.
+ * Larger values save wakeups for bulk traffic, live playing is best served without moderation.
+ * Input ports opened with {@link OH_MIDIDevice_OpenInputPortBroadcast} cannot be moderated.
+ *
+ * @param device Target device handle.
+ * @param portIndex Target port index, the port must be open.
+ * @param direction Direction of the port.
+ * @param maxPendingEvents Messages that trigger a wakeup, 0 means only the delay applies.
+ * @param maxDelayUs Longest delay of a wakeup in microseconds, at most 100000. 0 turns moderation off.
+ * @return {@link #OH_MIDI_STATUS_OK} if execution succeeds,
+ *     or {@link #OH_MIDI_STATUS_INVALID_DEVICE_HANDLE} if device is invalid.
+ *     or {@link #OH_MIDI_STATUS_INVALID_PORT} if portIndex is invalid or the port cannot be moderated.
+ *     or {@link #OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT} if direction or maxDelayUs is invalid.
+ * @since 24
+ */
+OH_MIDIStatusCode OH_MIDIDevice_SetPortNotifyModeration(OH_MIDIDevice *device, uint32_t portIndex,
+    OH_MIDIPortDirection direction, uint32_t maxPendingEvents, uint32_t maxDelayUs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -444,6 +444,100 @@ typedef struct {
     OH_MIDIProtocol protocol;
 } OH_MIDIPortDescriptor;
 
+/**
+ * @brief Input filter evaluated by the service before events reach the application.
+ *
+ * Every field drops matching messages, a zero-initialized filter lets everything through.
+ * Dropped messages never wake the receiving thread of the application.
+ *
+ * @since 24
+ */
+typedef struct {
+    /**
+     * @brief Bit n drops UMP message type n.
+     *
+     * @since 24
+     */
+    uint16_t droppedMessageTypes;
+
+    /**
+     * @brief Bit n drops messages of group n, utility and stream messages carry no group.
+     *
+     * @since 24
+     */
+    uint16_t droppedGroups;
+
+    /**
+     * @brief Bit n drops channel voice messages (UMP type 2 and 4) on channel n.
+     *
+     * @since 24
+     */
+    uint16_t droppedChannels;
+
+    /**
+     * @brief Bit n drops channel voice messages whose status nibble is n, e.g. bit 0xB for control change.
+     *
+     * @since 24
+     */
+    uint16_t droppedChannelStatus;
+
+    /**
+     * @brief Bit n drops system common and realtime messages (UMP type 1) with status 0xF0 + n.
+     *
+     * @since 24
+     */
+    uint16_t droppedSystemStatus;
+
+    /**
+     * @brief Drops system realtime messages (status 0xF8 to 0xFF), such as timing clock and active sensing.
+     *
+     * @since 24
+     */
+    bool dropRealtime;
+} OH_MIDIInputFilter;
+
+/**
+ * @brief Audio period that input events are delivered against.
+ *
+ * @since 24
+ */
+typedef struct {
+    /**
+     * @brief Frames in one audio period, 1 to 16384.
+     *
+     * @since 24
+     */
+    uint32_t framesPerPeriod;
+
+    /**
+     * @brief Sample rate of the audio stream in Hz, 8000 to 384000.
+     *
+     * @since 24
+     */
+    uint32_t sampleRate;
+} OH_MIDIPeriodConfig;
+
+/**
+ * @brief MIDI event placed in an audio period.
+ *
+ * @since 24
+ */
+typedef struct {
+    /**
+     * @brief The event as received, timestamp and data as in {@link OH_MIDIEvent}.
+     *
+     * @since 24
+     */
+    OH_MIDIEvent event;
+
+    /**
+     * @brief Frame of the period at which the event should be rendered, below framesPerPeriod.
+     *
+     * @since 24
+     */
+    uint32_t frameOffset;
+} OH_MIDIPeriodEvent;
+
 /**
  * @brief Declares the MIDI client.
  *
@@ -491,6 +585,28 @@ typedef void (*OH_MIDICallback_OnDeviceChange)(
  */
 typedef void (*OH_MIDIDevice_OnReceived)(void *userData, const OH_MIDIEvent *events, size_t eventCount);
 
+/**
+ * @brief Callback for receiving the MIDI events of one audio period.
+ *
+ * Invoked at most once per period, right after the period starts, with the events that arrived
+ * during the period before it. At most 256 events are delivered per period, the rest follow
+ * with the next one.
+ *
+ * @warning The events array and all data pointers within are **ONLY valid during this callback**.
+ *
+ * @warning This callback is invoked on a high-priority system thread.
+ * Do **not** perform blocking operations, heavy computation, or I/O.
+ *
+ * @param userData User context provided during port opening.
+ * @param periodFramePosition Frame position at which the period starts.
+ * @param events Pointer to the array of events, in arrival order.
+ * @param eventCount The number of events in the array.
+ *
+ * @since 24
+ */
+typedef void (*OH_MIDIDevice_OnPeriodReceived)(void *userData, uint64_t periodFramePosition,
+    const OH_MIDIPeriodEvent *events, size_t eventCount);
+
 /**
  * @brief Callback for handling client-level errors.
  * Invoked when a critical error occurs in the MIDI service (e.g., service crash).
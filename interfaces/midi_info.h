@@ -112,6 +112,55 @@ struct MidiDeviceInfo : public Parcelable {
     }
 };
 
+// drop masks of OH_MIDIInputFilter, all zero lets every event through
+struct MidiInputFilter : public Parcelable {
+    uint16_t droppedMessageTypes = 0;
+    uint16_t droppedGroups = 0;
+    uint16_t droppedChannels = 0;
+    uint16_t droppedChannelStatus = 0;
+    uint16_t droppedSystemStatus = 0;
+    bool dropRealtime = false;
+
+    MidiInputFilter() = default;
+    explicit MidiInputFilter(const OH_MIDIInputFilter &filter)
+        : droppedMessageTypes(filter.droppedMessageTypes), droppedGroups(filter.droppedGroups),
+          droppedChannels(filter.droppedChannels), droppedChannelStatus(filter.droppedChannelStatus),
+          droppedSystemStatus(filter.droppedSystemStatus), dropRealtime(filter.dropRealtime)
+    {}
+
+    bool IsPassAll() const
+    {
+        return droppedMessageTypes == 0 && droppedGroups == 0 && droppedChannels == 0 &&
+            droppedChannelStatus == 0 && droppedSystemStatus == 0 && !dropRealtime;
+    }
+
+    bool Marshalling(Parcel &parcel) const override
+    {
+        parcel.WriteUint16(droppedMessageTypes);
+        parcel.WriteUint16(droppedGroups);
+        parcel.WriteUint16(droppedChannels);
+        parcel.WriteUint16(droppedChannelStatus);
+        parcel.WriteUint16(droppedSystemStatus);
+        parcel.WriteBool(dropRealtime);
+        return true;
+    }
+
+    static MidiInputFilter *Unmarshalling(Parcel &parcel)
+    {
+        auto filter = new(std::nothrow) MidiInputFilter();
+        if (filter == nullptr) {
+            return nullptr;
+        }
+        filter->droppedMessageTypes = parcel.ReadUint16();
+        filter->droppedGroups = parcel.ReadUint16();
+        filter->droppedChannels = parcel.ReadUint16();
+        filter->droppedChannelStatus = parcel.ReadUint16();
+        filter->droppedSystemStatus = parcel.ReadUint16();
+        filter->dropRealtime = parcel.ReadBool();
+        return filter;
+    }
+};
+
 enum DeviceChangeType {
     ADD = 0,
     REMOVED = 1,
@@ -143,11 +192,15 @@ struct MidiEvent {
     uint32_t *data;
 };
 
+// a cancel with this tag matches events of every tag
+constexpr uint16_t MIDI_EVENT_TAG_ANY = 0;
+
 // read only
 struct MidiEventInner {
     uint64_t timestamp;
     size_t length;
     const uint32_t *data;
+    uint16_t tag = 0; // scheduled output only, 0 means untagged
 };
 
 class MidiServiceCallback {
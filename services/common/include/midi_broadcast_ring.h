@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIDI_BROADCAST_RING_H
+#define MIDI_BROADCAST_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "futex_tool.h"
+#include "midi_info.h"
+#include "midi_shared_memory.h"
+
+namespace OHOS {
+namespace MIDI {
+
+constexpr uint32_t MIDI_BROADCAST_SLOT_WORDS = 4; // the largest UMP packet
+constexpr uint32_t MIDI_BROADCAST_DEFAULT_SLOTS = 256;
+constexpr uint32_t MIDI_BROADCAST_MAX_SLOTS = 4096;
+
+struct alignas(64) BroadcastHeader {
+    std::atomic<uint64_t> writeSequence; // events published so far
+    uint32_t slotCount;
+    std::atomic<uint32_t> wakeCount;     // futex word, bumped once per published batch
+};
+
+struct BroadcastSlot {
+    std::atomic<uint64_t> sequence; // 1 + sequence of the event held, 0 while the writer rewrites the slot
+    uint64_t timestamp;
+    uint32_t length;
+    uint32_t words[MIDI_BROADCAST_SLOT_WORDS];
+};
+
+/**
+ * @brief Input events of one port written once by the server and read by every client of the port.
+ * Events go into fixed slots indexed by sequence number, longer events are split at UMP packet boundaries.
+ * Each client keeps its own cursor in private memory and maps the region read-only, the writer never waits
+ * for readers: a reader that falls more than a ring behind skips forward and counts the lost events.
+ */
+class MidiBroadcastRing : public Parcelable {
+public:
+    MidiBroadcastRing(uint32_t slotCount, bool readOnly);
+    ~MidiBroadcastRing() = default;
+    MidiBroadcastRing(const MidiBroadcastRing &) = delete;
+    MidiBroadcastRing &operator=(const MidiBroadcastRing &) = delete;
+
+    static std::shared_ptr<MidiBroadcastRing> CreateFromLocal(uint32_t slotCount = MIDI_BROADCAST_DEFAULT_SLOTS);
+
+    // idl
+    bool Marshalling(Parcel &parcel) const override;
+    static MidiBroadcastRing *Unmarshalling(Parcel &parcel);
+
+    uint32_t GetSlotCount() const { return slotCount_; }
+    uint64_t GetWriteSequence() const;
+
+    // writer side, returns the number of slots used
+    uint32_t Publish(const MidiEventInner *events, size_t eventCount);
+
+    // reader side
+    struct Cursor {
+        uint64_t sequence = 0; // next event to read
+        uint64_t lost = 0;     // events overwritten before the reader got to them
+    };
+    // start reading at the next published event
+    void AttachCursor(Cursor &cursor) const;
+    bool HasEvents(const Cursor &cursor) const;
+    // copy out up to maxEvents (0 means all) and move the cursor
+    size_t Read(Cursor &cursor, std::vector<MidiEvent> &outEvents,
+        std::vector<std::vector<uint32_t>> &outPayloadBuffers, uint32_t maxEvents = 0) const;
+    // the futex word is only read here, so waiting works on the read-only mapping
+    FutexCode Wait(int64_t timeoutInNs, const std::function<bool(void)> &pred) const;
+    void WakeReaders() const;
+
+private:
+    int32_t Init(int dataFd);
+    BroadcastSlot *SlotAt(uint64_t sequence) const;
+    void WriteSlot(uint64_t sequence, uint64_t timestamp, const uint32_t *words, uint32_t length);
+
+    uint32_t slotCount_ = 0;
+    bool readOnly_ = false;
+    BroadcastHeader *header_ = nullptr;
+    BroadcastSlot *slots_ = nullptr;
+    std::shared_ptr<MidiSharedMemory> dataMem_ = nullptr;
+};
+} // namespace MIDI
+} // namespace OHOS
+#endif // MIDI_BROADCAST_RING_H
@@ -32,7 +32,12 @@ public:
     virtual std::string GetName() const = 0;
 
     static std::shared_ptr<MidiSharedMemory> CreateFromLocal(size_t size, const std::string &name);
-    static std::shared_ptr<MidiSharedMemory> CreateFromRemote(int fd, size_t size, const std::string &name);
+    static std::shared_ptr<MidiSharedMemory> CreateFromRemote(int fd, size_t size, const std::string &name,
+        bool readOnly = false);
+    // for regions that validate their own layout, size must stay below sizeLimit instead of the default limit
+    static std::shared_ptr<MidiSharedMemory> CreateFromLocal(size_t size, const std::string &name, size_t sizeLimit);
+    static std::shared_ptr<MidiSharedMemory> CreateFromRemote(int fd, size_t size, const std::string &name,
+        bool readOnly, size_t sizeLimit);
 
     bool Marshalling(Parcel &parcel) const override;
     static MidiSharedMemory *Unmarshalling(Parcel &parcel);
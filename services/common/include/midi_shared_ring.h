@@ -37,13 +37,32 @@ struct alignas(64) ControlHeader {        // 64 bytes for cache line
     uint32_t capacity;                    // ring data capacity
     std::atomic<uint32_t> futexObj;       // for futex
     uint32_t flags;                       // for expand
+    std::atomic<uint32_t> notifyMaxEvents;  // moderation: notify once this many events are pending
+    std::atomic<uint32_t> notifyMaxDelayUs; // moderation: longest an event waits for its notification, 0 is off
+    std::atomic<uint32_t> readerState;      // RingReaderState, kept by moderated and by epoll readers
+    std::atomic<uint32_t> spaceWaiters;     // writers in WaitForSpace, the reader wakes the futex only for them
+    std::atomic<uint32_t> writeMark;        // set on each write to an eventfd ring, cleared by the reader
 };
 
+// what the writer of a moderated ring may assume about the reader
+enum RingReaderState : uint32_t {
+    RING_READER_ACTIVE = 0,  // reading, or about to look at the ring before it sleeps
+    RING_READER_NAPPING = 1, // sleeping for at most notifyMaxDelayUs, then it looks again
+    RING_READER_IDLE = 2,    // sleeping until notified
+    RING_READER_POLLING = 3, // spinning over the ring, it finds the write mark without any notification
+};
+
+constexpr uint32_t MIDI_NOTIFY_MAX_DELAY_US = 100000;
+
 enum ShmEventFlags : uint32_t {
     SHM_EVENT_FLAG_NONE = 0,
     SHM_EVENT_FLAG_WRAP = 1u << 0,  // indicate wrap, length must be 0
+    SHM_EVENT_FLAG_CONSUMED = 1u << 1,  // consumed out of order by the reader, skipped on PeekNext
 };
 
+// the upper half of ShmMidiEventHeader::flags carries the event tag
+constexpr uint32_t SHM_EVENT_TAG_SHIFT = 16;
+
 struct ShmMidiEventHeader {
     uint64_t timestamp;
     uint32_t length;
@@ -81,6 +100,23 @@ public:
     FutexCode WaitFor(int64_t timeoutInNs, const std::function<bool(void)> &pred);
     FutexCode WaitForSpace(int64_t timeoutInNs, uint32_t neededBytes);
     void NotifyConsumer(uint32_t wakeVal = IS_READY);
+
+    // Notification moderation, kept in the header so either end may set it. The writer holds the notification
+    // back until maxPendingEvents are pending (0: no count limit) or the first of them waited maxDelayUs;
+    // an idle reader or a ring past its high watermark is notified at once. maxDelayUs 0 turns it off.
+    void SetNotifyModeration(uint32_t maxPendingEvents, uint32_t maxDelayUs);
+    int64_t GetNotifyDelayNs() const; // 0 when moderation is off
+    // writer side: eventCount events were written, notify the reader unless moderation holds it back
+    void NotifyWritten(uint32_t eventCount);
+    // reader side of a moderated ring, WaitFor keeps it up to date for futex readers
+    void SetReaderState(RingReaderState state);
+    // Reader side of an eventfd ring. While the reader is active the writer skips the eventfd write, so the reader
+    // has to call MarkReaderSleeping before each wait and must not sleep when it returns true.
+    void MarkReaderActive();
+    bool MarkReaderSleeping(RingReaderState state);
+    // busy polling reader of an eventfd ring: the writer only leaves its mark, TakeWriteMark picks it up
+    void MarkReaderPolling();
+    bool TakeWriteMark();
     bool IsEmpty() const;
     ControlHeader *GetControlHeader() const;
     MidiStatusCode TryWriteEvents(
@@ -93,20 +129,31 @@ public:
 
         uint64_t timestamp = 0;
         uint32_t length = 0;
+        uint16_t tag = 0;
         uint32_t beginOffset = 0;  // header
         uint32_t endOffset = 0;    // header + payload range[0, capacity]
     };
 
     MidiStatusCode PeekNext(PeekedEvent &outEvent);
+    // peek the event behind prevEvent without moving the read position, consumed events are skipped
+    MidiStatusCode PeekAfter(const PeekedEvent &prevEvent, PeekedEvent &outEvent);
 
     void CommitRead(const PeekedEvent &event);
+    // consume an event behind the read position, its space is released once the read position reaches it
+    void MarkConsumed(const PeekedEvent &event);
+    // reader side: where a PeekAfter scan behind the read position stopped, forgotten once the read position moves
+    void SetScanPosition(const PeekedEvent &event);
+    bool GetScanPosition(PeekedEvent &outEvent) const;
     void DrainToBatch(std::vector<MidiEvent> &outEvents, std::vector<std::vector<uint32_t>> &outPayloadBuffers,
         uint32_t maxEvents = 0);
     void Flush();
 
 private:
     bool ValidateOneEvent(const MidiEventInner &event) const;
+    bool HasEventFd() const;
     void WakeFutex(uint32_t wakeVal = IS_READY);
+    bool IsNotifyDue(int64_t now) const;
+    void NotifyNow();
     void WriteEvent(uint32_t writeIndex, const MidiEventInner &event);
     MidiStatusCode ValidateWriteArgs(const MidiEventInner *events, uint32_t eventCount) const;
     MidiStatusCode TryWriteOneEvent(
@@ -124,6 +171,12 @@ private:
     uint32_t totalMemorySize_{0};
     mutable std::shared_ptr<MidiSharedMemory> dataMem_ = nullptr;
     std::shared_ptr<UniqueFd> notifyFd_;
+    // scan position of the reader, local to this mapping
+    PeekedEvent scanEvent_{};
+    bool scanValid_{false};
+    // moderation state of the writer
+    uint32_t pendingNotify_{0};
+    int64_t firstPendingNs_{0};
 };
 }  // namespace MIDI
 }  // namespace OHOS
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIDI_SHARED_TIMELINE_H
+#define MIDI_SHARED_TIMELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "midi_info.h"
+#include "midi_shared_memory.h"
+#include "midi_shared_ring.h"
+
+namespace OHOS {
+namespace MIDI {
+
+constexpr uint32_t MIDI_TIMELINE_MAX_CAPACITY = 0x3FF000; // just under 4 MiB with the header
+
+struct alignas(64) TimelineHeader {
+    std::atomic<uint32_t> writePosition;  // bytes of published events
+    uint32_t capacity;                    // event area capacity
+    std::atomic<uint32_t> generation;     // bumped by Start and Clear, the reader rewinds on change
+    std::atomic<uint32_t> playing;        // 0: stopped
+    std::atomic<uint64_t> startTimestamp; // CLOCK_MONOTONIC ns at which startPosition plays
+    std::atomic<uint64_t> startPosition;  // ns
+    std::atomic<uint64_t> loopBegin;      // ns
+    std::atomic<uint64_t> loopEnd;        // ns, loopEnd <= loopBegin means no loop
+};
+
+/**
+ * @brief Pre-scheduled output written once by the client and played by the server with a cursor.
+ * Events are laid out like ring events (ShmMidiEventHeader + payload) but never wrap or get consumed,
+ * ShmMidiEventHeader::timestamp holds the position in ns from the start of the timeline, in ascending order.
+ * The client appends and controls playback, the server only reads; the loop region must be written
+ * before playback reaches its end.
+ */
+class MidiSharedTimeline : public Parcelable {
+public:
+    explicit MidiSharedTimeline(uint32_t capacityBytes);
+    MidiSharedTimeline(uint32_t capacityBytes, std::shared_ptr<UniqueFd> notifyFd);
+    ~MidiSharedTimeline() = default;
+    MidiSharedTimeline(const MidiSharedTimeline &) = delete;
+    MidiSharedTimeline &operator=(const MidiSharedTimeline &) = delete;
+
+    static std::shared_ptr<MidiSharedTimeline> CreateFromLocal(uint32_t capacityBytes,
+        std::shared_ptr<UniqueFd> notifyFd = nullptr);
+
+    // idl
+    bool Marshalling(Parcel &parcel) const override;
+    static MidiSharedTimeline *Unmarshalling(Parcel &parcel);
+
+    uint32_t GetCapacity() const { return capacity_; }
+
+    // writer side
+    // event.timestamp is the position, it must not go below the last appended one
+    MidiStatusCode Append(const MidiEventInner *events, uint32_t eventCount, uint32_t *eventsWritten);
+    void SetLoop(uint64_t loopBegin, uint64_t loopEnd);
+    void Start(uint64_t startTimestamp, uint64_t startPosition);
+    void Stop();
+    void Clear();
+
+    // reader side
+    struct Cursor {
+        uint32_t generation = 0;
+        uint32_t offset = 0;
+        int64_t baseTimestamp = 0; // due time of position 0 in the current pass
+        bool valid = false;
+        // offset of the first event at or after loopBegin, kept while the generation and loop begin stay
+        uint64_t loopBegin = 0;
+        uint32_t loopOffset = 0;
+        bool loopValid = false;
+    };
+    // next event of a playing timeline and its due time in CLOCK_MONOTONIC ns, the cursor is not moved
+    bool PeekNext(Cursor &cursor, MidiSharedRing::PeekedEvent &outEvent, uint64_t &outDueTimestamp) const;
+    void Advance(Cursor &cursor, const MidiSharedRing::PeekedEvent &event) const;
+
+private:
+    int32_t Init(int dataFd);
+    bool ReadAt(uint32_t offset, uint32_t writePosition, MidiSharedRing::PeekedEvent &outEvent) const;
+    uint32_t Seek(uint64_t position, uint32_t writePosition) const;
+    void Rewind(Cursor &cursor, uint32_t generation, uint32_t writePosition) const;
+    uint32_t GetLoopOffset(Cursor &cursor, uint64_t loopBegin, uint32_t writePosition) const;
+    void Notify();
+
+    uint32_t capacity_ = 0;
+    uint64_t lastPosition_ = 0; // writer only
+    TimelineHeader *header_ = nullptr;
+    uint8_t *eventBase_ = nullptr;
+    std::shared_ptr<MidiSharedMemory> dataMem_ = nullptr;
+    std::shared_ptr<UniqueFd> notifyFd_;
+};
+} // namespace MIDI
+} // namespace OHOS
+#endif // MIDI_SHARED_TIMELINE_H
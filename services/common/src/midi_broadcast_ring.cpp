@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LOG_TAG
+#define LOG_TAG "MidiBroadcastRing"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "ashmem.h"
+#include "message_parcel.h"
+#include "midi_log.h"
+#include "midi_broadcast_ring.h"
+#include "native_midi_base.h"
+
+namespace OHOS {
+namespace MIDI {
+namespace {
+constexpr int INVALID_FD = -1;
+constexpr int MINFD = 2; // ignore stdout, stdin and stderr.
+constexpr size_t BROADCAST_MEMORY_LIMIT = 0x40000;
+static_assert(sizeof(BroadcastHeader) + sizeof(BroadcastSlot) * MIDI_BROADCAST_MAX_SLOTS < BROADCAST_MEMORY_LIMIT,
+    "broadcast ring too large");
+constexpr uint32_t UMP_MT_SHIFT = 28;
+constexpr uint32_t NIBBLE_MASK = 0xF;
+constexpr int64_t SEC_TO_NANOSEC = 1000000000;
+// packet size in words, indexed by message type
+constexpr uint32_t UMP_WORDS_BY_TYPE[] = {1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4};
+
+long FutexSyscall(const std::atomic<uint32_t> *futexPtr, int op, uint32_t val, const struct timespec *timeout)
+{
+    return syscall(__NR_futex, futexPtr, op, val, timeout, nullptr, 0);
+}
+
+// words of the UMP packets starting at data that fit in one slot, at least one word
+uint32_t ChunkWords(const uint32_t *data, uint32_t remaining)
+{
+    uint32_t words = 0;
+    while (words < remaining) {
+        const uint32_t packetWords = UMP_WORDS_BY_TYPE[(data[words] >> UMP_MT_SHIFT) & NIBBLE_MASK];
+        if (words + packetWords > MIDI_BROADCAST_SLOT_WORDS) {
+            break;
+        }
+        words += packetWords;
+    }
+    if (words == 0) {
+        return std::min(remaining, MIDI_BROADCAST_SLOT_WORDS);
+    }
+    return std::min(words, remaining);
+}
+} // namespace
+
+MidiBroadcastRing::MidiBroadcastRing(uint32_t slotCount, bool readOnly) : slotCount_(slotCount), readOnly_(readOnly)
+{}
+
+int32_t MidiBroadcastRing::Init(int dataFd)
+{
+    CHECK_AND_RETURN_RET_LOG(slotCount_ > 0 && slotCount_ <= MIDI_BROADCAST_MAX_SLOTS,
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "invalid slot count %{public}u", slotCount_);
+    const size_t totalMemorySize = sizeof(BroadcastHeader) + sizeof(BroadcastSlot) * slotCount_;
+    if (dataFd == INVALID_FD) {
+        dataMem_ = MidiSharedMemory::CreateFromLocal(totalMemorySize, "midi_broadcast_ring", BROADCAST_MEMORY_LIMIT);
+    } else {
+        dataMem_ = MidiSharedMemory::CreateFromRemote(dataFd, totalMemorySize, "midi_broadcast_ring", readOnly_,
+            BROADCAST_MEMORY_LIMIT);
+    }
+    CHECK_AND_RETURN_RET_LOG(dataMem_ != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "dataMem_ is nullptr.");
+    header_ = reinterpret_cast<BroadcastHeader *>(dataMem_->GetBase());
+    slots_ = reinterpret_cast<BroadcastSlot *>(dataMem_->GetBase() + sizeof(BroadcastHeader));
+    if (dataFd == INVALID_FD) {
+        header_->writeSequence.store(0);
+        header_->slotCount = slotCount_;
+        header_->wakeCount.store(0);
+        for (uint32_t i = 0; i < slotCount_; i++) {
+            slots_[i].sequence.store(0);
+        }
+        // later mappings of the fd, i.e. the clients', can only read
+        (void)AshmemSetProt(dataMem_->GetFd(), PROT_READ);
+    }
+    CHECK_AND_RETURN_RET_LOG(header_->slotCount == slotCount_, OH_MIDI_STATUS_SYSTEM_ERROR,
+        "slot count mismatch %{public}u", header_->slotCount);
+    return OH_MIDI_STATUS_OK;
+}
+
+std::shared_ptr<MidiBroadcastRing> MidiBroadcastRing::CreateFromLocal(uint32_t slotCount)
+{
+    auto ring = std::make_shared<MidiBroadcastRing>(slotCount, false);
+    CHECK_AND_RETURN_RET_LOG(ring->Init(INVALID_FD) == OH_MIDI_STATUS_OK, nullptr, "failed to init.");
+    return ring;
+}
+
+bool MidiBroadcastRing::Marshalling(Parcel &parcel) const
+{
+    MessageParcel &messageParcel = static_cast<MessageParcel &>(parcel);
+    CHECK_AND_RETURN_RET_LOG(dataMem_ != nullptr, false, "dataMem_ is nullptr.");
+    return messageParcel.WriteUint32(slotCount_) && messageParcel.WriteFileDescriptor(dataMem_->GetFd());
+}
+
+MidiBroadcastRing *MidiBroadcastRing::Unmarshalling(Parcel &parcel)
+{
+    MessageParcel &messageParcel = static_cast<MessageParcel &>(parcel);
+    uint32_t slotCount = messageParcel.ReadUint32();
+    int dataFd = messageParcel.ReadFileDescriptor();
+    CHECK_AND_RETURN_RET_LOG(dataFd > MINFD, nullptr, "invalid dataFd: %{public}d", dataFd);
+
+    auto ring = new (std::nothrow) MidiBroadcastRing(slotCount, true);
+    if (ring == nullptr || ring->Init(dataFd) != OH_MIDI_STATUS_OK) {
+        MIDI_ERR_LOG("failed to init.");
+        delete ring;
+        CloseFd(dataFd);
+        return nullptr;
+    }
+    CloseFd(dataFd);
+    return ring;
+}
+
+uint64_t MidiBroadcastRing::GetWriteSequence() const
+{
+    CHECK_AND_RETURN_RET(header_ != nullptr, 0);
+    return header_->writeSequence.load(std::memory_order_acquire);
+}
+
+BroadcastSlot *MidiBroadcastRing::SlotAt(uint64_t sequence) const
+{
+    return &slots_[sequence % slotCount_];
+}
+
+//==================== Write Side ====================//
+
+void MidiBroadcastRing::WriteSlot(uint64_t sequence, uint64_t timestamp, const uint32_t *words, uint32_t length)
+{
+    BroadcastSlot *slot = SlotAt(sequence);
+    // seqlock: readers that see the slot change while copying drop what they read
+    slot->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->timestamp = timestamp;
+    slot->length = length;
+    std::copy(words, words + length, slot->words);
+    slot->sequence.store(sequence + 1, std::memory_order_release);
+}
+
+uint32_t MidiBroadcastRing::Publish(const MidiEventInner *events, size_t eventCount)
+{
+    CHECK_AND_RETURN_RET(header_ != nullptr && !readOnly_ && events != nullptr, 0);
+    uint64_t sequence = header_->writeSequence.load(std::memory_order_relaxed);
+    const uint64_t firstSequence = sequence;
+    for (size_t i = 0; i < eventCount; i++) {
+        const MidiEventInner &event = events[i];
+        CHECK_AND_CONTINUE(event.data != nullptr && event.length > 0);
+        uint32_t offset = 0;
+        const uint32_t length = static_cast<uint32_t>(event.length);
+        while (offset < length) {
+            const uint32_t chunk = ChunkWords(event.data + offset, length - offset);
+            WriteSlot(sequence, event.timestamp, event.data + offset, chunk);
+            offset += chunk;
+            sequence++;
+        }
+    }
+    CHECK_AND_RETURN_RET(sequence != firstSequence, 0);
+    header_->writeSequence.store(sequence, std::memory_order_release);
+    header_->wakeCount.fetch_add(1, std::memory_order_release);
+    WakeReaders();
+    return static_cast<uint32_t>(sequence - firstSequence);
+}
+
+//==================== Read Side ====================//
+
+void MidiBroadcastRing::AttachCursor(Cursor &cursor) const
+{
+    cursor.sequence = GetWriteSequence();
+    cursor.lost = 0;
+}
+
+bool MidiBroadcastRing::HasEvents(const Cursor &cursor) const
+{
+    return GetWriteSequence() != cursor.sequence;
+}
+
+size_t MidiBroadcastRing::Read(Cursor &cursor, std::vector<MidiEvent> &outEvents,
+    std::vector<std::vector<uint32_t>> &outPayloadBuffers, uint32_t maxEvents) const
+{
+    CHECK_AND_RETURN_RET(header_ != nullptr, 0);
+    size_t count = 0;
+    uint64_t writeSequence = GetWriteSequence();
+    while (cursor.sequence < writeSequence && (maxEvents == 0 || count < maxEvents)) {
+        if (writeSequence - cursor.sequence > slotCount_) {
+            // lapped by the writer, the oldest slots already hold newer events
+            cursor.lost += writeSequence - slotCount_ - cursor.sequence;
+            cursor.sequence = writeSequence - slotCount_;
+        }
+        const BroadcastSlot *slot = SlotAt(cursor.sequence);
+        const uint64_t before = slot->sequence.load(std::memory_order_acquire);
+        uint32_t length = std::min(slot->length, MIDI_BROADCAST_SLOT_WORDS);
+        const uint64_t timestamp = slot->timestamp;
+        std::vector<uint32_t> payload(slot->words, slot->words + length);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (before != cursor.sequence + 1 || slot->sequence.load(std::memory_order_relaxed) != before) {
+            // rewritten for a later lap while we looked at it
+            cursor.lost++;
+            cursor.sequence++;
+            writeSequence = GetWriteSequence();
+            continue;
+        }
+        MidiEvent event{};
+        event.timestamp = timestamp;
+        event.length = length;
+        outPayloadBuffers.push_back(std::move(payload));
+        event.data = outPayloadBuffers.back().data();
+        outEvents.push_back(event);
+        cursor.sequence++;
+        count++;
+    }
+    return count;
+}
+
+FutexCode MidiBroadcastRing::Wait(int64_t timeoutInNs, const std::function<bool(void)> &pred) const
+{
+    CHECK_AND_RETURN_RET_LOG(header_ != nullptr && pred, FUTEX_INVALID_PARAMS, "invalid params");
+    struct timespec waitTime {};
+    if (timeoutInNs > 0) {
+        waitTime.tv_sec = timeoutInNs / SEC_TO_NANOSEC;
+        waitTime.tv_nsec = timeoutInNs % SEC_TO_NANOSEC;
+    }
+    while (true) {
+        const uint32_t observed = header_->wakeCount.load(std::memory_order_acquire);
+        if (pred()) {
+            return FUTEX_SUCCESS;
+        }
+        long res = FutexSyscall(&header_->wakeCount, FUTEX_WAIT, observed, timeoutInNs > 0 ? &waitTime : nullptr);
+        if (res != 0 && errno == ETIMEDOUT) {
+            return pred() ? FUTEX_SUCCESS : FUTEX_TIMEOUT;
+        }
+        CHECK_AND_RETURN_RET_LOG(res == 0 || errno == EAGAIN || errno == EINTR, FUTEX_OPERATION_FAILED,
+            "futex wait failed, errno %{public}d", errno);
+    }
+}
+
+void MidiBroadcastRing::WakeReaders() const
+{
+    CHECK_AND_RETURN(header_ != nullptr);
+    (void)FutexSyscall(&header_->wakeCount, FUTEX_WAKE, INT_MAX, nullptr);
+}
+} // namespace MIDI
+} // namespace OHOS
@@ -18,6 +18,7 @@
 #endif
 
 #include "ashmem.h"
+#include <algorithm>
 #include <cerrno>
 #include <cinttypes>
 #include <climits>
@@ -34,6 +35,7 @@
 #include "message_parcel.h"
 #include "midi_log.h"
 #include "midi_shared_ring.h"
+#include "midi_utils.h"
 #include "native_midi_base.h"
 
 namespace OHOS {
@@ -42,6 +44,9 @@ namespace {
 const uint32_t MAX_MMAP_BUFFER_SIZE = 0x2000;
 static constexpr int INVALID_FD = -1;
 static constexpr int MINFD = 2;
+constexpr uint32_t NOTIFY_HIGH_WATERMARK_PERCENT = 75; // a moderated ring this full notifies at once
+constexpr uint32_t PERCENT = 100;
+constexpr int64_t NS_PER_US = 1000;
 } // namespace
 
 class MidiSharedMemoryImpl : public MidiSharedMemory {
@@ -51,9 +56,10 @@ public:
     int GetFd() const override;
     std::string GetName() const override;
 
-    MidiSharedMemoryImpl(size_t size, const std::string &name);
+    MidiSharedMemoryImpl(size_t size, const std::string &name, size_t sizeLimit = MAX_MMAP_BUFFER_SIZE);
 
-    MidiSharedMemoryImpl(int fd, size_t size, const std::string &name);
+    MidiSharedMemoryImpl(int fd, size_t size, const std::string &name, bool readOnly = false,
+        size_t sizeLimit = MAX_MMAP_BUFFER_SIZE);
 
     ~MidiSharedMemoryImpl();
 
@@ -68,6 +74,8 @@ private:
     int fd_;
     size_t size_;
     std::string name_;
+    bool readOnly_ = false;
+    size_t sizeLimit_ = MAX_MMAP_BUFFER_SIZE;
 };
 
 class ScopedFd {
@@ -84,14 +92,15 @@ private:
     int fd_ = -1;
 };
 
-MidiSharedMemoryImpl::MidiSharedMemoryImpl(size_t size, const std::string &name)
-    : base_(nullptr), fd_(INVALID_FD), size_(size), name_(name)
+MidiSharedMemoryImpl::MidiSharedMemoryImpl(size_t size, const std::string &name, size_t sizeLimit)
+    : base_(nullptr), fd_(INVALID_FD), size_(size), name_(name), sizeLimit_(sizeLimit)
 {
     MIDI_DEBUG_LOG("MidiSharedMemory ctor with size: %{public}zu name: %{public}s", size_, name_.c_str());
 }
 
-MidiSharedMemoryImpl::MidiSharedMemoryImpl(int fd, size_t size, const std::string &name)
-    : base_(nullptr), fd_(dup(fd)), size_(size), name_(name)
+MidiSharedMemoryImpl::MidiSharedMemoryImpl(int fd, size_t size, const std::string &name, bool readOnly,
+    size_t sizeLimit)
+    : base_(nullptr), fd_(dup(fd)), size_(size), name_(name), readOnly_(readOnly), sizeLimit_(sizeLimit)
 {
     MIDI_DEBUG_LOG("MidiSharedMemory ctor with fd %{public}d size %{public}zu name %{public}s", fd_, size_,
                    name_.c_str());
@@ -105,7 +114,7 @@ MidiSharedMemoryImpl::~MidiSharedMemoryImpl()
 
 int32_t MidiSharedMemoryImpl::Init()
 {
-    CHECK_AND_RETURN_RET_LOG((size_ > 0 && size_ < MAX_MMAP_BUFFER_SIZE), OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+    CHECK_AND_RETURN_RET_LOG((size_ > 0 && size_ < sizeLimit_), OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
                              "Init falied: size out of range: %{public}zu", size_);
     bool isFromRemote = false;
     if (fd_ >= 0) {
@@ -125,7 +134,8 @@ int32_t MidiSharedMemoryImpl::Init()
         CHECK_AND_RETURN_RET_LOG((fd_ >= 0), OH_MIDI_STATUS_SYSTEM_ERROR, "Init falied: fd %{public}d", fd_);
     }
 
-    void *addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    const int prot = readOnly_ ? PROT_READ : (PROT_READ | PROT_WRITE);
+    void *addr = mmap(nullptr, size_, prot, MAP_SHARED, fd_, 0);
     CHECK_AND_RETURN_RET_LOG(addr != MAP_FAILED, OH_MIDI_STATUS_SYSTEM_ERROR,
                              "Init falied: fd %{public}d size %{public}zu", fd_, size_);
     base_ = static_cast<uint8_t *>(addr);
@@ -137,7 +147,7 @@ bool MidiSharedMemoryImpl::Marshalling(Parcel &parcel) const
 {
     // Parcel -> MessageParcel
     MessageParcel &msgParcel = static_cast<MessageParcel &>(parcel);
-    CHECK_AND_RETURN_RET_LOG((size_ > 0 && size_ < MAX_MMAP_BUFFER_SIZE), false, "invalid size: %{public}zu", size_);
+    CHECK_AND_RETURN_RET_LOG((size_ > 0 && size_ < sizeLimit_), false, "invalid size: %{public}zu", size_);
     return msgParcel.WriteFileDescriptor(fd_) && msgParcel.WriteUint64(static_cast<uint64_t>(size_)) &&
            msgParcel.WriteString(name_);
 }
@@ -168,16 +178,31 @@ int MidiSharedMemoryImpl::GetFd() const { return fd_; }
 
 std::shared_ptr<MidiSharedMemory> MidiSharedMemory::CreateFromLocal(size_t size, const std::string &name)
 {
-    std::shared_ptr<MidiSharedMemoryImpl> sharedMemory = std::make_shared<MidiSharedMemoryImpl>(size, name);
+    return CreateFromLocal(size, name, MAX_MMAP_BUFFER_SIZE);
+}
+
+std::shared_ptr<MidiSharedMemory> MidiSharedMemory::CreateFromLocal(size_t size, const std::string &name,
+    size_t sizeLimit)
+{
+    std::shared_ptr<MidiSharedMemoryImpl> sharedMemory = std::make_shared<MidiSharedMemoryImpl>(size, name,
+        sizeLimit);
     CHECK_AND_RETURN_RET_LOG(sharedMemory->Init() == OH_MIDI_STATUS_OK, nullptr, "CreateFromLocal failed");
     return sharedMemory;
 }
 
-std::shared_ptr<MidiSharedMemory> MidiSharedMemory::CreateFromRemote(int fd, size_t size, const std::string &name)
+std::shared_ptr<MidiSharedMemory> MidiSharedMemory::CreateFromRemote(int fd, size_t size, const std::string &name,
+    bool readOnly)
+{
+    return CreateFromRemote(fd, size, name, readOnly, MAX_MMAP_BUFFER_SIZE);
+}
+
+std::shared_ptr<MidiSharedMemory> MidiSharedMemory::CreateFromRemote(int fd, size_t size, const std::string &name,
+    bool readOnly, size_t sizeLimit)
 {
     int minfd = 2; // ignore stdout, stdin and stderr.
     CHECK_AND_RETURN_RET_LOG(fd > minfd, nullptr, "CreateFromRemote failed: invalid fd: %{public}d", fd);
-    std::shared_ptr<MidiSharedMemoryImpl> sharedMemory = std::make_shared<MidiSharedMemoryImpl>(fd, size, name);
+    std::shared_ptr<MidiSharedMemoryImpl> sharedMemory =
+        std::make_shared<MidiSharedMemoryImpl>(fd, size, name, readOnly, sizeLimit);
     if (sharedMemory->Init() != OH_MIDI_STATUS_OK) {
         MIDI_ERR_LOG("CreateFromRemote failed");
         return nullptr;
@@ -260,6 +285,14 @@ int32_t MidiSharedRing::Init(int dataFd)
     controler_->capacity = capacity_;
     controler_->readPosition.store(0);
     controler_->writePosition.store(0);
+    if (dataFd == INVALID_FD) {
+        // the reader may already be waiting when the other end maps the ring, so only the creator sets these
+        controler_->notifyMaxEvents.store(0);
+        controler_->notifyMaxDelayUs.store(0);
+        controler_->readerState.store(RING_READER_IDLE);
+        controler_->spaceWaiters.store(0);
+        controler_->writeMark.store(0);
+    }
 
     ringBase_ = base_ + sizeof(ControlHeader);
 
@@ -385,7 +418,20 @@ ControlHeader *MidiSharedRing::GetControlHeader() const
 
 FutexCode MidiSharedRing::WaitFor(int64_t timeoutInNs, const std::function<bool(void)> &pred)
 {
-    return FutexTool::FutexWait(GetFutex(), timeoutInNs, [&pred]() { return pred(); });
+    const int64_t napNs = GetNotifyDelayNs();
+    if (napNs <= 0 || (timeoutInNs > 0 && timeoutInNs <= napNs)) {
+        return FutexTool::FutexWait(GetFutex(), timeoutInNs, [&pred]() { return pred(); });
+    }
+    // the writer may hold events back from a napping reader, they are picked up when the nap ends
+    SetReaderState(RING_READER_NAPPING);
+    FutexCode ret = FutexTool::FutexWait(GetFutex(), napNs, pred);
+    if (ret == FUTEX_TIMEOUT) {
+        // nothing came during the nap, the next event is notified at once
+        SetReaderState(RING_READER_IDLE);
+        ret = FutexTool::FutexWait(GetFutex(), timeoutInNs > 0 ? timeoutInNs - napNs : timeoutInNs, pred);
+    }
+    SetReaderState(RING_READER_ACTIVE);
+    return ret;
 }
 
 FutexCode MidiSharedRing::WaitForSpace(int64_t timeoutInNs, uint32_t neededBytes)
@@ -398,7 +444,10 @@ FutexCode MidiSharedRing::WaitForSpace(int64_t timeoutInNs, uint32_t neededBytes
         uint32_t w = controler_->writePosition.load();
         return RingFree(r, w, capacity_) >= neededBytes;
     };
-    return FutexTool::FutexWait(GetFutex(), timeoutInNs, pred);
+    controler_->spaceWaiters.fetch_add(1);
+    FutexCode ret = FutexTool::FutexWait(GetFutex(), timeoutInNs, pred);
+    controler_->spaceWaiters.fetch_sub(1);
+    return ret;
 }
 
 void MidiSharedRing::WakeFutex(uint32_t wakeVal)
@@ -413,6 +462,123 @@ void MidiSharedRing::NotifyConsumer(uint32_t wakeVal)
     WakeFutex(wakeVal);
 }
 
+void MidiSharedRing::SetNotifyModeration(uint32_t maxPendingEvents, uint32_t maxDelayUs)
+{
+    CHECK_AND_RETURN(controler_ != nullptr);
+    // a reader already asleep without a time limit has to be notified until it starts napping
+    controler_->readerState.store(RING_READER_IDLE);
+    controler_->notifyMaxEvents.store(maxPendingEvents);
+    controler_->notifyMaxDelayUs.store(std::min(maxDelayUs, MIDI_NOTIFY_MAX_DELAY_US));
+}
+
+int64_t MidiSharedRing::GetNotifyDelayNs() const
+{
+    CHECK_AND_RETURN_RET(controler_ != nullptr, 0);
+    // the other end may have written anything here
+    return static_cast<int64_t>(std::min(controler_->notifyMaxDelayUs.load(std::memory_order_relaxed),
+        MIDI_NOTIFY_MAX_DELAY_US)) * NS_PER_US;
+}
+
+void MidiSharedRing::SetReaderState(RingReaderState state)
+{
+    CHECK_AND_RETURN(controler_ != nullptr);
+    controler_->readerState.store(state);
+}
+
+void MidiSharedRing::MarkReaderActive()
+{
+    CHECK_AND_RETURN(controler_ != nullptr);
+    controler_->readerState.store(RING_READER_ACTIVE);
+    // whatever was written before this point is seen by the pass that follows
+    controler_->writeMark.store(0);
+}
+
+bool MidiSharedRing::MarkReaderSleeping(RingReaderState state)
+{
+    CHECK_AND_RETURN_RET(controler_ != nullptr, false);
+    controler_->readerState.store(state);
+    // pairs with NotifyWritten: a writer that still saw the reader active has left its mark by now
+    return controler_->writeMark.exchange(0) != 0;
+}
+
+void MidiSharedRing::MarkReaderPolling()
+{
+    CHECK_AND_RETURN(controler_ != nullptr);
+    // called on every poll, only write the line the writer reads when something changes
+    if (controler_->readerState.load(std::memory_order_relaxed) != RING_READER_POLLING) {
+        controler_->readerState.store(RING_READER_POLLING);
+    }
+}
+
+bool MidiSharedRing::TakeWriteMark()
+{
+    CHECK_AND_RETURN_RET(controler_ != nullptr, false);
+    return controler_->writeMark.load(std::memory_order_relaxed) != 0 && controler_->writeMark.exchange(0) != 0;
+}
+
+bool MidiSharedRing::HasEventFd() const
+{
+    return notifyFd_ != nullptr && notifyFd_->Valid();
+}
+
+bool MidiSharedRing::IsNotifyDue(int64_t now) const
+{
+    // an idle reader looks at the ring only when notified, anything else will look by itself
+    if (controler_->readerState.load() == RING_READER_IDLE) {
+        return true;
+    }
+    const uint32_t maxEvents = controler_->notifyMaxEvents.load(std::memory_order_relaxed);
+    if (maxEvents > 0 && pendingNotify_ >= maxEvents) {
+        return true;
+    }
+    if (now - firstPendingNs_ >= GetNotifyDelayNs()) {
+        return true;
+    }
+    const uint32_t used = RingUsed(controler_->readPosition.load(), controler_->writePosition.load(), capacity_);
+    return static_cast<uint64_t>(used) * PERCENT >= static_cast<uint64_t>(capacity_) * NOTIFY_HIGH_WATERMARK_PERCENT;
+}
+
+void MidiSharedRing::NotifyNow()
+{
+    pendingNotify_ = 0;
+    if (HasEventFd()) {
+        // the reader waits in epoll, nobody sleeps on the futex for data
+        MIDI_DEBUG_LOG("notify server to consume midi events");
+        uint64_t writed = 1;
+        (void)::write(notifyFd_->Get(), &writed, sizeof(writed));
+        return;
+    }
+    NotifyConsumer();
+}
+
+void MidiSharedRing::NotifyWritten(uint32_t eventCount)
+{
+    CHECK_AND_RETURN(controler_ != nullptr && eventCount > 0);
+    const bool moderated = GetNotifyDelayNs() > 0;
+    if (HasEventFd()) {
+        // the mark goes first, a reader that stops polling or goes to sleep after we looked still finds it
+        controler_->writeMark.store(1);
+        const uint32_t readerState = controler_->readerState.load();
+        if (readerState == RING_READER_POLLING) {
+            pendingNotify_ = 0;
+            return;
+        }
+        CHECK_AND_RETURN(moderated || readerState != RING_READER_ACTIVE);
+    }
+    if (!moderated) {
+        NotifyNow();
+        return;
+    }
+    const int64_t now = ClockTime::GetCurNano();
+    if (pendingNotify_ == 0) {
+        firstPendingNs_ = now;
+    }
+    pendingNotify_ += eventCount;
+    if (IsNotifyDue(now)) {
+        NotifyNow();
+    }
+}
+
 //==================== Write Side ====================//
 
 MidiStatusCode MidiSharedRing::TryWriteEvent(const MidiEventInner &event, bool notify)
@@ -460,12 +626,7 @@ MidiStatusCode MidiSharedRing::TryWriteEvents(
     }
 
     if (notify) {
-        NotifyConsumer();
-        if (notifyFd_ && notifyFd_->Valid()) {
-            MIDI_DEBUG_LOG("notify server to consume midi events");
-            uint64_t writed = 1;
-            (void)::write(notifyFd_->Get(), &writed, sizeof(writed));
-        }
+        NotifyWritten(localWritten);
     }
     return (localWritten == eventCount) ? MidiStatusCode::OK : MidiStatusCode::WOULD_BLOCK;
 }
@@ -494,7 +655,41 @@ MidiStatusCode MidiSharedRing::PeekNext(PeekedEvent &outEvent)
         if (ret == MidiStatusCode::SHM_BROKEN) {
             return ret;
         }
-        return BuildPeekedEvent(*header, readIndex, outEvent);
+        ret = BuildPeekedEvent(*header, readIndex, outEvent);
+        if (ret == MidiStatusCode::OK && (header->flags & SHM_EVENT_FLAG_CONSUMED) != 0) {
+            CommitRead(outEvent);
+            continue;
+        }
+        return ret;
+    }
+}
+
+MidiStatusCode MidiSharedRing::PeekAfter(const PeekedEvent &prevEvent, PeekedEvent &outEvent)
+{
+    outEvent = PeekedEvent{};
+
+    CHECK_AND_RETURN_RET(capacity_ >= (sizeof(ShmMidiEventHeader) + 1u), MidiStatusCode::SHM_BROKEN);
+    uint32_t readIndex = prevEvent.endOffset;
+    const uint32_t writeIndex = GetWritePosition();
+    for (;;) {
+        auto ret = UpdateReadIndexIfNeed(readIndex, writeIndex);
+        if (ret != MidiStatusCode::OK) {
+            return ret;
+        }
+
+        const ShmMidiEventHeader *header = reinterpret_cast<const ShmMidiEventHeader *>(ringBase_ + readIndex);
+        if ((header->flags & SHM_EVENT_FLAG_WRAP) != 0) {
+            // a wrap marker at offset 0 can never be valid, stop instead of looping
+            CHECK_AND_RETURN_RET(header->length == 0 && readIndex != 0, MidiStatusCode::SHM_BROKEN);
+            readIndex = 0;
+            continue;
+        }
+        ret = BuildPeekedEvent(*header, readIndex, outEvent);
+        if (ret == MidiStatusCode::OK && (header->flags & SHM_EVENT_FLAG_CONSUMED) != 0) {
+            readIndex = outEvent.endOffset;
+            continue;
+        }
+        return ret;
     }
 }
 
@@ -505,7 +700,31 @@ void MidiSharedRing::CommitRead(const PeekedEvent &ev)
         end = 0;
     }
     controler_->readPosition.store(end);
-    WakeFutex(); // wake who is waiting to write data
+    scanValid_ = false;
+    if (controler_->spaceWaiters.load() > 0) {
+        WakeFutex(); // wake who is waiting to write data
+    }
+}
+
+void MidiSharedRing::MarkConsumed(const PeekedEvent &event)
+{
+    CHECK_AND_RETURN(event.headerPtr != nullptr);
+    // the writer never touches unread space, so the reader may update the header in place
+    auto *header = const_cast<ShmMidiEventHeader *>(event.headerPtr);
+    header->flags |= SHM_EVENT_FLAG_CONSUMED;
+}
+
+void MidiSharedRing::SetScanPosition(const PeekedEvent &event)
+{
+    scanEvent_ = event;
+    scanValid_ = true;
+}
+
+bool MidiSharedRing::GetScanPosition(PeekedEvent &outEvent) const
+{
+    CHECK_AND_RETURN_RET(scanValid_, false);
+    outEvent = scanEvent_;
+    return true;
 }
 
 void MidiSharedRing::DrainToBatch(
@@ -537,6 +756,7 @@ void MidiSharedRing::Flush()
 {
     MIDI_INFO_LOG("reset data cache");
     controler_->readPosition.store(0);
+    scanValid_ = false;
     controler_->writePosition.store(0);
     memset_s(GetDataBase(), GetCapacity(), 0, GetCapacity());
 }
@@ -613,7 +833,7 @@ void MidiSharedRing::WriteEvent(uint32_t writeIndex, const MidiEventInner &event
     auto *header = reinterpret_cast<ShmMidiEventHeader *>(dst);
     header->timestamp = event.timestamp;
     header->length = static_cast<uint32_t>(event.length);
-    header->flags = SHM_EVENT_FLAG_NONE;
+    header->flags = static_cast<uint32_t>(event.tag) << SHM_EVENT_TAG_SHIFT;
 
     uint8_t *payload = dst + sizeof(ShmMidiEventHeader);
     const size_t payloadBytes = event.length * sizeof(uint32_t);
@@ -648,6 +868,7 @@ MidiStatusCode MidiSharedRing::HandleWrapIfNeeded(const ShmMidiEventHeader &head
         return MidiStatusCode::SHM_BROKEN;
     }
     controler_->readPosition.store(0);
+    scanValid_ = false;
     readIndex = 0;
     return MidiStatusCode::OK; // wrap, continue
 }
@@ -667,6 +888,7 @@ MidiStatusCode MidiSharedRing::BuildPeekedEvent(
     outEvent.payloadPtr = reinterpret_cast<const uint8_t *>(&header) + sizeof(ShmMidiEventHeader);
     outEvent.timestamp = header.timestamp;
     outEvent.length = header.length;
+    outEvent.tag = static_cast<uint16_t>(header.flags >> SHM_EVENT_TAG_SHIFT);
     outEvent.beginOffset = readIndex;
 
     uint32_t end = readIndex + needed; // end = (r + needed) % capacity_;
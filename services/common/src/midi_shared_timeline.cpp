@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LOG_TAG
+#define LOG_TAG "MidiSharedTimeline"
+#endif
+
+#include <algorithm>
+#include <securec.h>
+#include <unistd.h>
+
+#include "message_parcel.h"
+#include "midi_log.h"
+#include "midi_shared_timeline.h"
+#include "native_midi_base.h"
+
+namespace OHOS {
+namespace MIDI {
+namespace {
+constexpr int INVALID_FD = -1;
+constexpr int MINFD = 2; // ignore stdout, stdin and stderr.
+constexpr size_t TIMELINE_MEMORY_LIMIT = 0x400000;
+static_assert(sizeof(TimelineHeader) + MIDI_TIMELINE_MAX_CAPACITY < TIMELINE_MEMORY_LIMIT, "timeline too large");
+} // namespace
+
+MidiSharedTimeline::MidiSharedTimeline(uint32_t capacityBytes) : capacity_(capacityBytes)
+{}
+
+MidiSharedTimeline::MidiSharedTimeline(uint32_t capacityBytes, std::shared_ptr<UniqueFd> notifyFd)
+    : capacity_(capacityBytes), notifyFd_(notifyFd)
+{}
+
+int32_t MidiSharedTimeline::Init(int dataFd)
+{
+    CHECK_AND_RETURN_RET_LOG(capacity_ > sizeof(ShmMidiEventHeader) && capacity_ <= MIDI_TIMELINE_MAX_CAPACITY,
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "invalid capacity %{public}u", capacity_);
+    const size_t totalMemorySize = sizeof(TimelineHeader) + capacity_;
+    if (dataFd == INVALID_FD) {
+        dataMem_ = MidiSharedMemory::CreateFromLocal(totalMemorySize, "midi_shared_timeline", TIMELINE_MEMORY_LIMIT);
+    } else {
+        dataMem_ = MidiSharedMemory::CreateFromRemote(dataFd, totalMemorySize, "midi_shared_timeline", false,
+            TIMELINE_MEMORY_LIMIT);
+    }
+    CHECK_AND_RETURN_RET_LOG(dataMem_ != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "dataMem_ is nullptr.");
+    header_ = reinterpret_cast<TimelineHeader *>(dataMem_->GetBase());
+    eventBase_ = dataMem_->GetBase() + sizeof(TimelineHeader);
+    if (dataFd == INVALID_FD) {
+        header_->writePosition.store(0);
+        header_->capacity = capacity_;
+        header_->generation.store(0);
+        header_->playing.store(0);
+        header_->startTimestamp.store(0);
+        header_->startPosition.store(0);
+        header_->loopBegin.store(0);
+        header_->loopEnd.store(0);
+    }
+    CHECK_AND_RETURN_RET_LOG(header_->capacity == capacity_, OH_MIDI_STATUS_SYSTEM_ERROR,
+        "capacity mismatch %{public}u", header_->capacity);
+    return OH_MIDI_STATUS_OK;
+}
+
+std::shared_ptr<MidiSharedTimeline> MidiSharedTimeline::CreateFromLocal(uint32_t capacityBytes,
+    std::shared_ptr<UniqueFd> notifyFd)
+{
+    auto timeline = std::make_shared<MidiSharedTimeline>(capacityBytes, notifyFd);
+    CHECK_AND_RETURN_RET_LOG(timeline->Init(INVALID_FD) == OH_MIDI_STATUS_OK, nullptr, "failed to init.");
+    return timeline;
+}
+
+bool MidiSharedTimeline::Marshalling(Parcel &parcel) const
+{
+    MessageParcel &messageParcel = static_cast<MessageParcel &>(parcel);
+    CHECK_AND_RETURN_RET_LOG(dataMem_ != nullptr, false, "dataMem_ is nullptr.");
+    if (notifyFd_ == nullptr) {
+        return messageParcel.WriteUint32(capacity_) && messageParcel.WriteFileDescriptor(dataMem_->GetFd());
+    }
+    return messageParcel.WriteUint32(capacity_) &&
+        messageParcel.WriteFileDescriptor(dataMem_->GetFd()) && messageParcel.WriteFileDescriptor(notifyFd_->Get());
+}
+
+MidiSharedTimeline *MidiSharedTimeline::Unmarshalling(Parcel &parcel)
+{
+    MessageParcel &messageParcel = static_cast<MessageParcel &>(parcel);
+    uint32_t capacity = messageParcel.ReadUint32();
+    int dataFd = messageParcel.ReadFileDescriptor();
+    int eventFd = messageParcel.ReadFileDescriptor();
+    CHECK_AND_RETURN_RET_LOG(dataFd > MINFD, nullptr, "invalid dataFd: %{public}d", dataFd);
+
+    auto notifyFd = std::make_shared<UniqueFd>(eventFd);
+    auto timeline = new (std::nothrow) MidiSharedTimeline(capacity, notifyFd);
+    if (timeline == nullptr || timeline->Init(dataFd) != OH_MIDI_STATUS_OK) {
+        MIDI_ERR_LOG("failed to init.");
+        delete timeline;
+        CloseFd(dataFd);
+        return nullptr;
+    }
+    CloseFd(dataFd);
+    return timeline;
+}
+
+//==================== Write Side ====================//
+
+MidiStatusCode MidiSharedTimeline::Append(const MidiEventInner *events, uint32_t eventCount,
+    uint32_t *eventsWritten)
+{
+    CHECK_AND_RETURN_RET(header_ != nullptr, MidiStatusCode::SHM_BROKEN);
+    CHECK_AND_RETURN_RET(events != nullptr && eventCount > 0, MidiStatusCode::INVALID_ARGUMENT);
+    uint32_t writeIndex = header_->writePosition.load(std::memory_order_relaxed);
+    uint32_t localWritten = 0;
+    MidiStatusCode status = MidiStatusCode::OK;
+    for (; localWritten < eventCount; localWritten++) {
+        const MidiEventInner &event = events[localWritten];
+        if (event.data == nullptr || event.length == 0 || (writeIndex > 0 && event.timestamp < lastPosition_)) {
+            status = MidiStatusCode::INVALID_ARGUMENT;
+            break;
+        }
+        const size_t payloadBytes = event.length * sizeof(uint32_t);
+        const size_t needed = sizeof(ShmMidiEventHeader) + payloadBytes;
+        if (needed > capacity_ - writeIndex) {
+            status = MidiStatusCode::WOULD_BLOCK;
+            break;
+        }
+        auto *eventHeader = reinterpret_cast<ShmMidiEventHeader *>(eventBase_ + writeIndex);
+        eventHeader->timestamp = event.timestamp;
+        eventHeader->length = static_cast<uint32_t>(event.length);
+        eventHeader->flags = static_cast<uint32_t>(event.tag) << SHM_EVENT_TAG_SHIFT;
+        (void)memcpy_s(eventBase_ + writeIndex + sizeof(ShmMidiEventHeader), payloadBytes, event.data, payloadBytes);
+        writeIndex += static_cast<uint32_t>(needed);
+        lastPosition_ = event.timestamp;
+    }
+    if (eventsWritten != nullptr) {
+        *eventsWritten = localWritten;
+    }
+    if (localWritten > 0) {
+        // publish the events in one go
+        header_->writePosition.store(writeIndex, std::memory_order_release);
+        Notify();
+    }
+    return status;
+}
+
+void MidiSharedTimeline::SetLoop(uint64_t loopBegin, uint64_t loopEnd)
+{
+    CHECK_AND_RETURN(header_ != nullptr);
+    header_->loopBegin.store(loopBegin);
+    header_->loopEnd.store(loopEnd);
+    Notify();
+}
+
+void MidiSharedTimeline::Start(uint64_t startTimestamp, uint64_t startPosition)
+{
+    CHECK_AND_RETURN(header_ != nullptr);
+    header_->startTimestamp.store(startTimestamp);
+    header_->startPosition.store(startPosition);
+    header_->generation.fetch_add(1);
+    header_->playing.store(1);
+    Notify();
+}
+
+void MidiSharedTimeline::Stop()
+{
+    CHECK_AND_RETURN(header_ != nullptr);
+    header_->playing.store(0);
+    Notify();
+}
+
+void MidiSharedTimeline::Clear()
+{
+    CHECK_AND_RETURN(header_ != nullptr);
+    header_->playing.store(0);
+    header_->writePosition.store(0);
+    header_->loopBegin.store(0);
+    header_->loopEnd.store(0);
+    header_->generation.fetch_add(1);
+    lastPosition_ = 0;
+    Notify();
+}
+
+void MidiSharedTimeline::Notify()
+{
+    CHECK_AND_RETURN(notifyFd_ != nullptr && notifyFd_->Valid());
+    uint64_t count = 1;
+    (void)::write(notifyFd_->Get(), &count, sizeof(count));
+}
+
+//==================== Read Side ====================//
+
+bool MidiSharedTimeline::ReadAt(uint32_t offset, uint32_t writePosition,
+    MidiSharedRing::PeekedEvent &outEvent) const
+{
+    CHECK_AND_RETURN_RET(writePosition <= capacity_ && offset < writePosition &&
+        writePosition - offset >= sizeof(ShmMidiEventHeader), false);
+    const auto *eventHeader = reinterpret_cast<const ShmMidiEventHeader *>(eventBase_ + offset);
+    const uint64_t needed = sizeof(ShmMidiEventHeader) + static_cast<uint64_t>(eventHeader->length) * sizeof(uint32_t);
+    CHECK_AND_RETURN_RET(eventHeader->length > 0 && needed <= writePosition - offset, false);
+
+    outEvent.headerPtr = eventHeader;
+    outEvent.payloadPtr = eventBase_ + offset + sizeof(ShmMidiEventHeader);
+    outEvent.timestamp = eventHeader->timestamp;
+    outEvent.length = eventHeader->length;
+    outEvent.tag = static_cast<uint16_t>(eventHeader->flags >> SHM_EVENT_TAG_SHIFT);
+    outEvent.beginOffset = offset;
+    outEvent.endOffset = offset + static_cast<uint32_t>(needed);
+    return true;
+}
+
+uint32_t MidiSharedTimeline::Seek(uint64_t position, uint32_t writePosition) const
+{
+    // events are variable sized, walk from the start; only done on start and when the loop begin moves
+    uint32_t offset = 0;
+    MidiSharedRing::PeekedEvent event{};
+    while (ReadAt(offset, writePosition, event) && event.timestamp < position) {
+        offset = event.endOffset;
+    }
+    return offset;
+}
+
+void MidiSharedTimeline::Rewind(Cursor &cursor, uint32_t generation, uint32_t writePosition) const
+{
+    const uint64_t startPosition = header_->startPosition.load();
+    cursor.generation = generation;
+    cursor.offset = Seek(startPosition, writePosition);
+    cursor.baseTimestamp = static_cast<int64_t>(header_->startTimestamp.load()) - static_cast<int64_t>(startPosition);
+    cursor.valid = true;
+    cursor.loopValid = false;
+}
+
+uint32_t MidiSharedTimeline::GetLoopOffset(Cursor &cursor, uint64_t loopBegin, uint32_t writePosition) const
+{
+    // events are only appended behind the cached offset, it stays right until Clear or a new loop begin
+    if (!cursor.loopValid || cursor.loopBegin != loopBegin) {
+        cursor.loopOffset = Seek(loopBegin, writePosition);
+        cursor.loopBegin = loopBegin;
+        cursor.loopValid = true;
+    }
+    return cursor.loopOffset;
+}
+
+bool MidiSharedTimeline::PeekNext(Cursor &cursor, MidiSharedRing::PeekedEvent &outEvent,
+    uint64_t &outDueTimestamp) const
+{
+    CHECK_AND_RETURN_RET(header_ != nullptr && header_->playing.load() != 0, false);
+    const uint32_t generation = header_->generation.load(std::memory_order_acquire);
+    const uint32_t writePosition = header_->writePosition.load(std::memory_order_acquire);
+    if (!cursor.valid || cursor.generation != generation) {
+        Rewind(cursor, generation, writePosition);
+    }
+    const uint64_t loopBegin = header_->loopBegin.load();
+    const uint64_t loopEnd = header_->loopEnd.load();
+    const bool looping = loopEnd > loopBegin;
+
+    bool hasEvent = ReadAt(cursor.offset, writePosition, outEvent);
+    if (looping && (!hasEvent || outEvent.timestamp >= loopEnd)) {
+        // jump back only when the loop has something to play, an empty loop would never advance
+        const uint32_t loopOffset = GetLoopOffset(cursor, loopBegin, writePosition);
+        MidiSharedRing::PeekedEvent loopEvent{};
+        CHECK_AND_RETURN_RET(ReadAt(loopOffset, writePosition, loopEvent) && loopEvent.timestamp < loopEnd, false);
+        cursor.offset = loopOffset;
+        cursor.baseTimestamp += static_cast<int64_t>(loopEnd - loopBegin);
+        outEvent = loopEvent;
+        hasEvent = true;
+    }
+    CHECK_AND_RETURN_RET(hasEvent, false);
+    // 0 means "send immediately" everywhere else, keep a late event scheduled
+    outDueTimestamp = static_cast<uint64_t>(std::max<int64_t>(cursor.baseTimestamp +
+        static_cast<int64_t>(outEvent.timestamp), 1));
+    return true;
+}
+
+void MidiSharedTimeline::Advance(Cursor &cursor, const MidiSharedRing::PeekedEvent &event) const
+{
+    cursor.offset = event.endOffset;
+}
+} // namespace MIDI
+} // namespace OHOS
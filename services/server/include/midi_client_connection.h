@@ -16,11 +16,14 @@
 #ifndef MIDI_CLIENT_CONNECTION_H
 #define MIDI_CLIENT_CONNECTION_H
 
+#include <atomic>
 #include <vector>
 #include <chrono>
-#include <queue>
 
+#include "midi_info.h"
 #include "midi_shared_ring.h"
+#include "midi_shared_timeline.h"
+#include "midi_token_bucket.h"
 namespace OHOS {
 namespace MIDI {
 
@@ -35,6 +38,7 @@ public:
         std::chrono::steady_clock::time_point due;
         std::vector<uint32_t> data;
         uint64_t timestamp = 0;
+        uint16_t tag = 0;
     };
     struct PendingGreater {
         bool operator()(const PendingEvent& a, const PendingEvent& b) const
@@ -48,7 +52,8 @@ public:
         : clientId_(clientId), deviceHandle_(handle), portIndex_(portIndex) {}
     ~ClientConnectionInServer() = default;
 
-    int32_t CreateRingBuffer(int fd = -1);
+    // notifyFd is shared by every output ring of the port, the writer signals data through it
+    int32_t CreateRingBuffer(std::shared_ptr<UniqueFd> notifyFd = nullptr);
 
     int64_t GetDeviceHandle() const { return deviceHandle_; }
     uint32_t GetClientId() const { return clientId_; }
@@ -57,16 +62,61 @@ public:
     std::shared_ptr<MidiSharedRing> GetRingBuffer();
 
     int32_t TrySendToClient(const MidiEventInner& event);
+    // write a whole batch with one consumer wakeup, events that do not fit are dropped
+    int32_t TrySendToClient(const MidiEventInner *events, size_t eventCount);
 
     void SetMaxPending(size_t maxPending) { maxPending_ = maxPending; }
     bool IsPendingFull() const { return pending_.size() >= maxPending_; }
     bool HasPending() const { return !pending_.empty(); }
     bool EnqueueNonRealtime(std::vector<uint32_t>&& payloadWords,
                             std::chrono::steady_clock::time_point dueTime,
-                            uint64_t timestamp);
+                            uint64_t timestamp, uint16_t tag = 0);
     const PendingEvent* PeekPendingTop() const;
     bool PopPendingTop(PendingEvent& out);
     void Flush();
+    // Flush() without the ring, for a ring the driver is still reading
+    void FlushScheduled();
+    /**
+     * @brief Drop scheduled events not yet sent, both in the pending heap and still in the ring.
+     * @param tag only events with this tag, MIDI_EVENT_TAG_ANY matches all
+     * @param beginTimestamp first timestamp to drop, inclusive
+     * @param endTimestamp last timestamp to drop, inclusive
+     * @return number of events dropped
+     */
+    size_t CancelScheduled(uint16_t tag, uint64_t beginTimestamp, uint64_t endTimestamp);
+
+    // pre-scheduled events played straight from shared memory, next to the pending heap
+    int32_t CreateTimeline(uint32_t capacityBytes, std::shared_ptr<UniqueFd> notifyFd = nullptr);
+    std::shared_ptr<MidiSharedTimeline> GetTimeline() const { return timeline_; }
+    // earliest due of the pending heap and the timeline
+    bool PeekNextDue(std::chrono::steady_clock::time_point &outDue);
+    // pop the event PeekNextDue reports, out.data stays valid until the next pop
+    bool PopNextDue(MidiEventInner &out);
+    // latest due of the pending heap and the timeline that is not after limit, call after PeekNextDue
+    bool FindLatestDueUntil(std::chrono::steady_clock::time_point limit,
+                            std::chrono::steady_clock::time_point &outDue) const;
+
+    // output fairness: deficit round-robin weight and bytes-per-second cap (0 means unlimited)
+    void SetWeight(uint32_t weight) { weight_.store(weight == 0 ? 1 : weight); }
+    uint32_t GetWeight() const { return weight_.load(); }
+    void SetMaxBytesPerSecond(uint64_t maxBytesPerSecond) { rateLimiter_.Configure(maxBytesPerSecond); }
+
+    // deficit and rate state below is only touched by the output worker
+    void AddDeficit(size_t quantum) { deficit_ += quantum; }
+    bool HasDeficit() const { return deficit_ > 0; }
+    void UseDeficit() { deficit_ = deficit_ > 0 ? deficit_ - 1 : 0; }
+    void ResetDeficit() { deficit_ = 0; }
+    bool IsRateLimited(std::chrono::steady_clock::time_point now) { return rateLimiter_.IsLimited(now); }
+    void ChargeRate(size_t bytes) { rateLimiter_.Charge(bytes); }
+    std::chrono::steady_clock::time_point GetRateResumeTime() const { return rateLimiter_.GetResumeTime(); }
+
+    // input filter, set before the connection is published to the input thread and not changed after
+    void SetInputFilter(const MidiInputFilter &filter) { inputFilter_ = filter; }
+    const MidiInputFilter &GetInputFilter() const { return inputFilter_; }
+
+    // the client asked for exclusive direct output, granted while it is the only client of the port
+    void SetExclusiveRequested(bool exclusive) { exclusiveRequested_.store(exclusive); }
+    bool IsExclusiveRequested() const { return exclusiveRequested_.load(); }
 
 private:
     uint32_t clientId_ = 0;
@@ -75,8 +125,25 @@ private:
 
     std::shared_ptr<MidiSharedRing> sharedRingBuffer_ = nullptr;
 
+    void RemovePendingAt(size_t index);
+    void FindLatestPendingDueUntil(size_t index, std::chrono::steady_clock::time_point limit,
+                                   std::chrono::steady_clock::time_point &latest, bool &found) const;
+
     size_t maxPending_ = 1024;
-    std::priority_queue<PendingEvent, std::vector<PendingEvent>, PendingGreater> pending_;
+    std::vector<PendingEvent> pending_; // binary min-heap on due, ordered by PendingGreater
+    PendingEvent poppedPending_;        // backs the data of the last PopNextDue
+
+    std::shared_ptr<MidiSharedTimeline> timeline_ = nullptr;
+    MidiSharedTimeline::Cursor timelineCursor_;
+    MidiSharedRing::PeekedEvent timelineEvent_;
+    uint64_t timelineDueTimestamp_ = 0;
+    bool timelineNext_ = false; // the last PeekNextDue picked timelineEvent_
+
+    std::atomic<uint32_t> weight_{1};
+    size_t deficit_ = 0;
+    MidiTokenBucket rateLimiter_;
+    std::atomic<bool> exclusiveRequested_{false};
+    MidiInputFilter inputFilter_;
 };
 } // namespace MIDI
 } // namespace OHOS
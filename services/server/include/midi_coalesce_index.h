@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIDI_COALESCE_INDEX_H
+#define MIDI_COALESCE_INDEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace OHOS {
+namespace MIDI {
+
+/**
+ * @brief Small open-addressing map from a controller key to the send cache position of its latest value.
+ * A message that cannot be merged is a barrier for the values before it on its group and channel, so a value
+ * never moves across a note or another message it may relate to.
+ * Clear() is O(1) through a generation counter, so the index can be reset on every flush.
+ */
+class MidiCoalesceIndex {
+public:
+    static constexpr uint32_t INVALID_KEY = 0xFFFFFFFFu;
+
+    /**
+     * @brief Build the coalescing key of a UMP message.
+     * @return INVALID_KEY for messages whose every value must reach the device (notes, SysEx, RPN/NRPN
+     * selection and data entry, switch controllers, channel mode messages).
+     */
+    static uint32_t GetKey(const uint32_t *words, size_t wordCount);
+
+    /**
+     * @brief Record the message at newIndex, positions must increase between two Clear() calls.
+     * @return true and the previous position of the same controller in oldIndex if that value may be dropped,
+     * i.e. no barrier was recorded for its group and channel since.
+     */
+    bool Exchange(const uint32_t *words, size_t wordCount, uint32_t newIndex, uint32_t &oldIndex);
+
+    bool Exchange(uint32_t key, uint32_t newIndex, uint32_t &oldIndex);
+
+    void Clear();
+
+private:
+    struct Slot {
+        uint32_t key = INVALID_KEY;
+        uint32_t index = 0;
+        uint32_t generation = 0;
+    };
+    // position after the last barrier, valid in its generation only
+    struct Barrier {
+        uint32_t index = 0;
+        uint32_t generation = 0;
+    };
+    static constexpr size_t SLOT_COUNT = 256;                // power of two
+    static constexpr size_t MAX_USED_SLOTS = SLOT_COUNT * 3 / 4; // keep probe chains short
+    static constexpr size_t GROUP_COUNT = 16;
+    static constexpr size_t CHANNEL_COUNT = 16;
+
+    void SetBarrier(Barrier &barrier, uint32_t index) const;
+    uint32_t GetBarrier(const Barrier &barrier) const;
+    bool IsBehindBarrier(uint32_t word, uint32_t index) const;
+
+    std::array<Slot, SLOT_COUNT> slots_{};
+    std::array<Barrier, GROUP_COUNT * CHANNEL_COUNT> channelBarriers_{};
+    std::array<Barrier, GROUP_COUNT> groupBarriers_{};
+    uint32_t generation_ = 1;
+    size_t usedSlots_ = 0;
+};
+} // namespace MIDI
+} // namespace OHOS
+#endif // MIDI_COALESCE_INDEX_H
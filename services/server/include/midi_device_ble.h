@@ -71,6 +71,8 @@ public:
     int32_t OpenOutputPort(int64_t deviceId, uint32_t portIndex) override;
     int32_t CloseOutputPort(int64_t deviceId, uint32_t portIndex) override;
     int32_t HandleUmpInput(int64_t deviceId, uint32_t portIndex, std::vector<MidiEventInner> &list) override;
+    // one GATT write per event, keep it off the scheduling thread
+    MidiDriverCapability GetOutputCapability(int64_t deviceId, uint32_t portIndex) override;
 
     // Make these accessible to C-style static callbacks
     std::mutex lock_;
@@ -18,10 +18,17 @@
 
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <thread>
 
+#include <sched.h>
+
 #include "midi_device_driver.h"
+#include "midi_broadcast_ring.h"
 #include "midi_client_connection.h"
+#include "midi_coalesce_index.h"
+#include "midi_output_submitter.h"
+#include "midi_token_bucket.h"
 
 namespace OHOS {
 namespace MIDI {
@@ -55,12 +62,18 @@ public:
     virtual bool HasClientConnection(uint32_t clientId) const;
 
 protected:
-    std::vector<std::shared_ptr<ClientConnectionInServer>> SnapshotClients() const;
+    using ClientList = std::vector<std::shared_ptr<ClientConnectionInServer>>;
+
+    // lock free, the list is immutable and stays valid while the returned pointer is held
+    std::shared_ptr<const ClientList> LoadClients() const;
+    std::shared_ptr<ClientConnectionInServer> FindClient(uint32_t clientId) const;
+    // caller holds clientsMutex_, the list is copied, changed and published as a whole
+    void PublishClients(ClientList &&clients);
 
 protected:
     DeviceConnectionInfo info_;
-    mutable std::mutex clientsMutex_;
-    std::vector<std::shared_ptr<ClientConnectionInServer>> clients_;
+    mutable std::mutex clientsMutex_; // serializes writers of clients_
+    std::shared_ptr<const ClientList> clients_; // read and replaced with the std::atomic_* shared_ptr functions
 };
 
 class DeviceConnectionForInput final : public DeviceConnectionBase {
@@ -70,8 +83,24 @@ public:
 
     void HandleDeviceUmpInput(std::vector<MidiEventInner> &events);
 
+    // the filter drops events before they are written to the client ring
+    int32_t AddFilteredClient(uint32_t clientId, int64_t deviceHandle, std::shared_ptr<MidiSharedRing> &buffer,
+                              const MidiInputFilter &filter);
+
+    // broadcast clients share one ring per port, each event is written once whatever the client count
+    int32_t AddBroadcastClient(uint32_t clientId, std::shared_ptr<MidiBroadcastRing> &ring);
+    void RemoveClientConnection(uint32_t clientId) override;
+    bool IsEmptyClientConnections() override;
+    bool HasClientConnection(uint32_t clientId) const override;
+
 private:
-    void BroadcastToClients(const MidiEventInner &ev);
+    // one client snapshot and one ring write per client for the whole driver batch
+    void BroadcastToClients(const std::vector<MidiEventInner> &events);
+    static bool PassInputFilter(const MidiInputFilter &filter, const MidiEventInner &event);
+
+    std::shared_ptr<MidiBroadcastRing> broadcastRing_ = nullptr; // published like clients_
+    std::vector<MidiEventInner> filteredEvents_;                  // input delivery thread only
+    std::vector<uint32_t> broadcastClients_;                      // guarded by clientsMutex_
 };
 
 class DeviceConnectionForOutput final : public DeviceConnectionBase {
@@ -86,48 +115,135 @@ public:
     int GetNotifyEventFdForClients() const;
     int32_t AddClientConnection(uint32_t clientId, int64_t deviceHandle,
                                         std::shared_ptr<MidiSharedRing> &buffer) override;
+    void RemoveClientConnection(uint32_t clientId) override;
+
+    // exclusive direct mode: while the requesting client is alone on the port its ring goes straight
+    // to the driver, with no heap, send cache or fairness; a second client falls back to shared mode
+    int32_t SetClientExclusive(uint32_t clientId, bool exclusive);
+    bool IsDirectMode() const;
 
-    // todo: maybe not needed
     void SetPerClientMaxPendingEvents(size_t maxPendingEvents);
+    // bytes-per-second cap given to clients added from now on, 0 means unlimited
+    void SetPerClientMaxBytesPerSecond(uint64_t maxBytesPerSecond);
     void SetMaxSendCacheBytes(size_t maxSendCacheBytes);
+    // precision mode: wake up a margin early and spin to the exact deadline before sending
+    void SetPrecisionMode(bool enable);
+    // a timer wakeup is put off to the latest event due within slackNs of the earliest one, so that events due
+    // close together reach the driver in one submission; a lone event is not delayed, none goes out early,
+    // precision mode ignores the slack
+    void SetSchedulingSlack(uint64_t slackNs);
+    // Opt-in busy polling for a port with a core to spare. After a wakeup the worker spins over the client
+    // rings every pollIntervalNs (0: back to back), pinned to cpu (-1: not pinned), while the clients skip
+    // their wake syscalls. Once nothing came for idleTimeoutNs (0: never) it waits for notifications again.
+    void SetBusyPoll(bool enable, uint64_t pollIntervalNs, int32_t cpu, uint64_t idleTimeoutNs);
+    bool IsBusyPolling() const;
 
     void FlushClientCache(uint32_t clientId);
-    
+    // drop the client's scheduled events with the tag and a timestamp in [beginTimestamp, endTimestamp]
+    int32_t CancelClientEvents(uint32_t clientId, uint16_t tag, uint64_t beginTimestamp, uint64_t endTimestamp);
+    // give the client a timeline region of capacityBytes, played by this worker next to its ring
+    int32_t CreateClientTimeline(uint32_t clientId, uint32_t capacityBytes,
+                                 std::shared_ptr<MidiSharedTimeline> &timeline);
+
+    // last-value-wins for CC/pitch bend/pressure values not yet sent, within windowNs of event timestamps
+    void SetCoalescing(bool enable, uint64_t windowNs);
+
+    // pace output to the device link rate, bytesPerSecond 0 disables pacing
+    void SetWirePacing(uint64_t bytesPerSecond, uint64_t burstBytes, MidiWireFormat format);
+
+    // fairness between clients sharing the port
+    void SetPerWakeupEventBudget(size_t eventBudget);
+    // a client drains weight times the event budget per wakeup, 0 is treated as 1
+    int32_t SetClientWeight(uint32_t clientId, uint32_t weight);
+
+    // syscalls made by the worker's wait loop and events handed to the driver, their ratio is the wait
+    // overhead per event
+    uint64_t GetWorkerSyscallCount() const;
+    uint64_t GetSentEventCount() const;
+
 private:
     // worker loop
     void ThreadMain();
     void HandleWakeupOnce();
 
+    // return false if not in direct mode
+    bool DrainDirectClientRing();
+    // batch the direct client's sendable events in place, return true if the budget ran out with more ready
+    bool CollectDirectBatch(ClientConnectionInServer &directClient, std::vector<MidiEventInner> &events);
+    // commit the ring read of the batch in the driver once it is done, return false while it is not
+    bool ReleaseDirectBatch();
+    // caller holds clientStateMutex_
+    void DiscardDirectRingAfterBatch();
+    // caller holds clientsMutex_
+    void UpdateDirectClient(const ClientList &clients);
+    bool FindDirectRingDue(std::chrono::steady_clock::time_point &outDueTime);
+
     void DrainAllClientsRings();
-    void DrainSingleClientRing(ClientConnectionInServer &clientConnection);
+    // return true if the client's event budget ran out with events left in its ring
+    bool DrainSingleClientRing(ClientConnectionInServer &clientConnection);
+    void ChargeClientForEvent(ClientConnectionInServer &clientConnection, const MidiSharedRing::PeekedEvent &ringEvent);
+    void ChargeWire(const uint32_t *payloadWords, size_t payloadWordCount);
+    static size_t GetMidi1WireBytes(const uint32_t *payloadWords, size_t payloadWordCount);
+    // realtime lane: let immediate events overtake a scheduled backlog the pending heap cannot take yet
+    void DrainRealtimeLane(ClientConnectionInServer &clientConnection, MidiSharedRing &clientRing,
+                           const MidiSharedRing::PeekedEvent &blockedEvent);
+    void SendRealtimeEvent(const MidiSharedRing::PeekedEvent &ringEvent);
     bool ConsumeRealtimeEvent(MidiSharedRing &clientRing, const MidiSharedRing::PeekedEvent &ringEvent);
     bool ConsumeNonRealtimeEvent(ClientConnectionInServer &clientConnection, MidiSharedRing &clientRing,
                                  const MidiSharedRing::PeekedEvent &ringEvent);
 
-    // todo: due + (1 or 2)ms <= now
+    // collect heap and timeline events due before now + lookahead_
     void CollectDueEventsFromClientHeaps();
+    uint64_t GetSchedulingSlackNs() const;
+    std::chrono::steady_clock::time_point GetSlackDeadline(const ClientList &clientsSnapshot,
+                                                           std::chrono::steady_clock::time_point earliestDueTime);
 
-    // Step3：flush cache -> driver
-    void FlushSendCacheToDriver();
+    // Step3：flush cache -> driver, with async submission the cache is kept while every batch is busy
+    // unless waitForBatch is set
+    void FlushSendCacheToDriver(bool waitForBatch = false);
 
     // Step4：timerfd set earliest due
     void UpdateNextTimer();
+    // covers client rate caps and wire pacing
+    bool FindEarliestRateResume(const ClientList &clients, std::chrono::steady_clock::time_point &outResumeTime);
+
+    // precision mode helper
+    void WaitForPrecisionDeadline();
+    void UpdatePrecisionMargin();
 
     std::shared_ptr<ClientConnectionInServer>
-    FindClientWithEarliestDue(const std::vector<std::shared_ptr<ClientConnectionInServer>> &clientsSnapshot,
+    FindClientWithEarliestDue(const ClientList &clientsSnapshot,
                               std::chrono::steady_clock::time_point &outEarliestDueTime);
 
     // send cache helper
     bool TryAppendToSendCache(uint64_t timestamp,
                               const uint32_t* payloadWords,
                               size_t payloadWordCount);
-    void SendToDriver(MidiEventInner event);
+    void CoalesceLastCachedEvent();
+    // events that do not fit the send cache, event.data may point into a client ring; zero-copy only with a
+    // synchronous driver, the async submitter copies the event into its batch
+    int32_t SendToDriver(const MidiEventInner &event);
+
+    void LoadDriverCapability();
+
+    // Tells the client rings the worker is about to sleep, moderated ones get a nap of their notify delay
+    // before the worker waits to be notified. Returns the epoll timeout in ms, 0 when it must not sleep.
+    int PrepareRingWait();
+    // clients skip the eventfd write while the worker is busy with their ring
+    void MarkRingReadersActive();
+
+    // busy poll helper, return false when polling ends
+    void EnterBusyPoll();
+    void LeaveBusyPoll();
+    bool BusyPollForWork();
+    bool HasPollWork(std::chrono::steady_clock::time_point now);
 
     // fd/epoll helper
     int32_t InitEpollAndFds();
     void DrainEventFd();
     void DrainTimerFd();
     void WakeWorkerByEventFd();
+    void CountWorkerSyscalls(uint64_t count);
 
     struct SendItem {
         std::vector<uint8_t> data;
@@ -136,19 +252,77 @@ private:
     std::atomic<bool> running_{false};
     std::thread worker_;
 
-    UniqueFd notifyEventFd_; // eventfd: clients -> server notify
+    // eventfd: clients -> server notify, the client rings and timelines share it instead of a dup each
+    std::shared_ptr<UniqueFd> notifyEventFd_ = std::make_shared<UniqueFd>();
     UniqueFd epollFd_;       // epoll: wait eventfd + timerfd
     UniqueFd timerFd_;       // timerfd: pending earliest due
+    bool moderatedNapExpired_ = false; // worker only
+    bool rerunPending_ = false;        // worker only, a backlog is left: run again without waiting
+    bool timerArmed_ = false;          // worker only, the timerfd is armed for timerTarget_
+    std::atomic<uint64_t> workerSyscalls_{0};
+    std::atomic<uint64_t> sentEvents_{0};
 
     size_t maxSendCacheBytes_ = 64 * 1024;
     size_t currentSendCacheBytes_ = 0;
     std::vector<MidiEventInner> sendCache_;
     std::vector<std::vector<uint32_t>> sendCachePayloadBuffers_; // for payload
+    size_t sendCachePayloadCount_ = 0; // leading sendCachePayloadBuffers_ in use, the rest are kept for reuse
+    std::vector<MidiEventInner> directSendEvents_;                // single event list for SendToDriver
+
+    // pending heaps, timelines and ring reads of the clients, shared by the worker and the IPC calls
+    // that change them; port open and close only take clientsMutex_ and never wait for the worker
+    std::mutex clientStateMutex_;
+    std::shared_ptr<ClientConnectionInServer> directClient_ = nullptr; // published like clients_
+    std::vector<MidiEventInner> directBatch_;                         // points into the direct client's ring
+    // a direct batch is sent without clientStateMutex_ and stays in the ring until the driver is done with it;
+    // a flush meanwhile drops the events behind it at that point
+    std::shared_ptr<MidiSharedRing> directInFlightRing_ = nullptr;
+    MidiSharedRing::PeekedEvent directInFlightLast_{};
+    MidiSharedRing::PeekedEvent directDiscardLast_{};
+    bool directDiscardPending_ = false;
+
+    std::atomic<bool> coalesceEnabled_{false};
+    std::atomic<uint64_t> coalesceWindowNs_{0};
+    MidiCoalesceIndex coalesceIndex_;
+    size_t coalescedCount_ = 0; // dropped entries (length 0) waiting to be removed from sendCache_
+
+    MidiOutputSubmitter submitter_; // running when the driver asks for async output
+    uint32_t asyncOutputDepth_ = 0;
+
+    MidiTokenBucket wirePacer_;
+    std::atomic<MidiWireFormat> wireFormat_{MidiWireFormat::UMP};
 
     size_t perClientMaxPendingEvents_ = 1024;
+    uint64_t perClientMaxBytesPerSecond_ = 0;
+    std::atomic<size_t> perWakeupEventBudget_{64}; // events per weight unit and wakeup
+    size_t drainCursor_ = 0;                       // client drained first in the next round
+
+    std::chrono::nanoseconds lookahead_{0}; // driver scheduling window, 0 means send when due
+
+    std::atomic<uint64_t> schedulingSlackNs_{0};
+
+    std::atomic<bool> busyPollEnabled_{false};
+    std::atomic<uint64_t> busyPollIntervalNs_{0};
+    std::atomic<int32_t> busyPollCpu_{-1};
+    std::atomic<uint64_t> busyPollIdleTimeoutNs_{0};
+    std::atomic<bool> busyPolling_{false};                 // written by the worker only
+    std::atomic<bool> wakeRequested_{false};               // WakeWorkerByEventFd for a polling worker
+    std::chrono::steady_clock::time_point lastPollWork_{}; // worker only
+    cpu_set_t savedAffinity_{};                            // worker only, restored when polling ends
+    bool affinityPinned_ = false;                          // worker only
+
+    std::atomic<bool> precisionMode_{false};
+    std::chrono::nanoseconds precisionMargin_{0};         // adapted from measured wake lateness
+    std::chrono::steady_clock::time_point timerTarget_{}; // time the timerfd is armed for
 
     static constexpr uint64_t kEpollTagNotifyEventFd = 1;
     static constexpr uint64_t kEpollTagTimerFd = 2;
+
+    static constexpr std::chrono::nanoseconds kPrecisionMarginDefault = std::chrono::microseconds(200);
+    static constexpr std::chrono::nanoseconds kPrecisionMarginMin = std::chrono::microseconds(50);
+    static constexpr std::chrono::nanoseconds kPrecisionMarginMax = std::chrono::milliseconds(2);
+    static constexpr std::chrono::nanoseconds kPrecisionSpinThreshold = std::chrono::microseconds(100);
+    static constexpr int64_t kPrecisionMarginSmoothing = 8; // new sample weights 1/8
 };
 } // namespace MIDI
 } // namespace OHOS
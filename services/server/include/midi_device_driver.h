@@ -25,6 +25,40 @@ namespace MIDI {
 
 using UmpInputCallback = std::function<void(std::vector<MidiEventInner> &events)>;
 using BleDriverCallback = std::function<void(bool connected, DeviceInformation devInfo)>;
+// completion of an asynchronous output submission, may run on any thread
+using UmpOutputDoneCallback = std::function<void(int32_t result)>;
+
+// 31250 baud, 10 bits on the wire per byte
+constexpr uint64_t MIDI_DIN_BYTES_PER_SECOND = 3125;
+// one batch in the driver and one being filled
+constexpr uint32_t MIDI_DEFAULT_ASYNC_OUTPUT_DEPTH = 2;
+
+// how output bytes are counted against the wire rate
+enum class MidiWireFormat : uint32_t {
+    UMP = 0,               // 4 bytes per UMP word
+    MIDI1_BYTE_STREAM = 1, // encoded MIDI 1.0 length, e.g. DIN or BLE
+};
+
+/**
+ * @brief Output capability of a driver port.
+ * When supportsScheduledOutput is true, the driver (or the hardware behind it) honours
+ * MidiEventInner::timestamp itself, so the server may forward events up to lookaheadNs before they are due.
+ * A non-zero wireBytesPerSecond makes the server pace output to the link rate, with wireBurstBytes of buffering
+ * in the device (0 selects 100ms worth of bytes).
+ * A non-zero coalesceWindowNs lets the server replace a controller value not yet sent by a newer one of the same
+ * controller due within that window, for links that cannot carry every intermediate value in time.
+ * A non-zero asyncOutputDepth makes the server submit output through SubmitUmpOutput from a separate thread,
+ * with up to that many batches queued or in flight, instead of calling HandleUmpInput on its scheduling thread.
+ */
+struct MidiDriverCapability {
+    bool supportsScheduledOutput = false;
+    uint64_t lookaheadNs = 0;
+    uint64_t wireBytesPerSecond = 0;
+    uint64_t wireBurstBytes = 0;
+    MidiWireFormat wireFormat = MidiWireFormat::UMP;
+    uint64_t coalesceWindowNs = 0;
+    uint32_t asyncOutputDepth = 0;
+};
 
 class MidiDeviceDriver {
 public:
@@ -47,6 +81,29 @@ public:
     virtual int32_t CloseOutputPort(int64_t deviceId, uint32_t portIndex) = 0;
 
     virtual int32_t HandleUmpInput(int64_t deviceId, uint32_t portIndex, std::vector<MidiEventInner> &list) = 0;
+
+    /**
+     * @brief Asynchronous output. list and the payloads it points to stay valid until done is called,
+     * done must be called exactly once, also on failure.
+     * The default adapter sends through HandleUmpInput and completes before returning.
+     */
+    virtual int32_t SubmitUmpOutput(int64_t deviceId, uint32_t portIndex, std::vector<MidiEventInner> &list,
+        UmpOutputDoneCallback done)
+    {
+        int32_t ret = HandleUmpInput(deviceId, portIndex, list);
+        if (done) {
+            done(ret);
+        }
+        return ret;
+    }
+
+    // default: no internal scheduling, events are handed over when due
+    virtual MidiDriverCapability GetOutputCapability(int64_t deviceId, uint32_t portIndex)
+    {
+        (void)deviceId;
+        (void)portIndex;
+        return MidiDriverCapability{};
+    }
 };
 
 } // namespace MIDI
@@ -28,6 +28,7 @@
 #include "midi_device_connection.h"
 #include "midi_device_driver.h"
 #include "midi_info.h"
+#include "midi_input_dispatcher.h"
 #include "common_event_manager.h"
 #include "common_event_support.h"
 
@@ -71,6 +72,11 @@ public:
     int32_t CloseInputPort(int64_t deviceId, uint32_t portIndex);
     DeviceInformation GetDeviceForDeviceId(int64_t deviceId);
     int32_t CloseOutputPort(int64_t deviceId, uint32_t portIndex);
+    // hand device input to one service dispatch thread instead of fanning it out on the driver threads,
+    // applies to input ports opened afterwards
+    int32_t SetInputDispatchThread(bool enable);
+    // deficit round-robin weight of an app's clients on output ports, from a system parameter
+    uint32_t GetOutputClientWeight(uint32_t uid);
 
 #ifdef UNIT_TEST_SUPPORT
     /**
@@ -109,12 +115,14 @@ private:
     std::vector<DeviceInformation> devices_{};
     std::shared_ptr<EventSubscriber> eventSubscriber_{nullptr};
     std::unordered_map<int64_t, int64_t> driverIdToMidiId_;
+    std::shared_ptr<MidiInputDispatcher> inputDispatcher_ = nullptr; // guarded by dispatcherMutex_
 
     std::atomic<int64_t> nextDeviceId_{1000};
     std::mutex devicesMutex_;
     std::mutex driversMutex_;
     mutable std::mutex mappingMutex_;
     std::mutex initMutex_;
+    std::mutex dispatcherMutex_;
 };
 } // namespace MIDI
 } // namespace OHOS
@@ -16,9 +16,17 @@
 #ifndef MIDI_DEVICE_USB_H
 #define MIDI_DEVICE_USB_H
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
 #include <vector>
 #include "midi_info.h"
 #include "midi_device_driver.h"
+#include "midi_usb_shm_transport.h"
 #include "v1_0/imidi_interface.h"
 
 namespace OHOS {
@@ -36,7 +44,7 @@ private:
 class UsbMidiTransportDeviceDriver : public MidiDeviceDriver {
 public:
     UsbMidiTransportDeviceDriver();
-    virtual ~UsbMidiTransportDeviceDriver() = default;
+    virtual ~UsbMidiTransportDeviceDriver();
 
     std::vector<DeviceInformation> GetRegisteredDevices() override;
 
@@ -57,8 +65,55 @@ public:
 
     int32_t HandleUmpInput(int64_t deviceId, uint32_t portIndex, std::vector<MidiEventInner> &list) override;
 
+    // SendMidiMessages is a blocking HDI call, keep it off the scheduling thread
+    MidiDriverCapability GetOutputCapability(int64_t deviceId, uint32_t portIndex) override;
+
+    // ports opened afterwards exchange events through rings instead of HDI messages, in the directions
+    // the transport's capability lists for them
+    void SetShmTransport(std::shared_ptr<UsbMidiShmTransport> transport);
+
+    // vendor and product ids of interfaces wired to DIN jacks, their output ports report the DIN rate
+    void SetDinDevices(std::vector<std::pair<uint64_t, uint64_t>> vendorProductIds);
+
 private:
+    using PortKey = std::pair<int64_t, uint32_t>;
+
+    struct ShmInputPort {
+        std::shared_ptr<MidiSharedRing> ring;
+        UmpInputCallback callback;
+        std::atomic<bool> running{false};
+        std::thread reader;
+    };
+
+    // HDI messages of one output port, kept between batches so steady traffic does not allocate
+    struct UsbOutputArena {
+        std::mutex mutex;
+        std::vector<HDI::Midi::V1_0::MidiMessage> messages;
+        std::vector<std::vector<uint32_t>> spareData; // payload buffers of messages beyond the last batch
+    };
+
+    std::shared_ptr<UsbOutputArena> GetOutputArena(int64_t deviceId, uint32_t portIndex);
+    void ReleaseOutputArena(int64_t deviceId, uint32_t portIndex);
+    static void FillOutputArena(UsbOutputArena &arena, const std::vector<MidiEventInner> &list);
+    void AttachShmOutput(int64_t deviceId, uint32_t portIndex);
+    bool AttachShmInput(int64_t deviceId, uint32_t portIndex, UmpInputCallback cb);
+    void DetachShmOutput(int64_t deviceId, uint32_t portIndex);
+    void DetachShmInput(int64_t deviceId, uint32_t portIndex);
+    std::shared_ptr<MidiSharedRing> FindShmOutputRing(int64_t deviceId, uint32_t portIndex);
+    int32_t WriteShmOutput(const std::shared_ptr<MidiSharedRing> &ring, std::vector<MidiEventInner> &list);
+    static void ShmInputLoop(ShmInputPort *port);
+    void RecordDinDevice(int64_t deviceId, uint64_t vendorId, uint64_t productId);
+
     sptr<HDI::Midi::V1_0::IMidiInterface> midiHdi_ = nullptr;
+    std::mutex shmMutex_;
+    std::shared_ptr<UsbMidiShmTransport> shmTransport_;
+    std::map<PortKey, std::shared_ptr<MidiSharedRing>> shmOutputRings_;
+    std::map<PortKey, std::unique_ptr<ShmInputPort>> shmInputPorts_;
+    std::mutex arenaMutex_;
+    std::map<PortKey, std::shared_ptr<UsbOutputArena>> outputArenas_;
+    std::mutex dinMutex_;
+    std::vector<std::pair<uint64_t, uint64_t>> dinVendorProductIds_;
+    std::set<int64_t> dinDeviceIds_; // listed devices seen in GetRegisteredDevices
 };
 } // namespace MIDI
 } // namespace OHOS
@@ -32,6 +32,15 @@ public:
     int32_t OpenInputPort(std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId, uint32_t portIndex) override;
     int32_t OpenOutputPort(std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId, uint32_t portIndex) override;
     int32_t FlushOutputPort(int64_t deviceId, uint32_t portIndex) override;
+    int32_t CancelScheduledEvents(int64_t deviceId, uint32_t portIndex, uint32_t tag, uint64_t beginTimestamp,
+        uint64_t endTimestamp) override;
+    int32_t OpenOutputTimeline(std::shared_ptr<MidiSharedTimeline> &timeline, int64_t deviceId, uint32_t portIndex,
+        uint32_t capacityBytes) override;
+    int32_t SetOutputPortExclusive(int64_t deviceId, uint32_t portIndex, bool exclusive) override;
+    int32_t OpenInputPortBroadcast(std::shared_ptr<MidiBroadcastRing> &ring, int64_t deviceId,
+        uint32_t portIndex) override;
+    int32_t OpenInputPortWithFilter(std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId,
+        uint32_t portIndex, const MidiInputFilter &filter) override;
     int32_t CloseInputPort(int64_t deviceId, uint32_t portIndex) override;
     int32_t CloseOutputPort(int64_t deviceId, uint32_t portIndex) override;
     int32_t DestroyMidiClient() override;
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIDI_INPUT_DISPATCHER_H
+#define MIDI_INPUT_DISPATCHER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "midi_info.h"
+
+namespace OHOS {
+namespace MIDI {
+class DeviceConnectionForInput;
+
+constexpr size_t INPUT_DISPATCH_DEFAULT_CAPACITY = 256;
+constexpr int32_t INPUT_DISPATCH_DEFAULT_PRIORITY = 1; // SCHED_FIFO, 0 keeps the default policy
+
+/**
+ * @brief Takes device input off the driver threads. A driver callback copies its batch into a bounded
+ * lock-free queue and returns; one service thread drains the queue in order and does the filtering and
+ * ring writes of the target connection. The thread asks for real-time priority, if the system refuses it
+ * keeps running with the default policy. A batch that finds the queue full is dropped and counted.
+ * Post may be called from any number of threads, everything else from the owner.
+ */
+class MidiInputDispatcher {
+public:
+    explicit MidiInputDispatcher(size_t capacity = INPUT_DISPATCH_DEFAULT_CAPACITY);
+    ~MidiInputDispatcher();
+    MidiInputDispatcher(const MidiInputDispatcher &) = delete;
+    MidiInputDispatcher &operator=(const MidiInputDispatcher &) = delete;
+
+    int32_t Start(int32_t rtPriority = INPUT_DISPATCH_DEFAULT_PRIORITY);
+    // batches already queued are still dispatched
+    void Stop();
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // copies the batch, false if it was not queued
+    bool Post(const std::weak_ptr<DeviceConnectionForInput> &target, const std::vector<MidiEventInner> &events);
+    uint64_t GetDroppedCount() const { return droppedCount_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0}; // position + 1 once filled, position + capacity once free again
+        std::weak_ptr<DeviceConnectionForInput> target;
+        std::vector<MidiEventInner> events; // data is rebuilt from words on the dispatch thread
+        std::vector<uint32_t> words;
+    };
+
+    void ThreadMain();
+    bool HasPending() const;
+    void DispatchOne();
+    void ApplyPriority(int32_t rtPriority);
+
+    const size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) size_t dequeuePos_ = 0; // dispatch thread only
+    std::atomic<uint32_t> futex_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> droppedCount_{0};
+    std::thread worker_;
+};
+} // namespace MIDI
+} // namespace OHOS
+#endif // MIDI_INPUT_DISPATCHER_H
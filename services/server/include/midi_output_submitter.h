@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIDI_OUTPUT_SUBMITTER_H
+#define MIDI_OUTPUT_SUBMITTER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "midi_device_driver.h"
+
+namespace OHOS {
+namespace MIDI {
+
+/**
+ * @brief Hands output batches to the driver on its own thread, so a slow driver transaction does not hold up
+ * the output worker. At most depth batches are queued or in flight; a batch comes back to the pool when the
+ * driver completes it. onComplete is called, outside the submitter's lock, on the first completion after
+ * Acquire(false) found no free batch or IsIdle() returned false, so the producer can go on.
+ * The batches are shared with the completion callbacks, so a driver completing after Stop() gave up waiting
+ * still finds them alive; onComplete is no longer called then.
+ * Acquire/Submit are used by a single producer thread.
+ */
+class MidiOutputSubmitter {
+public:
+    struct Batch {
+        std::vector<MidiEventInner> events;
+        // backs events[i].data, completed batches keep the cleared vectors for reuse
+        std::vector<std::vector<uint32_t>> payloads;
+    };
+
+    MidiOutputSubmitter() = default;
+    ~MidiOutputSubmitter();
+    MidiOutputSubmitter(const MidiOutputSubmitter &) = delete;
+    MidiOutputSubmitter &operator=(const MidiOutputSubmitter &) = delete;
+
+    int32_t Start(MidiDeviceDriver *driver, int64_t deviceId, uint32_t portIndex, size_t depth,
+                  std::function<void()> onComplete);
+    // queued batches are still sent, then in-flight ones are waited for
+    void Stop();
+    bool IsRunning() const { return running_; }
+
+    // a free batch, nullptr if all are busy and wait is false
+    Batch *Acquire(bool wait);
+    void Submit(Batch *batch);
+    // give back a batch that was acquired but has nothing to send
+    void Release(Batch *batch);
+    // every submitted batch has completed, false also asks for onComplete on the next completion
+    bool IsIdle();
+    uint64_t GetFailedCount() const;
+
+private:
+    // everything a completion touches, owned by the submitter and by every pending completion
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stopping = false;
+        std::vector<std::unique_ptr<Batch>> pool;
+        std::vector<Batch *> freeBatches; // completion queue, recycled by Acquire
+        std::deque<Batch *> queue;        // submitted, not handed to the driver yet
+        uint64_t failedCount = 0;
+        bool producerWaiting = false;     // the producer is waiting for the next completion
+        uint32_t callbacksRunning = 0;    // onComplete calls in progress outside the lock
+        std::function<void()> onComplete; // reset when the submitter stops
+    };
+
+    void ThreadMain();
+    static void Complete(const std::shared_ptr<State> &state, Batch *batch, int32_t result);
+
+    MidiDeviceDriver *driver_ = nullptr;
+    int64_t deviceId_ = 0;
+    uint32_t portIndex_ = 0;
+    bool running_ = false;
+    std::thread worker_;
+    std::shared_ptr<State> state_ = std::make_shared<State>();
+};
+} // namespace MIDI
+} // namespace OHOS
+#endif // MIDI_OUTPUT_SUBMITTER_H
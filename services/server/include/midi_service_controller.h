@@ -23,6 +23,7 @@
 #define MIDI_TEST_VISIBLE
 #endif
 
+#include <functional>
 #include <map>
 #include <mutex>
 #include <vector>
@@ -87,9 +88,18 @@ public:
     int32_t CloseDevice(uint32_t clientId, int64_t deviceId);
     int32_t OpenInputPort(
         uint32_t clientId, std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId, uint32_t portIndex);
+    int32_t OpenInputPortBroadcast(
+        uint32_t clientId, std::shared_ptr<MidiBroadcastRing> &ring, int64_t deviceId, uint32_t portIndex);
+    int32_t OpenInputPortWithFilter(uint32_t clientId, std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId,
+        uint32_t portIndex, const MidiInputFilter &filter);
     int32_t OpenOutputPort(
         uint32_t clientId, std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId, uint32_t portIndex);
     int32_t FlushOutputPort(uint32_t clientId, int64_t deviceId, uint32_t portIndex);
+    int32_t CancelScheduledEvents(uint32_t clientId, int64_t deviceId, uint32_t portIndex, uint16_t tag,
+        uint64_t beginTimestamp, uint64_t endTimestamp);
+    int32_t OpenOutputTimeline(uint32_t clientId, std::shared_ptr<MidiSharedTimeline> &timeline, int64_t deviceId,
+        uint32_t portIndex, uint32_t capacityBytes);
+    int32_t SetOutputPortExclusive(uint32_t clientId, int64_t deviceId, uint32_t portIndex, bool exclusive);
     int32_t CloseInputPort(uint32_t clientId, int64_t deviceId, uint32_t portIndex);
     int32_t CloseOutputPort(uint32_t clientId, int64_t deviceId, uint32_t portIndex);
     int32_t DestroyMidiClient(uint32_t clientId);
@@ -134,6 +144,8 @@ public:
 private:
     void ClosePortforDevice(
         uint32_t clientId, int64_t deviceId, std::shared_ptr<DeviceClientContext> deviceClientContext);
+    int32_t OpenInputPortInner(uint32_t clientId, int64_t deviceId, uint32_t portIndex,
+        const std::function<int32_t(DeviceConnectionForInput &)> &attachClient);
     int32_t CloseInputPortInner(uint32_t clientId, int64_t deviceId, uint32_t portIndex);
     void HandleBleOpenComplete(const std::string &address, bool success, int64_t deviceId,
         const MidiDeviceInfo &deviceInfo);
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIDI_TOKEN_BUCKET_H
+#define MIDI_TOKEN_BUCKET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace OHOS {
+namespace MIDI {
+
+/**
+ * @brief Byte rate limiter. A message is let through while the bucket is not in debt, then charged in full,
+ * so a message larger than the burst still passes and delays the following ones instead of blocking forever.
+ * Configure() may be called from any thread, the other methods only from the thread that sends.
+ */
+class MidiTokenBucket {
+public:
+    /**
+     * @param bytesPerSecond refill rate, 0 disables the limit
+     * @param burstBytes bucket size, 0 selects 100ms worth of bytesPerSecond
+     */
+    void Configure(uint64_t bytesPerSecond, uint64_t burstBytes = 0);
+    bool IsEnabled() const { return bytesPerSecond_.load() != 0; }
+
+    // refill up to now, return true while the bucket is in debt
+    bool IsLimited(std::chrono::steady_clock::time_point now);
+    void Charge(size_t bytes);
+    // time at which IsLimited turns false again, valid after IsLimited returned true
+    std::chrono::steady_clock::time_point GetResumeTime() const;
+
+private:
+    std::atomic<uint64_t> bytesPerSecond_{0};
+    std::atomic<uint64_t> burstBytes_{0};
+    double tokens_ = 0; // bytes, negative while in debt
+    std::chrono::steady_clock::time_point refillTime_{};
+};
+} // namespace MIDI
+} // namespace OHOS
+#endif // MIDI_TOKEN_BUCKET_H
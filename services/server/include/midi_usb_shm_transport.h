@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MIDI_USB_SHM_TRANSPORT_H
+#define MIDI_USB_SHM_TRANSPORT_H
+
+#include <cstdint>
+#include <memory>
+
+#include "midi_shared_ring.h"
+
+namespace OHOS {
+namespace MIDI {
+
+constexpr uint32_t USB_SHM_RING_SIZE = 4096;
+
+/**
+ * @brief Ring support of the driver for one port. A direction without it keeps using HDI messages,
+ * no ring or reader thread is created for it.
+ */
+struct UsbMidiShmCapability {
+    bool outputRing = false;
+    bool inputRing = false;
+    uint32_t ringSize = USB_SHM_RING_SIZE; // bytes, the driver may ask for more to cover its transfer size
+};
+
+/**
+ * @brief Optional ring transport between the service and the USB MIDI driver.
+ * The service owns one MidiSharedRing per direction per port and hands it over while the port is opened,
+ * the driver reads output events from the output ring and writes device input into the input ring,
+ * both sides wake each other through the ring futex. A port whose attach fails keeps using HDI messages.
+ * The V1_0 midi HDI cannot carry a ring, so only a driver with its own channel to the service implements this.
+ */
+class UsbMidiShmTransport {
+public:
+    virtual ~UsbMidiShmTransport() = default;
+
+    // asked when a port opens, before any ring is created for it
+    virtual UsbMidiShmCapability GetCapability(int64_t deviceId, uint32_t portIndex) = 0;
+
+    // the driver is the only reader of the ring, the service the only writer
+    virtual int32_t AttachOutputRing(int64_t deviceId, uint32_t portIndex,
+        const std::shared_ptr<MidiSharedRing> &ring) = 0;
+
+    // the driver is the only writer of the ring, the service the only reader
+    virtual int32_t AttachInputRing(int64_t deviceId, uint32_t portIndex,
+        const std::shared_ptr<MidiSharedRing> &ring) = 0;
+
+    // the driver stops touching the ring before returning
+    virtual void DetachOutputRing(int64_t deviceId, uint32_t portIndex) = 0;
+    virtual void DetachInputRing(int64_t deviceId, uint32_t portIndex) = 0;
+};
+} // namespace MIDI
+} // namespace OHOS
+#endif // MIDI_USB_SHM_TRANSPORT_H
@@ -16,6 +16,7 @@
 #define LOG_TAG "ClientConnectionInServer"
 #endif
 
+#include <algorithm>
 #include <memory>
 
 #include "native_midi_base.h"
@@ -25,16 +26,19 @@
 
 namespace OHOS {
 namespace MIDI {
+namespace {
+// the slack window looks this far into a timeline, a window holding more events is already worth a batch
+constexpr size_t TIMELINE_SLACK_SCAN_LIMIT = 64;
+} // namespace
 
 std::shared_ptr<MidiSharedRing> ClientConnectionInServer::GetRingBuffer()
 {
     return sharedRingBuffer_;
 }
 
-int32_t ClientConnectionInServer::CreateRingBuffer(int fd)
+int32_t ClientConnectionInServer::CreateRingBuffer(std::shared_ptr<UniqueFd> notifyFd)
 {
-    auto fdObject = std::make_shared<UniqueFd>(fd);
-    sharedRingBuffer_ = MidiSharedRing::CreateFromLocal(DEFAULT_RING_BUFFER_SIZE, fdObject);
+    sharedRingBuffer_ = MidiSharedRing::CreateFromLocal(DEFAULT_RING_BUFFER_SIZE, std::move(notifyFd));
     CHECK_AND_RETURN_RET_LOG(sharedRingBuffer_ != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "create fail");
 
     memset_s(sharedRingBuffer_->GetDataBase(), sharedRingBuffer_->GetCapacity(), 0,
@@ -50,9 +54,30 @@ int32_t ClientConnectionInServer::TrySendToClient(const MidiEventInner& event)
     return OH_MIDI_STATUS_OK;
 }
 
+int32_t ClientConnectionInServer::TrySendToClient(const MidiEventInner *events, size_t eventCount)
+{
+    CHECK_AND_RETURN_RET(events != nullptr && eventCount > 0, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT);
+    size_t offset = 0;
+    size_t sent = 0;
+    while (offset < eventCount) {
+        uint32_t written = 0;
+        (void)sharedRingBuffer_->TryWriteEvents(events + offset, static_cast<uint32_t>(eventCount - offset),
+            &written, false);
+        sent += written;
+        // skip the event that stopped the write, later smaller ones may still fit
+        offset += written + 1;
+    }
+    if (sent > 0) {
+        sharedRingBuffer_->NotifyWritten(static_cast<uint32_t>(sent));
+    }
+    CHECK_AND_RETURN_RET_LOG(sent == eventCount, OH_MIDI_STATUS_SYSTEM_ERROR,
+        "client %{public}u dropped %{public}zu events", clientId_, eventCount - sent);
+    return OH_MIDI_STATUS_OK;
+}
+
 bool ClientConnectionInServer::EnqueueNonRealtime(std::vector<uint32_t>&& payloadWords,
                                                   std::chrono::steady_clock::time_point dueTime,
-                                                  uint64_t timestamp)
+                                                  uint64_t timestamp, uint16_t tag)
 {
     if (IsPendingFull()) {
         return false;
@@ -61,29 +86,194 @@ bool ClientConnectionInServer::EnqueueNonRealtime(std::vector<uint32_t>&& payloa
     event.due = dueTime;
     event.timestamp = timestamp;
     event.data = std::move(payloadWords);
-    pending_.push(std::move(event));
+    event.tag = tag;
+    pending_.push_back(std::move(event));
+    std::push_heap(pending_.begin(), pending_.end(), PendingGreater());
     return true;
 }
 
 const ClientConnectionInServer::PendingEvent* ClientConnectionInServer::PeekPendingTop() const
 {
     if (pending_.empty()) return nullptr;
-    return &pending_.top();
+    return &pending_.front();
 }
 
 bool ClientConnectionInServer::PopPendingTop(PendingEvent& out)
 {
     if (pending_.empty()) return false;
-    out = pending_.top();
-    pending_.pop();
+    std::pop_heap(pending_.begin(), pending_.end(), PendingGreater());
+    out = std::move(pending_.back());
+    pending_.pop_back();
     return true;
 }
 
 void ClientConnectionInServer::Flush()
 {
-    std::priority_queue<PendingEvent, std::vector<PendingEvent>, PendingGreater> emptyPending;
-    pending_.swap(emptyPending);
+    FlushScheduled();
     sharedRingBuffer_->Flush();
 }
+
+void ClientConnectionInServer::FlushScheduled()
+{
+    std::vector<PendingEvent> emptyPending;
+    pending_.swap(emptyPending);
+    if (timeline_ != nullptr) {
+        timeline_->Stop();
+    }
+}
+
+int32_t ClientConnectionInServer::CreateTimeline(uint32_t capacityBytes, std::shared_ptr<UniqueFd> notifyFd)
+{
+    auto timeline = MidiSharedTimeline::CreateFromLocal(capacityBytes, std::move(notifyFd));
+    CHECK_AND_RETURN_RET_LOG(timeline != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "create timeline fail");
+    timeline_ = timeline;
+    timelineCursor_ = MidiSharedTimeline::Cursor{};
+    timelineNext_ = false;
+    return OH_MIDI_STATUS_OK;
+}
+
+bool ClientConnectionInServer::PeekNextDue(std::chrono::steady_clock::time_point &outDue)
+{
+    bool hasDue = false;
+    if (!pending_.empty()) {
+        outDue = pending_.front().due;
+        hasDue = true;
+    }
+    timelineNext_ = false;
+    if (timeline_ != nullptr && timeline_->PeekNext(timelineCursor_, timelineEvent_, timelineDueTimestamp_)) {
+        const auto timelineDue = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(timelineDueTimestamp_));
+        if (!hasDue || timelineDue < outDue) {
+            outDue = timelineDue;
+            hasDue = true;
+            timelineNext_ = true;
+        }
+    }
+    return hasDue;
+}
+
+bool ClientConnectionInServer::PopNextDue(MidiEventInner &out)
+{
+    std::chrono::steady_clock::time_point due {};
+    CHECK_AND_RETURN_RET(PeekNextDue(due), false);
+    if (timelineNext_) {
+        // zero-copy: the payload is read from the timeline region
+        out.timestamp = timelineDueTimestamp_;
+        out.length = timelineEvent_.length;
+        out.data = reinterpret_cast<const uint32_t *>(timelineEvent_.payloadPtr);
+        out.tag = timelineEvent_.tag;
+        timeline_->Advance(timelineCursor_, timelineEvent_);
+        return true;
+    }
+    CHECK_AND_RETURN_RET(PopPendingTop(poppedPending_), false);
+    out.timestamp = poppedPending_.timestamp;
+    out.length = poppedPending_.data.size();
+    out.data = poppedPending_.data.data();
+    out.tag = poppedPending_.tag;
+    return true;
+}
+
+bool ClientConnectionInServer::FindLatestDueUntil(std::chrono::steady_clock::time_point limit,
+    std::chrono::steady_clock::time_point &outDue) const
+{
+    bool found = false;
+    if (!pending_.empty()) {
+        FindLatestPendingDueUntil(0, limit, outDue, found);
+    }
+    CHECK_AND_RETURN_RET(timeline_ != nullptr, found);
+    // walk a copy of the cursor, the timeline is played in order so the walk stops at the first later event
+    MidiSharedTimeline::Cursor cursor = timelineCursor_;
+    MidiSharedRing::PeekedEvent event{};
+    uint64_t dueTimestamp = 0;
+    for (size_t i = 0; i < TIMELINE_SLACK_SCAN_LIMIT && timeline_->PeekNext(cursor, event, dueTimestamp); i++) {
+        const auto due = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(dueTimestamp));
+        if (due > limit) {
+            break;
+        }
+        if (!found || due > outDue) {
+            outDue = due;
+            found = true;
+        }
+        timeline_->Advance(cursor, event);
+    }
+    return found;
+}
+
+void ClientConnectionInServer::FindLatestPendingDueUntil(size_t index, std::chrono::steady_clock::time_point limit,
+    std::chrono::steady_clock::time_point &latest, bool &found) const
+{
+    // a min-heap: nothing below a node due after limit can be due before it, depth is log2 of the heap size
+    if (index >= pending_.size() || pending_[index].due > limit) {
+        return;
+    }
+    if (!found || pending_[index].due > latest) {
+        latest = pending_[index].due;
+        found = true;
+    }
+    FindLatestPendingDueUntil(index * 2 + 1, limit, latest, found);
+    FindLatestPendingDueUntil(index * 2 + 2, limit, latest, found);
+}
+
+void ClientConnectionInServer::RemovePendingAt(size_t index)
+{
+    // move the last element into the hole, then restore the heap on the one path it can break
+    const PendingGreater greater;
+    pending_[index] = std::move(pending_.back());
+    pending_.pop_back();
+    const size_t count = pending_.size();
+    if (index >= count) {
+        return;
+    }
+    while (index > 0) {
+        const size_t parent = (index - 1) / 2;
+        if (!greater(pending_[parent], pending_[index])) {
+            break;
+        }
+        std::swap(pending_[parent], pending_[index]);
+        index = parent;
+    }
+    for (;;) {
+        const size_t left = index * 2 + 1;
+        if (left >= count) {
+            break;
+        }
+        const size_t right = left + 1;
+        const size_t child = (right < count && greater(pending_[left], pending_[right])) ? right : left;
+        if (!greater(pending_[index], pending_[child])) {
+            break;
+        }
+        std::swap(pending_[index], pending_[child]);
+        index = child;
+    }
+}
+
+size_t ClientConnectionInServer::CancelScheduled(uint16_t tag, uint64_t beginTimestamp, uint64_t endTimestamp)
+{
+    auto matches = [tag, beginTimestamp, endTimestamp](uint16_t eventTag, uint64_t timestamp) {
+        return timestamp != 0 && timestamp >= beginTimestamp && timestamp <= endTimestamp &&
+            (tag == MIDI_EVENT_TAG_ANY || eventTag == tag);
+    };
+    size_t cancelled = 0;
+    // walk backwards: a removal only moves already visited entries or an ancestor into index i, so recheck i
+    for (size_t i = pending_.size(); i-- > 0;) {
+        while (i < pending_.size() && matches(pending_[i].tag, pending_[i].timestamp)) {
+            RemovePendingAt(i);
+            cancelled++;
+        }
+    }
+    CHECK_AND_RETURN_RET(sharedRingBuffer_ != nullptr, cancelled);
+    // events the worker has not drained yet are consumed in place
+    MidiSharedRing::PeekedEvent ringEvent{};
+    MidiStatusCode status = sharedRingBuffer_->PeekNext(ringEvent);
+    while (status == MidiStatusCode::OK) {
+        if (matches(ringEvent.tag, ringEvent.timestamp)) {
+            sharedRingBuffer_->MarkConsumed(ringEvent);
+            cancelled++;
+        }
+        MidiSharedRing::PeekedEvent nextEvent{};
+        status = sharedRingBuffer_->PeekAfter(ringEvent, nextEvent);
+        ringEvent = nextEvent;
+    }
+    return cancelled;
+}
 } // namespace MIDI
 } // namespace OHOS
\ No newline at end of file
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "midi_coalesce_index.h"
+
+namespace OHOS {
+namespace MIDI {
+namespace {
+constexpr uint32_t UMP_MT_SHIFT = 28;
+constexpr uint32_t UMP_GROUP_SHIFT = 24;
+constexpr uint32_t UMP_STATUS_SHIFT = 20;
+constexpr uint32_t UMP_CHANNEL_SHIFT = 16;
+constexpr uint32_t UMP_INDEX_SHIFT = 8;
+constexpr uint32_t UMP_NIBBLE_MASK = 0xF;
+constexpr uint32_t UMP_BYTE_MASK = 0x7F;
+
+constexpr uint32_t UMP_MT_UTILITY = 0x0;
+constexpr uint32_t UMP_MT_SYSTEM = 0x1;
+constexpr uint32_t UMP_MT_MIDI1_CHANNEL_VOICE = 0x2;
+constexpr uint32_t UMP_MT_MIDI2_CHANNEL_VOICE = 0x4;
+constexpr uint32_t UMP_MT_STREAM = 0xF;
+constexpr size_t UMP_MIDI1_CHANNEL_VOICE_WORDS = 1;
+constexpr size_t UMP_MIDI2_CHANNEL_VOICE_WORDS = 2;
+
+constexpr uint32_t STATUS_PER_NOTE_PITCH_BEND = 0x6;
+constexpr uint32_t STATUS_POLY_PRESSURE = 0xA;
+constexpr uint32_t STATUS_CONTROL_CHANGE = 0xB;
+constexpr uint32_t STATUS_CHANNEL_PRESSURE = 0xD;
+constexpr uint32_t STATUS_PITCH_BEND = 0xE;
+
+constexpr uint32_t CC_BANK_SELECT_MSB = 0;
+constexpr uint32_t CC_DATA_ENTRY_MSB = 6;
+constexpr uint32_t CC_BANK_SELECT_LSB = 32;
+constexpr uint32_t CC_DATA_ENTRY_LSB = 38;
+constexpr uint32_t CC_SWITCH_FIRST = 64; // sustain, portamento, sostenuto, soft pedal, legato, hold 2
+constexpr uint32_t CC_SWITCH_LAST = 69;
+constexpr uint32_t CC_DATA_INCREMENT = 96;
+constexpr uint32_t CC_RPN_MSB = 101;
+constexpr uint32_t CC_CHANNEL_MODE_FIRST = 120;
+
+constexpr uint32_t KEY_MT_SHIFT = 20;
+constexpr uint32_t KEY_GROUP_SHIFT = 16;
+constexpr uint32_t KEY_STATUS_SHIFT = 12;
+constexpr uint32_t KEY_CHANNEL_SHIFT = 8;
+constexpr uint32_t HASH_MULTIPLIER = 2654435761u; // Knuth multiplicative hash
+
+// controllers whose meaning depends on the messages around them, and switches where every edge counts
+bool IsOrderSensitiveController(uint32_t controller)
+{
+    return controller == CC_BANK_SELECT_MSB || controller == CC_BANK_SELECT_LSB ||
+        controller == CC_DATA_ENTRY_MSB || controller == CC_DATA_ENTRY_LSB ||
+        (controller >= CC_SWITCH_FIRST && controller <= CC_SWITCH_LAST) ||
+        (controller >= CC_DATA_INCREMENT && controller <= CC_RPN_MSB) || controller >= CC_CHANNEL_MODE_FIRST;
+}
+
+bool IsChannelVoice(uint32_t mt)
+{
+    return mt == UMP_MT_MIDI1_CHANNEL_VOICE || mt == UMP_MT_MIDI2_CHANNEL_VOICE;
+}
+} // namespace
+
+uint32_t MidiCoalesceIndex::GetKey(const uint32_t *words, size_t wordCount)
+{
+    if (words == nullptr || wordCount == 0) {
+        return INVALID_KEY;
+    }
+    const uint32_t word = words[0];
+    const uint32_t mt = (word >> UMP_MT_SHIFT) & UMP_NIBBLE_MASK;
+    if (!((mt == UMP_MT_MIDI1_CHANNEL_VOICE && wordCount == UMP_MIDI1_CHANNEL_VOICE_WORDS) ||
+        (mt == UMP_MT_MIDI2_CHANNEL_VOICE && wordCount == UMP_MIDI2_CHANNEL_VOICE_WORDS))) {
+        return INVALID_KEY;
+    }
+    const uint32_t status = (word >> UMP_STATUS_SHIFT) & UMP_NIBBLE_MASK;
+    const uint32_t data1 = (word >> UMP_INDEX_SHIFT) & UMP_BYTE_MASK;
+    uint32_t index = 0;
+    switch (status) {
+        case STATUS_CONTROL_CHANGE:
+            if (IsOrderSensitiveController(data1)) {
+                return INVALID_KEY;
+            }
+            index = data1;
+            break;
+        case STATUS_POLY_PRESSURE:
+            index = data1;
+            break;
+        case STATUS_PER_NOTE_PITCH_BEND:
+            if (mt != UMP_MT_MIDI2_CHANNEL_VOICE) {
+                return INVALID_KEY;
+            }
+            index = data1;
+            break;
+        case STATUS_CHANNEL_PRESSURE:
+        case STATUS_PITCH_BEND:
+            break;
+        default:
+            return INVALID_KEY;
+    }
+    const uint32_t group = (word >> UMP_GROUP_SHIFT) & UMP_NIBBLE_MASK;
+    const uint32_t channel = (word >> UMP_CHANNEL_SHIFT) & UMP_NIBBLE_MASK;
+    return (mt << KEY_MT_SHIFT) | (group << KEY_GROUP_SHIFT) | (status << KEY_STATUS_SHIFT) |
+        (channel << KEY_CHANNEL_SHIFT) | index;
+}
+
+bool MidiCoalesceIndex::Exchange(const uint32_t *words, size_t wordCount, uint32_t newIndex, uint32_t &oldIndex)
+{
+    if (words == nullptr || wordCount == 0) {
+        return false;
+    }
+    const uint32_t word = words[0];
+    const uint32_t key = GetKey(words, wordCount);
+    if (key != INVALID_KEY) {
+        uint32_t previous = 0;
+        if (!Exchange(key, newIndex, previous) || IsBehindBarrier(word, previous)) {
+            return false;
+        }
+        oldIndex = previous;
+        return true;
+    }
+    const uint32_t mt = (word >> UMP_MT_SHIFT) & UMP_NIBBLE_MASK;
+    const uint32_t group = (word >> UMP_GROUP_SHIFT) & UMP_NIBBLE_MASK;
+    if (IsChannelVoice(mt)) {
+        const uint32_t channel = (word >> UMP_CHANNEL_SHIFT) & UMP_NIBBLE_MASK;
+        SetBarrier(channelBarriers_[group * CHANNEL_COUNT + channel], newIndex);
+    } else if (mt != UMP_MT_UTILITY && mt != UMP_MT_SYSTEM && mt != UMP_MT_STREAM) {
+        // SysEx and other group messages may address any channel of their group
+        SetBarrier(groupBarriers_[group], newIndex);
+    }
+    return false;
+}
+
+void MidiCoalesceIndex::SetBarrier(Barrier &barrier, uint32_t index) const
+{
+    // values at or before index must stay
+    barrier.index = index + 1;
+    barrier.generation = generation_;
+}
+
+uint32_t MidiCoalesceIndex::GetBarrier(const Barrier &barrier) const
+{
+    return barrier.generation == generation_ ? barrier.index : 0;
+}
+
+bool MidiCoalesceIndex::IsBehindBarrier(uint32_t word, uint32_t index) const
+{
+    const uint32_t group = (word >> UMP_GROUP_SHIFT) & UMP_NIBBLE_MASK;
+    const uint32_t channel = (word >> UMP_CHANNEL_SHIFT) & UMP_NIBBLE_MASK;
+    return index < GetBarrier(channelBarriers_[group * CHANNEL_COUNT + channel]) ||
+        index < GetBarrier(groupBarriers_[group]);
+}
+
+bool MidiCoalesceIndex::Exchange(uint32_t key, uint32_t newIndex, uint32_t &oldIndex)
+{
+    if (key == INVALID_KEY) {
+        return false;
+    }
+    size_t pos = (key * HASH_MULTIPLIER) & (SLOT_COUNT - 1);
+    for (size_t probe = 0; probe < SLOT_COUNT; probe++) {
+        Slot &slot = slots_[pos];
+        if (slot.generation != generation_) {
+            if (usedSlots_ >= MAX_USED_SLOTS) {
+                return false; // table is crowded, the message is just sent uncoalesced
+            }
+            slot.key = key;
+            slot.index = newIndex;
+            slot.generation = generation_;
+            usedSlots_++;
+            return false;
+        }
+        if (slot.key == key) {
+            oldIndex = slot.index;
+            slot.index = newIndex;
+            return true;
+        }
+        pos = (pos + 1) & (SLOT_COUNT - 1);
+    }
+    return false;
+}
+
+void MidiCoalesceIndex::Clear()
+{
+    usedSlots_ = 0;
+    generation_++;
+    if (generation_ == 0) {
+        // stale slots could match again after wrap around
+        slots_.fill(Slot{});
+        channelBarriers_.fill(Barrier{});
+        groupBarriers_.fill(Barrier{});
+        generation_ = 1;
+    }
+}
+} // namespace MIDI
+} // namespace OHOS
@@ -52,6 +52,8 @@ namespace {
     constexpr size_t MAX_UMP_PACKETS = 128;
     // Application UUID for BLE MIDI (standard Bluetooth MIDI UUID)
     static constexpr const char *BLE_MIDI_APP_UUID = "00000000-0000-0000-0000-000000000001";
+    // shortest BLE connection interval, values within one interval would share a packet anyway
+    constexpr uint64_t BLE_COALESCE_WINDOW_NS = 7500000;
 }
 
 static std::atomic<BleMidiTransportDeviceDriver*> instance;
@@ -686,5 +688,15 @@ int32_t BleMidiTransportDeviceDriver::HandleUmpInput(int64_t deviceId, uint32_t
         deviceId, list.size());
     return 0;
 }
+
+MidiDriverCapability BleMidiTransportDeviceDriver::GetOutputCapability(int64_t deviceId, uint32_t portIndex)
+{
+    (void)deviceId;
+    (void)portIndex;
+    MidiDriverCapability capability{};
+    capability.coalesceWindowNs = BLE_COALESCE_WINDOW_NS;
+    capability.asyncOutputDepth = MIDI_DEFAULT_ASYNC_OUTPUT_DEPTH;
+    return capability;
+}
 } // namespace MIDI
 } // namespace OHOS
\ No newline at end of file
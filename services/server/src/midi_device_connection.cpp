@@ -18,9 +18,12 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <cinttypes>
 #include <cstring>
 
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <sys/timerfd.h>
@@ -33,32 +36,53 @@
 
 namespace OHOS {
 namespace MIDI {
+namespace {
+constexpr uint32_t UMP_MT_SHIFT = 28;
+constexpr uint32_t UMP_STATUS_BYTE_SHIFT = 16;
+constexpr uint32_t UMP_STATUS_NIBBLE_SHIFT = 20;
+constexpr uint32_t NIBBLE_MASK = 0xF;
+constexpr uint32_t BYTE_MASK = 0xFF;
+constexpr uint32_t UMP_GROUP_SHIFT = 24;
+constexpr uint32_t UMP_CHANNEL_SHIFT = 16;
+constexpr uint32_t UMP_MT_UTILITY = 0x0;
+constexpr uint32_t UMP_MT_STREAM = 0xF;
+constexpr uint32_t UMP_MT_SYSTEM = 0x1;
+constexpr uint32_t UMP_MT_MIDI1_CHANNEL_VOICE = 0x2;
+constexpr uint32_t UMP_MT_MIDI2_CHANNEL_VOICE = 0x4;
+// packet size in words, indexed by message type
+constexpr size_t UMP_WORDS_BY_TYPE[] = {1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4};
+constexpr uint32_t MIDI1_TIME_CODE = 0xF1;
+constexpr uint32_t MIDI1_SONG_POSITION = 0xF2;
+constexpr uint32_t MIDI1_SONG_SELECT = 0xF3;
+constexpr uint32_t MIDI1_PROGRAM_CHANGE = 0xC;
+constexpr uint32_t MIDI1_CHANNEL_PRESSURE = 0xD;
+constexpr size_t MIDI1_TWO_BYTES = 2;
+constexpr size_t MIDI1_THREE_BYTES = 3;
+constexpr uint32_t MIDI1_REALTIME_FIRST = 0xF8;
+constexpr int64_t NS_PER_MS = 1000000;
+
+// tell the core we are spinning, keeps the sibling hyperthread and the power draw down
+inline void CpuRelax()
+{
+#if defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+} // namespace
 
 void DrainCounterFd(int fd)
 {
     if (fd < 0) {
         return;
     }
-    const int kMaxLoop = 16;
-    int loops = 0;
-
-    while (loops < kMaxLoop) {
-        uint64_t counter = 0;
-        const ssize_t ret = ::read(fd, &counter, sizeof(counter));
-        if (ret < 0) {
-            if (errno == EINTR) {
-                continue;
-            }
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                break;
-            }
-            break;
-        }
-        if (ret == 0) {
-            break;
-        }
-        loops++;
-    }
+    // one read returns and resets the whole eventfd/timerfd counter
+    uint64_t counter = 0;
+    ssize_t ret = 0;
+    do {
+        ret = ::read(fd, &counter, sizeof(counter));
+    } while (ret < 0 && errno == EINTR);
 }
 
 // ====== DeviceConnectionBase ======
@@ -75,39 +99,56 @@ int32_t DeviceConnectionBase::AddClientConnection(
         OH_MIDI_STATUS_SYSTEM_ERROR,
         "init client connection fail");
     buffer = clientConnection->GetRingBuffer();
-    clients_.push_back(std::move(clientConnection));
+    ClientList clients = *LoadClients();
+    clients.push_back(std::move(clientConnection));
+    PublishClients(std::move(clients));
     return OH_MIDI_STATUS_OK;
 }
 
 void DeviceConnectionBase::RemoveClientConnection(uint32_t clientId)
 {
     std::lock_guard<std::mutex> lock(clientsMutex_);
-    clients_.erase(
-        std::remove_if(clients_.begin(),
-            clients_.end(),
+    ClientList clients = *LoadClients();
+    clients.erase(
+        std::remove_if(clients.begin(),
+            clients.end(),
             [&](const std::shared_ptr<ClientConnectionInServer> &c) { return c && c->GetClientId() == clientId; }),
-        clients_.end());
+        clients.end());
+    PublishClients(std::move(clients));
 }
 
 bool DeviceConnectionBase::HasClientConnection(uint32_t clientId) const
 {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    return std::any_of(clients_.begin(), clients_.end(),
-        [&](const std::shared_ptr<ClientConnectionInServer> &c) {
-            return c && c->GetClientId() == clientId;
-        });
+    return FindClient(clientId) != nullptr;
 }
 
 bool DeviceConnectionBase::IsEmptyClientConnections()
 {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    return clients_.empty();
+    return LoadClients()->empty();
 }
 
-std::vector<std::shared_ptr<ClientConnectionInServer>> DeviceConnectionBase::SnapshotClients() const
+std::shared_ptr<const DeviceConnectionBase::ClientList> DeviceConnectionBase::LoadClients() const
 {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    return clients_;
+    auto clients = std::atomic_load_explicit(&clients_, std::memory_order_acquire);
+    if (clients == nullptr) {
+        static const auto emptyClients = std::make_shared<const ClientList>();
+        return emptyClients;
+    }
+    return clients;
+}
+
+std::shared_ptr<ClientConnectionInServer> DeviceConnectionBase::FindClient(uint32_t clientId) const
+{
+    auto clients = LoadClients();
+    auto it = std::find_if(clients->begin(), clients->end(),
+        [clientId](const auto &client) { return client != nullptr && client->GetClientId() == clientId; });
+    return it != clients->end() ? *it : nullptr;
+}
+
+void DeviceConnectionBase::PublishClients(ClientList &&clients)
+{
+    std::atomic_store_explicit(&clients_, std::shared_ptr<const ClientList>(
+        std::make_shared<const ClientList>(std::move(clients))), std::memory_order_release);
 }
 
 // ====== DeviceConnectionForInput ======
@@ -116,21 +157,116 @@ DeviceConnectionForInput::DeviceConnectionForInput(DeviceConnectionInfo info) :
 
 void DeviceConnectionForInput::HandleDeviceUmpInput(std::vector<MidiEventInner> &events)
 {
-    for (auto &event : events) {
-        BroadcastToClients(event);
+    CHECK_AND_RETURN(!events.empty());
+    BroadcastToClients(events);
+}
+
+int32_t DeviceConnectionForInput::AddFilteredClient(uint32_t clientId, int64_t deviceHandle,
+    std::shared_ptr<MidiSharedRing> &buffer, const MidiInputFilter &filter)
+{
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    auto clientConnection = std::make_shared<ClientConnectionInServer>(clientId, deviceHandle, GetInfo().portIndex);
+    CHECK_AND_RETURN_RET_LOG(clientConnection != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "creat client connection fail");
+    CHECK_AND_RETURN_RET_LOG(clientConnection->CreateRingBuffer() == OH_MIDI_STATUS_OK,
+        OH_MIDI_STATUS_SYSTEM_ERROR,
+        "init client connection fail");
+    clientConnection->SetInputFilter(filter);
+    buffer = clientConnection->GetRingBuffer();
+    ClientList clients = *LoadClients();
+    clients.push_back(std::move(clientConnection));
+    PublishClients(std::move(clients));
+    return OH_MIDI_STATUS_OK;
+}
+
+int32_t DeviceConnectionForInput::AddBroadcastClient(uint32_t clientId, std::shared_ptr<MidiBroadcastRing> &ring)
+{
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    auto broadcastRing = std::atomic_load(&broadcastRing_);
+    if (broadcastRing == nullptr) {
+        broadcastRing = MidiBroadcastRing::CreateFromLocal();
+        CHECK_AND_RETURN_RET_LOG(broadcastRing != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "create broadcast ring fail");
+        std::atomic_store(&broadcastRing_, broadcastRing);
     }
+    broadcastClients_.push_back(clientId);
+    ring = std::move(broadcastRing);
+    return OH_MIDI_STATUS_OK;
 }
 
-void DeviceConnectionForInput::BroadcastToClients(const MidiEventInner &ev)
+void DeviceConnectionForInput::RemoveClientConnection(uint32_t clientId)
 {
-    auto clients = SnapshotClients();
-    for (auto &c : clients) {
+    DeviceConnectionBase::RemoveClientConnection(clientId);
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    broadcastClients_.erase(std::remove(broadcastClients_.begin(), broadcastClients_.end(), clientId),
+        broadcastClients_.end());
+    if (broadcastClients_.empty()) {
+        std::atomic_store(&broadcastRing_, std::shared_ptr<MidiBroadcastRing>());
+    }
+}
+
+bool DeviceConnectionForInput::IsEmptyClientConnections()
+{
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    return LoadClients()->empty() && broadcastClients_.empty();
+}
+
+bool DeviceConnectionForInput::HasClientConnection(uint32_t clientId) const
+{
+    CHECK_AND_RETURN_RET(!DeviceConnectionBase::HasClientConnection(clientId), true);
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    return std::find(broadcastClients_.begin(), broadcastClients_.end(), clientId) != broadcastClients_.end();
+}
+
+void DeviceConnectionForInput::BroadcastToClients(const std::vector<MidiEventInner> &events)
+{
+    // no lock: opening or closing a port on the IPC threads never holds up delivery
+    auto clients = LoadClients();
+    auto broadcastRing = std::atomic_load(&broadcastRing_);
+    if (broadcastRing != nullptr) {
+        (void)broadcastRing->Publish(events.data(), events.size());
+    }
+    for (const auto &c : *clients) {
         if (!c)
             continue;
-        c->TrySendToClient(ev);  // debug: check return value
+        const MidiInputFilter &filter = c->GetInputFilter();
+        if (filter.IsPassAll()) {
+            c->TrySendToClient(events.data(), events.size());  // debug: check return value
+            continue;
+        }
+        filteredEvents_.clear();
+        for (const auto &event : events) {
+            if (PassInputFilter(filter, event)) {
+                filteredEvents_.push_back(event);
+            }
+        }
+        if (!filteredEvents_.empty()) {
+            c->TrySendToClient(filteredEvents_.data(), filteredEvents_.size());
+        }
     }
 }
 
+bool DeviceConnectionForInput::PassInputFilter(const MidiInputFilter &filter, const MidiEventInner &event)
+{
+    CHECK_AND_RETURN_RET(event.data != nullptr && event.length > 0, false);
+    const uint32_t word = event.data[0];
+    const uint32_t type = (word >> UMP_MT_SHIFT) & NIBBLE_MASK;
+    CHECK_AND_RETURN_RET((filter.droppedMessageTypes & (1u << type)) == 0, false);
+    if (type != UMP_MT_UTILITY && type != UMP_MT_STREAM) {
+        const uint32_t group = (word >> UMP_GROUP_SHIFT) & NIBBLE_MASK;
+        CHECK_AND_RETURN_RET((filter.droppedGroups & (1u << group)) == 0, false);
+    }
+    if (type == UMP_MT_MIDI1_CHANNEL_VOICE || type == UMP_MT_MIDI2_CHANNEL_VOICE) {
+        const uint32_t opcode = (word >> UMP_STATUS_NIBBLE_SHIFT) & NIBBLE_MASK;
+        const uint32_t channel = (word >> UMP_CHANNEL_SHIFT) & NIBBLE_MASK;
+        return (filter.droppedChannelStatus & (1u << opcode)) == 0 && (filter.droppedChannels & (1u << channel)) == 0;
+    }
+    if (type == UMP_MT_SYSTEM) {
+        const uint32_t status = (word >> UMP_STATUS_BYTE_SHIFT) & BYTE_MASK;
+        CHECK_AND_RETURN_RET(!filter.dropRealtime || status < MIDI1_REALTIME_FIRST, false);
+        return (filter.droppedSystemStatus & (1u << (status & NIBBLE_MASK))) == 0;
+    }
+    return true;
+}
+
 // ====== DeviceConnectionForOutput ======
 DeviceConnectionForOutput::DeviceConnectionForOutput(DeviceConnectionInfo info) : DeviceConnectionBase(info)
 {}
@@ -146,18 +282,60 @@ int32_t DeviceConnectionForOutput::AddClientConnection(
     uint32_t clientId, int64_t deviceHandle, std::shared_ptr<MidiSharedRing> &buffer)
 {
     std::lock_guard<std::mutex> lock(clientsMutex_);
-    int fd = dup(notifyEventFd_.Get());
-    CHECK_AND_RETURN_RET(fd >= 0, OH_MIDI_STATUS_SYSTEM_ERROR);
+    CHECK_AND_RETURN_RET(notifyEventFd_->Valid(), OH_MIDI_STATUS_SYSTEM_ERROR);
     auto clientConnection = std::make_shared<ClientConnectionInServer>(clientId, deviceHandle, GetInfo().portIndex);
     CHECK_AND_RETURN_RET_LOG(clientConnection != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "creat client connection fail");
-    CHECK_AND_RETURN_RET_LOG(clientConnection->CreateRingBuffer(fd) == OH_MIDI_STATUS_OK,
+    clientConnection->SetMaxPending(perClientMaxPendingEvents_);
+    clientConnection->SetMaxBytesPerSecond(perClientMaxBytesPerSecond_);
+    CHECK_AND_RETURN_RET_LOG(clientConnection->CreateRingBuffer(notifyEventFd_) == OH_MIDI_STATUS_OK,
         OH_MIDI_STATUS_SYSTEM_ERROR,
         "init client connection fail");
     buffer = clientConnection->GetRingBuffer();
-    clients_.push_back(std::move(clientConnection));
+    ClientList clients = *LoadClients();
+    clients.push_back(std::move(clientConnection));
+    UpdateDirectClient(clients);
+    PublishClients(std::move(clients));
     return OH_MIDI_STATUS_OK;
 }
 
+void DeviceConnectionForOutput::RemoveClientConnection(uint32_t clientId)
+{
+    DeviceConnectionBase::RemoveClientConnection(clientId);
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        UpdateDirectClient(*LoadClients());
+    }
+    WakeWorkerByEventFd();
+}
+
+int32_t DeviceConnectionForOutput::SetClientExclusive(uint32_t clientId, bool exclusive)
+{
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        auto client = FindClient(clientId);
+        CHECK_AND_RETURN_RET_LOG(client != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+            "client %{public}u not connected", clientId);
+        client->SetExclusiveRequested(exclusive);
+        UpdateDirectClient(*LoadClients());
+    }
+    WakeWorkerByEventFd();
+    return OH_MIDI_STATUS_OK;
+}
+
+bool DeviceConnectionForOutput::IsDirectMode() const
+{
+    return std::atomic_load(&directClient_) != nullptr;
+}
+
+void DeviceConnectionForOutput::UpdateDirectClient(const ClientList &clients)
+{
+    auto candidate = (clients.size() == 1 && clients[0] != nullptr && clients[0]->IsExclusiveRequested()) ?
+        clients[0] : nullptr;
+    CHECK_AND_RETURN(candidate != std::atomic_load(&directClient_));
+    MIDI_INFO_LOG("port %{public}u %{public}s direct mode", info_.portIndex, candidate ? "enter" : "leave");
+    std::atomic_store(&directClient_, std::move(candidate));
+}
+
 int32_t DeviceConnectionForOutput::Start()
 {
     bool expected = false;
@@ -170,6 +348,15 @@ int32_t DeviceConnectionForOutput::Start()
         running_.store(false);
         return rc;
     }
+    LoadDriverCapability();
+    if (asyncOutputDepth_ > 0) {
+        rc = submitter_.Start(info_.driver, info_.deviceId, info_.portIndex, asyncOutputDepth_,
+            [this]() { WakeWorkerByEventFd(); });
+        if (rc != OH_MIDI_STATUS_OK) {
+            running_.store(false);
+            return rc;
+        }
+    }
 
     worker_ = std::thread(&DeviceConnectionForOutput::ThreadMain, this);
     return OH_MIDI_STATUS_OK;
@@ -187,12 +374,13 @@ int32_t DeviceConnectionForOutput::Stop()
     if (worker_.joinable()) {
         worker_.join();
     }
+    submitter_.Stop();
     return OH_MIDI_STATUS_OK;
 }
 
 int DeviceConnectionForOutput::GetNotifyEventFdForClients() const
 {
-    return notifyEventFd_.Get();
+    return notifyEventFd_->Get();
 }
 
 void DeviceConnectionForOutput::SetPerClientMaxPendingEvents(size_t maxPendingEvents)
@@ -200,22 +388,123 @@ void DeviceConnectionForOutput::SetPerClientMaxPendingEvents(size_t maxPendingEv
     perClientMaxPendingEvents_ = maxPendingEvents;
 }
 
+void DeviceConnectionForOutput::SetPerClientMaxBytesPerSecond(uint64_t maxBytesPerSecond)
+{
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    perClientMaxBytesPerSecond_ = maxBytesPerSecond;
+}
+
 void DeviceConnectionForOutput::SetMaxSendCacheBytes(size_t maxSendCacheBytes)
 {
     maxSendCacheBytes_ = maxSendCacheBytes;
 }
 
+void DeviceConnectionForOutput::SetCoalescing(bool enable, uint64_t windowNs)
+{
+    coalesceWindowNs_.store(windowNs);
+    coalesceEnabled_.store(enable);
+}
+
+void DeviceConnectionForOutput::SetPerWakeupEventBudget(size_t eventBudget)
+{
+    perWakeupEventBudget_.store(eventBudget == 0 ? 1 : eventBudget);
+}
+
+int32_t DeviceConnectionForOutput::SetClientWeight(uint32_t clientId, uint32_t weight)
+{
+    auto client = FindClient(clientId);
+    CHECK_AND_RETURN_RET(client != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT);
+    client->SetWeight(weight);
+    return OH_MIDI_STATUS_OK;
+}
+
+void DeviceConnectionForOutput::SetWirePacing(uint64_t bytesPerSecond, uint64_t burstBytes, MidiWireFormat format)
+{
+    wireFormat_.store(format);
+    wirePacer_.Configure(bytesPerSecond, burstBytes);
+    WakeWorkerByEventFd();
+}
+
+void DeviceConnectionForOutput::SetPrecisionMode(bool enable)
+{
+    precisionMode_.store(enable);
+    WakeWorkerByEventFd();
+}
+
+void DeviceConnectionForOutput::SetBusyPoll(bool enable, uint64_t pollIntervalNs, int32_t cpu, uint64_t idleTimeoutNs)
+{
+    busyPollIntervalNs_.store(pollIntervalNs);
+    busyPollCpu_.store(cpu);
+    busyPollIdleTimeoutNs_.store(idleTimeoutNs);
+    busyPollEnabled_.store(enable);
+    WakeWorkerByEventFd();
+}
+
+bool DeviceConnectionForOutput::IsBusyPolling() const
+{
+    return busyPolling_.load();
+}
+
+void DeviceConnectionForOutput::SetSchedulingSlack(uint64_t slackNs)
+{
+    schedulingSlackNs_.store(slackNs);
+    WakeWorkerByEventFd();
+}
+
+uint64_t DeviceConnectionForOutput::GetSchedulingSlackNs() const
+{
+    // precision mode aims at the exact deadline, slack would only make it late
+    return precisionMode_.load() ? 0 : schedulingSlackNs_.load();
+}
+
+std::chrono::steady_clock::time_point DeviceConnectionForOutput::GetSlackDeadline(
+    const ClientList &clientsSnapshot, std::chrono::steady_clock::time_point earliestDueTime)
+{
+    const std::chrono::nanoseconds slack(GetSchedulingSlackNs());
+    CHECK_AND_RETURN_RET(slack.count() != 0, earliestDueTime);
+    // wait for the last event of the window so they go out together, with nothing else due there is no wait
+    const auto limit = earliestDueTime + slack;
+    auto deadline = earliestDueTime;
+    for (const auto &clientConnection : clientsSnapshot) {
+        std::chrono::steady_clock::time_point latestDue{};
+        if (clientConnection && clientConnection->FindLatestDueUntil(limit, latestDue)) {
+            deadline = std::max(deadline, latestDue);
+        }
+    }
+    return deadline;
+}
+
+void DeviceConnectionForOutput::LoadDriverCapability()
+{
+    lookahead_ = std::chrono::nanoseconds(0);
+    asyncOutputDepth_ = 0;
+    CHECK_AND_RETURN(info_.driver != nullptr);
+    MidiDriverCapability capability = info_.driver->GetOutputCapability(info_.deviceId, info_.portIndex);
+    asyncOutputDepth_ = capability.asyncOutputDepth;
+    if (capability.wireBytesPerSecond != 0) {
+        SetWirePacing(capability.wireBytesPerSecond, capability.wireBurstBytes, capability.wireFormat);
+        MIDI_INFO_LOG("driver link rate %{public}" PRIu64 " bytes/s", capability.wireBytesPerSecond);
+    }
+    if (capability.coalesceWindowNs != 0) {
+        SetCoalescing(true, capability.coalesceWindowNs);
+    }
+    CHECK_AND_RETURN(capability.supportsScheduledOutput);
+    lookahead_ = std::chrono::nanoseconds(capability.lookaheadNs);
+    MIDI_INFO_LOG("driver schedules output, lookahead %{public}" PRIu64 "ns", capability.lookaheadNs);
+}
+
 int32_t DeviceConnectionForOutput::InitEpollAndFds()
 {
     int eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
     if (eventFd < 0) {
         return OH_MIDI_STATUS_SYSTEM_ERROR;
     }
-    notifyEventFd_.Reset(eventFd);
+    // rings of the previous run keep their own eventfd object
+    notifyEventFd_ = std::make_shared<UniqueFd>(eventFd);
 
     int tfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
     if (tfd < 0) {
-        notifyEventFd_.Reset(-1);
+        notifyEventFd_->Reset(-1);
         return OH_MIDI_STATUS_SYSTEM_ERROR;
     }
     timerFd_.Reset(tfd);
@@ -223,7 +512,7 @@ int32_t DeviceConnectionForOutput::InitEpollAndFds()
     int epfd = ::epoll_create1(EPOLL_CLOEXEC);
     if (epfd < 0) {
         timerFd_.Reset(-1);
-        notifyEventFd_.Reset(-1);
+        notifyEventFd_->Reset(-1);
         return OH_MIDI_STATUS_SYSTEM_ERROR;
     }
     epollFd_.Reset(epfd);
@@ -231,7 +520,7 @@ int32_t DeviceConnectionForOutput::InitEpollAndFds()
     epoll_event evNotify{};
     evNotify.events = EPOLLIN;
     evNotify.data.u64 = kEpollTagNotifyEventFd;
-    if (::epoll_ctl(epollFd_.Get(), EPOLL_CTL_ADD, notifyEventFd_.Get(), &evNotify) != 0) {
+    if (::epoll_ctl(epollFd_.Get(), EPOLL_CTL_ADD, notifyEventFd_->Get(), &evNotify) != 0) {
         return OH_MIDI_STATUS_SYSTEM_ERROR;
     }
 
@@ -242,7 +531,7 @@ int32_t DeviceConnectionForOutput::InitEpollAndFds()
         0) {  // todo: timer epoll maybe no need, one fd enough?
         epollFd_.Reset(-1);
         timerFd_.Reset(-1);
-        notifyEventFd_.Reset(-1);
+        notifyEventFd_->Reset(-1);
         return OH_MIDI_STATUS_SYSTEM_ERROR;
     }
 
@@ -251,16 +540,18 @@ int32_t DeviceConnectionForOutput::InitEpollAndFds()
 
 void DeviceConnectionForOutput::WakeWorkerByEventFd()
 {
-    if (!notifyEventFd_.Valid()) {
+    if (!notifyEventFd_->Valid()) {
         return;
     }
+    // a polling worker does not look at the eventfd
+    wakeRequested_.store(true);
     const uint64_t one = 1;
-    (void)::write(notifyEventFd_.Get(), &one, sizeof(one));
+    (void)::write(notifyEventFd_->Get(), &one, sizeof(one));
 }
 
 void DeviceConnectionForOutput::DrainEventFd()
 {
-    DrainCounterFd(notifyEventFd_.Get());
+    DrainCounterFd(notifyEventFd_->Get());
 }
 
 void DeviceConnectionForOutput::DrainTimerFd()
@@ -270,93 +561,464 @@ void DeviceConnectionForOutput::DrainTimerFd()
 
 void DeviceConnectionForOutput::ThreadMain()
 {
+    precisionMargin_ = kPrecisionMarginDefault;
+    timerArmed_ = false; // a new timerfd every start
+    rerunPending_ = false;
     UpdateNextTimer();
 
     while (running_.load()) {
+        if (busyPolling_.load()) {
+            if (BusyPollForWork()) {
+                HandleWakeupOnce();
+            }
+            continue;
+        }
         epoll_event events[8]{};
-        const int readyCount = ::epoll_wait(epollFd_.Get(), events, 8, -1);
+        // 0: a backlog is left or a client wrote without notifying while we were busy, go round without sleeping
+        const int timeoutMs = rerunPending_ ? 0 : PrepareRingWait();
+        rerunPending_ = false;
+        int readyCount = 0;
+        if (timeoutMs != 0) {
+            readyCount = ::epoll_wait(epollFd_.Get(), events, 8, timeoutMs);
+            CountWorkerSyscalls(1);
+        }
         if (readyCount < 0) {
             if (errno == EINTR) {
                 continue;
             }
             break;
         }
-        DrainEventFd();
-        DrainTimerFd();
+        MarkRingReadersActive();
+        moderatedNapExpired_ = timeoutMs > 0 && readyCount == 0;
+        // only the fds epoll reported are read
+        bool timerExpired = false;
+        for (int i = 0; i < readyCount; i++) {
+            if (events[i].data.u64 == kEpollTagTimerFd) {
+                timerExpired = true;
+                timerArmed_ = false;
+                DrainTimerFd();
+            } else {
+                DrainEventFd();
+            }
+        }
+        CountWorkerSyscalls(static_cast<uint64_t>(readyCount));
 
+        if (timerExpired) {
+            UpdatePrecisionMargin();
+        }
+        if (busyPollEnabled_.load()) {
+            // any wakeup starts a polling period, it lasts until the port has been idle for the timeout
+            EnterBusyPoll();
+        }
         HandleWakeupOnce();
     }
+    LeaveBusyPoll();
+}
+
+void DeviceConnectionForOutput::EnterBusyPoll()
+{
+    lastPollWork_ = std::chrono::steady_clock::now();
+    const int32_t cpu = busyPollCpu_.load();
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        affinityPinned_ = pthread_getaffinity_np(pthread_self(), sizeof(savedAffinity_), &savedAffinity_) == 0 &&
+            pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+        if (!affinityPinned_) {
+            MIDI_WARNING_LOG("pin output worker to cpu %{public}d failed, errno %{public}d", cpu, errno);
+        }
+    }
+    busyPolling_.store(true);
+    MIDI_DEBUG_LOG("port %{public}u busy polling", info_.portIndex);
+}
+
+void DeviceConnectionForOutput::LeaveBusyPoll()
+{
+    CHECK_AND_RETURN(busyPolling_.load());
+    busyPolling_.store(false);
+    if (affinityPinned_) {
+        (void)pthread_setaffinity_np(pthread_self(), sizeof(savedAffinity_), &savedAffinity_);
+        affinityPinned_ = false;
+    }
+    // wakeups the polling worker has already seen would end the first wait at once
+    DrainEventFd();
+    if (wakeRequested_.exchange(false)) {
+        rerunPending_ = true;
+    }
+    // the rings go back to notifying once PrepareRingWait marks them sleeping
+    MIDI_DEBUG_LOG("port %{public}u back to waiting for notifications", info_.portIndex);
+}
+
+bool DeviceConnectionForOutput::HasPollWork(std::chrono::steady_clock::time_point now)
+{
+    bool hasWork = rerunPending_;
+    rerunPending_ = false;
+    if (timerArmed_ && now >= timerTarget_) {
+        // expired like a timerfd reported by epoll, its counter is left for the next epoll_wait
+        timerArmed_ = false;
+        hasWork = true;
+    }
+    if (wakeRequested_.load(std::memory_order_relaxed)) {
+        hasWork = wakeRequested_.exchange(false) || hasWork;
+    }
+    auto clients = LoadClients();
+    for (const auto &clientConnection : *clients) {
+        CHECK_AND_CONTINUE(clientConnection != nullptr);
+        auto ring = clientConnection->GetRingBuffer();
+        CHECK_AND_CONTINUE(ring != nullptr);
+        // clients added while polling start out idle
+        ring->MarkReaderPolling();
+        hasWork = ring->TakeWriteMark() || hasWork;
+    }
+    return hasWork;
+}
+
+bool DeviceConnectionForOutput::BusyPollForWork()
+{
+    const auto interval = std::chrono::nanoseconds(busyPollIntervalNs_.load());
+    const auto idleTimeout = std::chrono::nanoseconds(busyPollIdleTimeoutNs_.load());
+    while (running_.load() && busyPollEnabled_.load()) {
+        const auto now = std::chrono::steady_clock::now();
+        if (HasPollWork(now)) {
+            lastPollWork_ = now;
+            return true;
+        }
+        if (idleTimeout.count() > 0 && now - lastPollWork_ >= idleTimeout) {
+            break;
+        }
+        // no syscall here, steady_clock is read through the vdso
+        const auto nextPoll = now + interval;
+        do {
+            CpuRelax();
+        } while (interval.count() > 0 && std::chrono::steady_clock::now() < nextPoll);
+    }
+    LeaveBusyPoll();
+    return false;
+}
+
+int DeviceConnectionForOutput::PrepareRingWait()
+{
+    auto clients = LoadClients();
+    int64_t napNs = 0;
+    bool hasEvents = false;
+    bool unnotifiedWrites = false;
+    for (const auto &clientConnection : *clients) {
+        CHECK_AND_CONTINUE(clientConnection != nullptr);
+        auto ring = clientConnection->GetRingBuffer();
+        CHECK_AND_CONTINUE(ring != nullptr);
+        const int64_t delayNs = ring->GetNotifyDelayNs();
+        if (delayNs <= 0) {
+            unnotifiedWrites = ring->MarkReaderSleeping(RING_READER_IDLE) || unnotifiedWrites;
+            continue;
+        }
+        // events held back by moderation are collected by the nap, the write mark does not matter here
+        (void)ring->MarkReaderSleeping(moderatedNapExpired_ ? RING_READER_IDLE : RING_READER_NAPPING);
+        hasEvents = hasEvents || !ring->IsEmpty();
+        napNs = napNs == 0 ? delayNs : std::min(napNs, delayNs);
+    }
+    CHECK_AND_RETURN_RET(!unnotifiedWrites, 0);
+    CHECK_AND_RETURN_RET(napNs > 0, -1);
+    // events written while the writer still saw a nap may never be notified, one more nap collects them
+    CHECK_AND_RETURN_RET(!moderatedNapExpired_ || hasEvents, -1);
+    return static_cast<int>((napNs + NS_PER_MS - 1) / NS_PER_MS);
+}
+
+void DeviceConnectionForOutput::MarkRingReadersActive()
+{
+    auto clients = LoadClients();
+    for (const auto &clientConnection : *clients) {
+        CHECK_AND_CONTINUE(clientConnection != nullptr);
+        auto ring = clientConnection->GetRingBuffer();
+        CHECK_AND_CONTINUE(ring != nullptr);
+        ring->MarkReaderActive();
+    }
 }
 
 void DeviceConnectionForOutput::HandleWakeupOnce()
 {
-    DrainAllClientsRings(); // read event from shared_rings
+    if (!DrainDirectClientRing()) { // exclusive client: ring -> driver
+        DrainAllClientsRings(); // read event from shared_rings
+    }
+    WaitForPrecisionDeadline(); // precision mode: spin to the exact due time
     CollectDueEventsFromClientHeaps(); // collect due events
     FlushSendCacheToDriver(); // send to driver
     UpdateNextTimer(); // update timer
 }
 
 // ---------------- Step1: drain ring ----------------
+bool DeviceConnectionForOutput::DrainDirectClientRing()
+{
+    // nothing is read past a batch the driver still has, shared mode waits for it too
+    CHECK_AND_RETURN_RET(ReleaseDirectBatch(), true);
+    auto directClient = std::atomic_load(&directClient_);
+    CHECK_AND_RETURN_RET(directClient != nullptr, false);
+    // heap leftovers from shared mode go first, with every batch in the driver its completion brings us back
+    FlushSendCacheToDriver(false);
+    CHECK_AND_RETURN_RET(sendCache_.empty(), true);
+    MidiOutputSubmitter::Batch *batch = nullptr;
+    if (submitter_.IsRunning()) {
+        batch = submitter_.Acquire(false);
+        CHECK_AND_RETURN_RET(batch != nullptr, true);
+    }
+    std::vector<MidiEventInner> &events = (batch != nullptr) ? batch->events : directBatch_;
+    if (CollectDirectBatch(*directClient, events)) {
+        rerunPending_ = true;
+    }
+    if (events.empty()) {
+        if (batch != nullptr) {
+            submitter_.Release(batch);
+        }
+        return true;
+    }
+    sentEvents_.fetch_add(events.size(), std::memory_order_relaxed);
+    // sent without clientStateMutex_, so a driver that stops completing holds up only this port's output
+    if (batch != nullptr) {
+        submitter_.Submit(batch);
+    } else if (info_.driver != nullptr) {
+        (void)info_.driver->HandleUmpInput(info_.deviceId, info_.portIndex, directBatch_);
+    }
+    directBatch_.clear();
+    (void)ReleaseDirectBatch();
+    return true;
+}
+
+bool DeviceConnectionForOutput::CollectDirectBatch(ClientConnectionInServer &directClient,
+    std::vector<MidiEventInner> &events)
+{
+    std::lock_guard<std::mutex> lock(clientStateMutex_);
+    std::shared_ptr<MidiSharedRing> ringShared = directClient.GetRingBuffer();
+    CHECK_AND_RETURN_RET(ringShared != nullptr, false);
+    MidiSharedRing &clientRing = *ringShared;
+
+    // events go out in ring order, a scheduled one not due yet holds back the rest
+    const auto horizon = std::chrono::steady_clock::now() + lookahead_;
+    const size_t maxBatch = perWakeupEventBudget_.load();
+    MidiSharedRing::PeekedEvent ringEvent{};
+    MidiSharedRing::PeekedEvent lastEvent{};
+    MidiStatusCode status = clientRing.PeekNext(ringEvent);
+    while (status == MidiStatusCode::OK && events.size() < maxBatch) {
+        const auto dueTime = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(ringEvent.timestamp));
+        if ((ringEvent.timestamp != 0 && dueTime > horizon) || wirePacer_.IsLimited(std::chrono::steady_clock::now())) {
+            break;
+        }
+        const uint32_t *payloadWords = reinterpret_cast<const uint32_t *>(ringEvent.payloadPtr);
+        events.push_back(MidiEventInner{ringEvent.timestamp, ringEvent.length, payloadWords, ringEvent.tag});
+        ChargeWire(payloadWords, ringEvent.length);
+        lastEvent = ringEvent;
+        status = clientRing.PeekAfter(lastEvent, ringEvent);
+    }
+    if (!events.empty()) {
+        // the batch points into the ring, it is released only once the driver is done with it
+        directInFlightRing_ = ringShared;
+        directInFlightLast_ = lastEvent;
+    }
+    return events.size() >= maxBatch && status == MidiStatusCode::OK;
+}
+
+bool DeviceConnectionForOutput::ReleaseDirectBatch()
+{
+    std::lock_guard<std::mutex> lock(clientStateMutex_);
+    CHECK_AND_RETURN_RET(directInFlightRing_ != nullptr, true);
+    // batches complete in submission order, once all are back the direct one is too
+    CHECK_AND_RETURN_RET(!submitter_.IsRunning() || submitter_.IsIdle(), false);
+    directInFlightRing_->CommitRead(directDiscardPending_ ? directDiscardLast_ : directInFlightLast_);
+    directInFlightRing_ = nullptr;
+    directDiscardPending_ = false;
+    return true;
+}
+
+void DeviceConnectionForOutput::DiscardDirectRingAfterBatch()
+{
+    // everything written so far goes with the batch when it is released, later writes are kept
+    MidiSharedRing::PeekedEvent lastEvent = directDiscardPending_ ? directDiscardLast_ : directInFlightLast_;
+    MidiSharedRing::PeekedEvent nextEvent{};
+    while (directInFlightRing_->PeekAfter(lastEvent, nextEvent) == MidiStatusCode::OK) {
+        lastEvent = nextEvent;
+    }
+    directDiscardLast_ = lastEvent;
+    directDiscardPending_ = true;
+}
+
+bool DeviceConnectionForOutput::FindDirectRingDue(std::chrono::steady_clock::time_point &outDueTime)
+{
+    // the head of the ring is the batch in the driver, its completion wakes the worker
+    CHECK_AND_RETURN_RET(directInFlightRing_ == nullptr, false);
+    auto directClient = std::atomic_load(&directClient_);
+    CHECK_AND_RETURN_RET(directClient != nullptr, false);
+    auto ring = directClient->GetRingBuffer();
+    MidiSharedRing::PeekedEvent ringEvent{};
+    CHECK_AND_RETURN_RET(ring != nullptr && ring->PeekNext(ringEvent) == MidiStatusCode::OK, false);
+    outDueTime = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(ringEvent.timestamp));
+    return true;
+}
+
 void DeviceConnectionForOutput::DrainAllClientsRings()
 {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    for (const auto &clientConnection : clients_) {
+    auto clients = LoadClients();
+    std::lock_guard<std::mutex> lock(clientStateMutex_);
+    const size_t clientCount = clients->size();
+    bool hasBacklog = false;
+    // deficit round-robin, the starting client rotates so nobody always goes first
+    for (size_t i = 0; i < clientCount; i++) {
+        const auto &clientConnection = (*clients)[(drainCursor_ + i) % clientCount];
         if (!clientConnection) {
             continue;
         }
-        DrainSingleClientRing(*clientConnection);
+        clientConnection->AddDeficit(perWakeupEventBudget_.load() * clientConnection->GetWeight());
+        hasBacklog = DrainSingleClientRing(*clientConnection) || hasBacklog;
+    }
+    drainCursor_ = (clientCount == 0) ? 0 : (drainCursor_ + 1) % clientCount;
+    if (hasBacklog) {
+        // come back for the rest once this batch is flushed
+        rerunPending_ = true;
     }
 }
 
-void DeviceConnectionForOutput::DrainSingleClientRing(ClientConnectionInServer &clientConnection)
+bool DeviceConnectionForOutput::DrainSingleClientRing(ClientConnectionInServer &clientConnection)
 {
     std::shared_ptr<MidiSharedRing> ringShared = clientConnection.GetRingBuffer();
     if (!ringShared) {
-        return;
+        return false;
     }
     MidiSharedRing &clientRing = *ringShared;
     MidiSharedRing::PeekedEvent ringEvent{};
     MidiStatusCode status = MidiStatusCode::OK;
     while ((status = clientRing.PeekNext(ringEvent)) == MidiStatusCode::OK) {
-        if (status != MidiStatusCode::OK) {
-            break;
+        if (!clientConnection.HasDeficit()) {
+            return true;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (clientConnection.IsRateLimited(now)) {
+            return false; // UpdateNextTimer wakes us when the rate budget is back
         }
         if (ringEvent.timestamp == 0) {  // todo: use func and judge if timestamp + 1 < now
+            if (wirePacer_.IsLimited(now)) {
+                return false; // the link is busy, leave it in the ring until the pacer refills
+            }
             if (!ConsumeRealtimeEvent(clientRing, ringEvent)) {
                 break;
             }
+            ChargeClientForEvent(clientConnection, ringEvent);
             continue;
         }
         if (!ConsumeNonRealtimeEvent(clientConnection, clientRing, ringEvent)) {
             // 堆满/入堆失败：不 CommitRead，保留共享内存，停止读取该 client
+            DrainRealtimeLane(clientConnection, clientRing, ringEvent);
             break;
         }
+        ChargeClientForEvent(clientConnection, ringEvent);
     }
+    // nothing left to send, unused credit is not carried over
+    clientConnection.ResetDeficit();
+    return false;
 }
 
-bool DeviceConnectionForOutput::ConsumeRealtimeEvent(MidiSharedRing& clientRing,
-                                                     const MidiSharedRing::PeekedEvent& ringEvent)
+void DeviceConnectionForOutput::ChargeClientForEvent(ClientConnectionInServer &clientConnection,
+                                                     const MidiSharedRing::PeekedEvent &ringEvent)
+{
+    clientConnection.UseDeficit();
+    clientConnection.ChargeRate(static_cast<size_t>(ringEvent.length) * sizeof(uint32_t));
+    if (ringEvent.timestamp == 0) {
+        // scheduled events are charged to the link when they leave the heap
+        ChargeWire(reinterpret_cast<const uint32_t *>(ringEvent.payloadPtr), ringEvent.length);
+    }
+}
+
+void DeviceConnectionForOutput::ChargeWire(const uint32_t *payloadWords, size_t payloadWordCount)
+{
+    CHECK_AND_RETURN(wirePacer_.IsEnabled());
+    const size_t wireBytes = (wireFormat_.load() == MidiWireFormat::MIDI1_BYTE_STREAM) ?
+        GetMidi1WireBytes(payloadWords, payloadWordCount) : payloadWordCount * sizeof(uint32_t);
+    wirePacer_.Charge(wireBytes);
+}
+
+size_t DeviceConnectionForOutput::GetMidi1WireBytes(const uint32_t *payloadWords, size_t payloadWordCount)
+{
+    size_t wireBytes = 0;
+    size_t offset = 0;
+    while (offset < payloadWordCount) {
+        const uint32_t word = payloadWords[offset];
+        const uint32_t messageType = word >> UMP_MT_SHIFT;
+        const uint32_t statusNibble = (word >> UMP_STATUS_NIBBLE_SHIFT) & NIBBLE_MASK;
+        const uint32_t statusByte = (word >> UMP_STATUS_BYTE_SHIFT) & BYTE_MASK;
+        switch (messageType) {
+            case UMP_MT_SYSTEM:
+                wireBytes += (statusByte == MIDI1_SONG_POSITION) ? MIDI1_THREE_BYTES :
+                    ((statusByte == MIDI1_TIME_CODE || statusByte == MIDI1_SONG_SELECT) ? MIDI1_TWO_BYTES : 1);
+                break;
+            case UMP_MT_MIDI1_CHANNEL_VOICE:
+            case UMP_MT_MIDI2_CHANNEL_VOICE:
+                // MIDI 2.0 voice messages are translated down to their MIDI 1.0 counterpart
+                wireBytes += (statusNibble == MIDI1_PROGRAM_CHANGE || statusNibble == MIDI1_CHANNEL_PRESSURE) ?
+                    MIDI1_TWO_BYTES : MIDI1_THREE_BYTES;
+                break;
+            case UMP_TYPE_3: {
+                const uint32_t byteCount = (word >> UMP_STATUS_BYTE_SHIFT) & NIBBLE_MASK;
+                // F0 precedes a complete or start packet, F7 follows a complete or end packet
+                const bool hasStart = statusNibble == SYSEX7_COMPLETE || statusNibble == SYSEX7_START;
+                const bool hasEnd = statusNibble == SYSEX7_COMPLETE || statusNibble == SYSEX7_END;
+                wireBytes += byteCount + (hasStart ? 1 : 0) + (hasEnd ? 1 : 0);
+                break;
+            }
+            default:
+                break; // no MIDI 1.0 equivalent, nothing goes on the wire
+        }
+        offset += UMP_WORDS_BY_TYPE[messageType];
+    }
+    return wireBytes;
+}
+
+void DeviceConnectionForOutput::DrainRealtimeLane(ClientConnectionInServer &clientConnection,
+    MidiSharedRing &clientRing, const MidiSharedRing::PeekedEvent &blockedEvent)
+{
+    // scheduled events stay in the ring until the heap has room, immediate ones behind them are sent now;
+    // while the same event blocks the head the scan goes on from where the last one stopped
+    MidiSharedRing::PeekedEvent laneEvent = blockedEvent;
+    (void)clientRing.GetScanPosition(laneEvent);
+    MidiSharedRing::PeekedEvent nextEvent{};
+    while (clientRing.PeekAfter(laneEvent, nextEvent) == MidiStatusCode::OK) {
+        if (nextEvent.timestamp == 0) {
+            const auto now = std::chrono::steady_clock::now();
+            if (!clientConnection.HasDeficit() || clientConnection.IsRateLimited(now) || wirePacer_.IsLimited(now)) {
+                break;
+            }
+            SendRealtimeEvent(nextEvent);
+            clientRing.MarkConsumed(nextEvent);
+            ChargeClientForEvent(clientConnection, nextEvent);
+        }
+        laneEvent = nextEvent;
+    }
+    clientRing.SetScanPosition(laneEvent);
+}
+
+void DeviceConnectionForOutput::SendRealtimeEvent(const MidiSharedRing::PeekedEvent &ringEvent)
 {
     const size_t payloadWordCount = static_cast<size_t>(ringEvent.length);
     const uint32_t* payloadWords =
         reinterpret_cast<const uint32_t*>(ringEvent.payloadPtr);
 
     // try enqueue send cache
-    auto res = TryAppendToSendCache(ringEvent.timestamp, payloadWords, payloadWordCount);
-    if (res) {
-        clientRing.CommitRead(ringEvent);
-        return true;
+    if (TryAppendToSendCache(ringEvent.timestamp, payloadWords, payloadWordCount)) {
+        return;
     }
     // if unable to enqueue, flush the send cache, and try again
     FlushSendCacheToDriver();
     if (!TryAppendToSendCache(ringEvent.timestamp, payloadWords, payloadWordCount)) {
+        // the cache is still full because every batch is busy, or the event is larger than the whole cache
+        // (only with a cache shrunk below the client ring size); the caller commits the read after we return
         MidiEventInner directEvent {};
         directEvent.timestamp = ringEvent.timestamp;
         directEvent.length = payloadWordCount;
         directEvent.data = payloadWords;
-        SendToDriver(directEvent);
+        (void)SendToDriver(directEvent);
     }
+}
 
+bool DeviceConnectionForOutput::ConsumeRealtimeEvent(MidiSharedRing& clientRing,
+                                                     const MidiSharedRing::PeekedEvent& ringEvent)
+{
+    SendRealtimeEvent(ringEvent);
     clientRing.CommitRead(ringEvent);
     return true;
 }
@@ -382,7 +1044,8 @@ bool DeviceConnectionForOutput::ConsumeNonRealtimeEvent(ClientConnectionInServer
         CHECK_AND_RETURN_RET_LOG(ret == 0, false, "memcpy_s failed: %{public}d", ret);
     }
 
-    const bool enqueued = clientConnection.EnqueueNonRealtime(std::move(payloadWords), dueTime, ringEvent.timestamp);
+    const bool enqueued =
+        clientConnection.EnqueueNonRealtime(std::move(payloadWords), dueTime, ringEvent.timestamp, ringEvent.tag);
     if (!enqueued) {
         return false;
     }
@@ -394,35 +1057,31 @@ bool DeviceConnectionForOutput::ConsumeNonRealtimeEvent(ClientConnectionInServer
 // ---------------- Step2: collect due from per-client heaps ----------------
 void DeviceConnectionForOutput::CollectDueEventsFromClientHeaps()
 {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    auto now = std::chrono::steady_clock::now();
+    auto clients = LoadClients();
+    std::lock_guard<std::mutex> lock(clientStateMutex_);
+    auto horizon = std::chrono::steady_clock::now() + lookahead_;
     std::chrono::steady_clock::time_point earliestDueTime {};
 
-    while (auto earliestClient = FindClientWithEarliestDue(clients_, earliestDueTime)) {
-        if (earliestDueTime > now) {
+    while (auto earliestClient = FindClientWithEarliestDue(*clients, earliestDueTime)) {
+        if (earliestDueTime > horizon || wirePacer_.IsLimited(std::chrono::steady_clock::now())) {
             break;
         }
 
-        ClientConnectionInServer::PendingEvent dueEvent;
-        if (!earliestClient->PopPendingTop(dueEvent)) {
+        MidiEventInner dueMidiEvent {};
+        if (!earliestClient->PopNextDue(dueMidiEvent)) {
             break;
         }
 
-        MidiEventInner dueMidiEvent;
-        dueMidiEvent.timestamp = dueEvent.timestamp;
-        dueMidiEvent.length = dueEvent.data.size();
-        dueMidiEvent.data = dueEvent.data.data();
-
-        // try enqueue send cache
-        auto res = TryAppendToSendCache(dueEvent.timestamp, dueEvent.data.data(), dueEvent.data.size());
-        CHECK_AND_RETURN(res != true);
-        FlushSendCacheToDriver();
-
-        if (!TryAppendToSendCache(dueEvent.timestamp, dueEvent.data.data(), dueEvent.data.size())) {
-            SendToDriver(dueMidiEvent);
+        // try enqueue send cache, timestamp is kept so a scheduling driver can do the final timing
+        if (!TryAppendToSendCache(dueMidiEvent.timestamp, dueMidiEvent.data, dueMidiEvent.length)) {
+            FlushSendCacheToDriver();
+            if (!TryAppendToSendCache(dueMidiEvent.timestamp, dueMidiEvent.data, dueMidiEvent.length)) {
+                (void)SendToDriver(dueMidiEvent);
+            }
         }
+        ChargeWire(dueMidiEvent.data, dueMidiEvent.length);
 
-        now = std::chrono::steady_clock::now();
+        horizon = std::chrono::steady_clock::now() + lookahead_;
     }
 }
 
@@ -447,25 +1106,44 @@ bool DeviceConnectionForOutput::TryAppendToSendCache(uint64_t timestamp,
         return false;
     }
 
-    std::vector<uint32_t> payloadBuffer;
+    // payload vectors come back from the driver with their capacity, reuse them before adding new ones
+    if (sendCachePayloadCount_ == sendCachePayloadBuffers_.size()) {
+        sendCachePayloadBuffers_.emplace_back();
+    }
+    std::vector<uint32_t> &payloadBuffer = sendCachePayloadBuffers_[sendCachePayloadCount_];
     payloadBuffer.resize(payloadWordCount);
     auto ret = memcpy_s(payloadBuffer.data(), payloadBytes, payloadWords, payloadBytes);
     CHECK_AND_RETURN_RET_LOG(ret == 0, false, "copy error");
+    sendCachePayloadCount_++;
     MidiEventInner cachedEvent {};
     cachedEvent.timestamp = timestamp;
     cachedEvent.length = payloadWordCount;
-    cachedEvent.data = nullptr;
-
-    sendCachePayloadBuffers_.push_back(std::move(payloadBuffer));
-    cachedEvent.data = sendCachePayloadBuffers_.back().data();
+    cachedEvent.data = payloadBuffer.data();
     sendCache_.push_back(cachedEvent);
 
     currentSendCacheBytes_ += payloadBytes;
+    CoalesceLastCachedEvent();
     return true;
 }
 
+void DeviceConnectionForOutput::CoalesceLastCachedEvent()
+{
+    CHECK_AND_RETURN(coalesceEnabled_.load());
+    const uint32_t newIndex = static_cast<uint32_t>(sendCache_.size() - 1);
+    const MidiEventInner &newEvent = sendCache_[newIndex];
+    uint32_t oldIndex = 0;
+    CHECK_AND_RETURN(coalesceIndex_.Exchange(newEvent.data, newEvent.length, newIndex, oldIndex));
+    MidiEventInner &oldEvent = sendCache_[oldIndex];
+    CHECK_AND_RETURN(oldEvent.length != 0 && newEvent.timestamp >= oldEvent.timestamp &&
+        newEvent.timestamp - oldEvent.timestamp <= coalesceWindowNs_.load());
+    // the newer value keeps its own position, so it is never sent before messages that preceded it
+    currentSendCacheBytes_ -= oldEvent.length * sizeof(uint32_t);
+    oldEvent.length = 0;
+    coalescedCount_++;
+}
+
 std::shared_ptr<ClientConnectionInServer> DeviceConnectionForOutput::FindClientWithEarliestDue(
-    const std::vector<std::shared_ptr<ClientConnectionInServer>> &clientsSnapshot,
+    const ClientList &clientsSnapshot,
     std::chrono::steady_clock::time_point &outEarliestDueTime)
 {
     std::shared_ptr<ClientConnectionInServer> bestClient = nullptr;
@@ -475,79 +1153,263 @@ std::shared_ptr<ClientConnectionInServer> DeviceConnectionForOutput::FindClientW
         if (!clientConnection) {
             continue;
         }
-        const auto *top = clientConnection->PeekPendingTop();
-        if (!top) {
+        std::chrono::steady_clock::time_point dueTime {};
+        if (!clientConnection->PeekNextDue(dueTime)) {
             continue;
         }
 
-        if (!hasCandidate || top->due < outEarliestDueTime) {
+        if (!hasCandidate || dueTime < outEarliestDueTime) {
             hasCandidate = true;
-            outEarliestDueTime = top->due;
+            outEarliestDueTime = dueTime;
             bestClient = clientConnection;
         }
     }
     return bestClient;
 }
 
-void DeviceConnectionForOutput::FlushSendCacheToDriver()
+void DeviceConnectionForOutput::FlushSendCacheToDriver(bool waitForBatch)
 {
     if (sendCache_.empty()) {
         return;
     }
     CHECK_AND_RETURN_LOG(info_.driver != nullptr, "driver is null!");
-    info_.driver->HandleUmpInput(info_.deviceId, info_.portIndex, sendCache_);
+    MidiOutputSubmitter::Batch *batch = nullptr;
+    if (submitter_.IsRunning()) {
+        batch = submitter_.Acquire(waitForBatch);
+        // every batch is in the driver, the completion wakes the worker to flush again;
+        // until then the cache and its coalescing index stay as they are
+        CHECK_AND_RETURN(batch != nullptr);
+    }
+    coalesceIndex_.Clear();
+    if (coalescedCount_ > 0) {
+        sendCache_.erase(std::remove_if(sendCache_.begin(), sendCache_.end(),
+            [](const MidiEventInner &event) { return event.length == 0; }), sendCache_.end());
+        coalescedCount_ = 0;
+    }
+    const size_t eventCount = sendCache_.size();
+    if (batch != nullptr) {
+        // hand over the cache, the batch's cleared vectors come back with their capacity
+        batch->events.swap(sendCache_);
+        batch->payloads.swap(sendCachePayloadBuffers_);
+        submitter_.Submit(batch);
+    } else {
+        info_.driver->HandleUmpInput(info_.deviceId, info_.portIndex, sendCache_);
+    }
+    sentEvents_.fetch_add(eventCount, std::memory_order_relaxed);
     sendCache_.clear();
-    sendCachePayloadBuffers_.clear();
+    sendCachePayloadCount_ = 0;
     currentSendCacheBytes_ = 0;
 }
 
-void DeviceConnectionForOutput::SendToDriver(MidiEventInner event)
+int32_t DeviceConnectionForOutput::SendToDriver(const MidiEventInner &event)
 {
-    (void)event;
+    CHECK_AND_RETURN_RET_LOG(info_.driver != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "driver is null!");
+    // keep order: everything cached before this event goes out first
+    FlushSendCacheToDriver(true);
+    sentEvents_.fetch_add(1, std::memory_order_relaxed);
+    if (submitter_.IsRunning()) {
+        // the payload may live in a client ring that is released once we return, the batch gets a copy;
+        // in place sending of ring payloads with an async driver is left to the exclusive mode
+        MidiOutputSubmitter::Batch *batch = submitter_.Acquire(true);
+        CHECK_AND_RETURN_RET(batch != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR);
+        if (batch->payloads.empty()) {
+            batch->payloads.emplace_back();
+        }
+        std::vector<uint32_t> &payload = batch->payloads.front();
+        payload.assign(event.data, event.data + event.length);
+        batch->events.push_back(MidiEventInner{event.timestamp, event.length, payload.data(), event.tag});
+        submitter_.Submit(batch);
+        return OH_MIDI_STATUS_OK;
+    }
+    directSendEvents_.clear();
+    directSendEvents_.push_back(event);
+    int32_t ret = info_.driver->HandleUmpInput(info_.deviceId, info_.portIndex, directSendEvents_);
+    directSendEvents_.clear();
+    CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "direct send of %{public}zu words failed: %{public}d",
+        event.length, ret);
+    return OH_MIDI_STATUS_OK;
 }
 
 // ---------------- Step4: timerfd ----------------
 void DeviceConnectionForOutput::UpdateNextTimer()
 {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    bool hasDue = false;
+    auto clients = LoadClients();
+    std::lock_guard<std::mutex> lock(clientStateMutex_);
     std::chrono::steady_clock::time_point earliestDueTime{};
-
-    for (const auto &clientConnection : clients_) {
-        if (!clientConnection) {
-            continue;
-        }
-        const auto *top = clientConnection->PeekPendingTop();
-        if (!top) {
-            continue;
+    bool hasDue = FindClientWithEarliestDue(*clients, earliestDueTime) != nullptr;
+    if (hasDue) {
+        // wake up one lookahead window early, the driver takes over the final timing
+        earliestDueTime = GetSlackDeadline(*clients, earliestDueTime) - lookahead_;
+        if (precisionMode_.load()) {
+            // the rest of the way is covered by WaitForPrecisionDeadline
+            earliestDueTime -= precisionMargin_;
         }
-        if (!hasDue || top->due < earliestDueTime) {
+    }
+    std::chrono::steady_clock::time_point directDueTime{};
+    if (FindDirectRingDue(directDueTime)) {
+        // the direct ring has no server-side scheduling, it is not held back for a batch
+        directDueTime -= lookahead_;
+        if (!hasDue || directDueTime < earliestDueTime) {
             hasDue = true;
-            earliestDueTime = top->due;
+            earliestDueTime = directDueTime;
         }
     }
+    if (hasDue && wirePacer_.IsLimited(std::chrono::steady_clock::now())) {
+        // due events wait for the link, not just for their timestamp
+        earliestDueTime = std::max(earliestDueTime, wirePacer_.GetResumeTime());
+    }
+    std::chrono::steady_clock::time_point resumeTime{};
+    if (FindEarliestRateResume(*clients, resumeTime) && (!hasDue || resumeTime < earliestDueTime)) {
+        hasDue = true;
+        earliestDueTime = resumeTime;
+    }
+
+    // the deadline is absolute, so a timer still armed for it needs no new timerfd_settime
+    CHECK_AND_RETURN(hasDue != timerArmed_ || (hasDue && earliestDueTime != timerTarget_));
 
     itimerspec newValue{};  // defaul all zero, hasDue == false to disarm
     if (hasDue) {
-        auto now = std::chrono::steady_clock::now();
-        if (earliestDueTime < now) {
-            earliestDueTime = now;
+        timerTarget_ = earliestDueTime;
+        // steady_clock is CLOCK_MONOTONIC, a deadline already passed expires at once;
+        // all-zero it_value would disarm the timer, keep at least 1ns
+        const auto deadlineNs = std::max<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(earliestDueTime.time_since_epoch()).count(), 1);
+        newValue.it_value.tv_sec = static_cast<time_t>(deadlineNs / MIDI_NS_PER_SECOND);
+        newValue.it_value.tv_nsec = static_cast<long>(deadlineNs % MIDI_NS_PER_SECOND);
+    }
+
+    (void)::timerfd_settime(timerFd_.Get(), TFD_TIMER_ABSTIME, &newValue, nullptr);
+    timerArmed_ = hasDue;
+    CountWorkerSyscalls(1);
+}
+
+void DeviceConnectionForOutput::CountWorkerSyscalls(uint64_t count)
+{
+    workerSyscalls_.store(workerSyscalls_.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+uint64_t DeviceConnectionForOutput::GetWorkerSyscallCount() const
+{
+    return workerSyscalls_.load(std::memory_order_relaxed);
+}
+
+uint64_t DeviceConnectionForOutput::GetSentEventCount() const
+{
+    return sentEvents_.load(std::memory_order_relaxed);
+}
+
+bool DeviceConnectionForOutput::FindEarliestRateResume(const ClientList &clients,
+    std::chrono::steady_clock::time_point &outResumeTime)
+{
+    const auto now = std::chrono::steady_clock::now();
+    const bool wireLimited = wirePacer_.IsLimited(now);
+    bool hasResume = false;
+    for (const auto &clientConnection : clients) {
+        CHECK_AND_CONTINUE(clientConnection != nullptr);
+        auto ring = clientConnection->GetRingBuffer();
+        CHECK_AND_CONTINUE(ring != nullptr && !ring->IsEmpty());
+        const bool clientLimited = clientConnection->IsRateLimited(now);
+        CHECK_AND_CONTINUE(clientLimited || wireLimited);
+        auto resumeTime = clientLimited ? clientConnection->GetRateResumeTime() : now;
+        if (wireLimited) {
+            resumeTime = std::max(resumeTime, wirePacer_.GetResumeTime());
+        }
+        if (!hasResume || resumeTime < outResumeTime) {
+            hasResume = true;
+            outResumeTime = resumeTime;
         }
-        const auto deltaNs = std::chrono::duration_cast<std::chrono::nanoseconds>(earliestDueTime - now).count();
-        newValue.it_value.tv_sec = static_cast<time_t>(deltaNs / MIDI_NS_PER_SECOND);
-        newValue.it_value.tv_nsec = static_cast<long>(deltaNs % MIDI_NS_PER_SECOND);
     }
+    return hasResume;
+}
 
-    (void)::timerfd_settime(timerFd_.Get(), 0, &newValue, nullptr);
+void DeviceConnectionForOutput::WaitForPrecisionDeadline()
+{
+    CHECK_AND_RETURN(precisionMode_.load());
+    std::chrono::steady_clock::time_point deadline{};
+    {
+        auto clients = LoadClients();
+        std::lock_guard<std::mutex> lock(clientStateMutex_);
+        CHECK_AND_RETURN(FindClientWithEarliestDue(*clients, deadline) != nullptr);
+    }
+    deadline -= lookahead_;
+    auto now = std::chrono::steady_clock::now();
+    // only the final approach is spun, anything further out is left to the timer
+    CHECK_AND_RETURN(deadline > now && deadline - now <= precisionMargin_);
+
+    while (running_.load() && now < deadline) {
+        const auto remaining = deadline - now;
+        if (remaining > kPrecisionSpinThreshold) {
+            std::this_thread::sleep_for(remaining - kPrecisionSpinThreshold);
+        } else {
+            std::this_thread::yield();
+        }
+        now = std::chrono::steady_clock::now();
+    }
+}
+
+void DeviceConnectionForOutput::UpdatePrecisionMargin()
+{
+    CHECK_AND_RETURN(precisionMode_.load());
+    const auto lateness = std::chrono::steady_clock::now() - timerTarget_;
+    CHECK_AND_RETURN(lateness.count() >= 0);
+    // keep twice the observed lateness as margin, smoothed to ignore a single outlier
+    const auto wanted = std::chrono::duration_cast<std::chrono::nanoseconds>(lateness) * 2;
+    auto margin = (precisionMargin_ * (kPrecisionMarginSmoothing - 1) + wanted) / kPrecisionMarginSmoothing;
+    precisionMargin_ = std::clamp(margin, kPrecisionMarginMin, kPrecisionMarginMax);
 }
 
 void DeviceConnectionForOutput::FlushClientCache(uint32_t clientId)
 {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    for (auto client: clients_) {
-        CHECK_AND_CONTINUE(client->GetClientId() == clientId);
-        client->Flush();
+    auto client = FindClient(clientId);
+    CHECK_AND_RETURN(client != nullptr);
+    std::lock_guard<std::mutex> lock(clientStateMutex_);
+    if (directInFlightRing_ != nullptr && directInFlightRing_ == client->GetRingBuffer()) {
+        // the driver still reads from the ring, it is not cleared under it
+        client->FlushScheduled();
+        DiscardDirectRingAfterBatch();
+        return;
     }
+    client->Flush();
+}
+
+int32_t DeviceConnectionForOutput::CreateClientTimeline(uint32_t clientId, uint32_t capacityBytes,
+    std::shared_ptr<MidiSharedTimeline> &timeline)
+{
+    auto client = FindClient(clientId);
+    CHECK_AND_RETURN_RET_LOG(client != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "client %{public}u not connected", clientId);
+    std::lock_guard<std::mutex> lock(clientStateMutex_);
+    auto existing = client->GetTimeline();
+    if (existing != nullptr) {
+        // opening twice hands out the same region
+        CHECK_AND_RETURN_RET_LOG(existing->GetCapacity() == capacityBytes, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+            "timeline already open with %{public}u bytes", existing->GetCapacity());
+        timeline = existing;
+        return OH_MIDI_STATUS_OK;
+    }
+    CHECK_AND_RETURN_RET(notifyEventFd_->Valid(), OH_MIDI_STATUS_SYSTEM_ERROR);
+    CHECK_AND_RETURN_RET_LOG(client->CreateTimeline(capacityBytes, notifyEventFd_) == OH_MIDI_STATUS_OK,
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "create timeline of %{public}u bytes fail", capacityBytes);
+    timeline = client->GetTimeline();
+    return OH_MIDI_STATUS_OK;
+}
+
+int32_t DeviceConnectionForOutput::CancelClientEvents(uint32_t clientId, uint16_t tag, uint64_t beginTimestamp,
+    uint64_t endTimestamp)
+{
+    CHECK_AND_RETURN_RET_LOG(beginTimestamp <= endTimestamp, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "invalid time range");
+    {
+        auto client = FindClient(clientId);
+        CHECK_AND_RETURN_RET_LOG(client != nullptr, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+            "client %{public}u not connected", clientId);
+        std::lock_guard<std::mutex> lock(clientStateMutex_);
+        const size_t cancelled = client->CancelScheduled(tag, beginTimestamp, endTimestamp);
+        MIDI_DEBUG_LOG("client %{public}u cancelled %{public}zu events, tag %{public}u", clientId, cancelled, tag);
+    }
+    // the earliest due event may be gone, let the worker re-arm the timer
+    WakeWorkerByEventFd();
+    return OH_MIDI_STATUS_OK;
 }
 
 }  // namespace MIDI
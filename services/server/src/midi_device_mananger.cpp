@@ -21,20 +21,45 @@
 #include "midi_device_usb.h"
 #include "midi_device_ble.h"
 #include "midi_log.h"
+#include "midi_utils.h"
+#include "parameters.h"
 
 namespace OHOS {
 namespace MIDI {
 namespace {
 constexpr int32_t AUDIO_CLASS_ID = 1;
 constexpr int32_t MIDI_SUBCLASS_ID = 3;
+const char *const PARAM_USB_DIN_DEVICES = "persist.multimedia.midi.usb.din_devices";
+const char *const PARAM_INPUT_DISPATCH_THREAD = "persist.multimedia.midi.input.dispatch_thread";
+const char *const PARAM_OUTPUT_PRECISION = "persist.multimedia.midi.output.precision";
+const char *const PARAM_OUTPUT_SLACK_US = "persist.multimedia.midi.output.slack_us";
+const char *const PARAM_OUTPUT_CLIENT_MAX_BPS = "persist.multimedia.midi.output.client_max_bytes_per_second";
+const char *const PARAM_OUTPUT_CLIENT_WEIGHTS = "persist.multimedia.midi.output.client_weights";
+const char *const PARAM_OUTPUT_BUSY_POLL = "persist.multimedia.midi.output.busypoll";
+const char *const PARAM_OUTPUT_BUSY_POLL_INTERVAL_US = "persist.multimedia.midi.output.busypoll_interval_us";
+const char *const PARAM_OUTPUT_BUSY_POLL_CPU = "persist.multimedia.midi.output.busypoll_cpu";
+const char *const PARAM_OUTPUT_BUSY_POLL_IDLE_MS = "persist.multimedia.midi.output.busypoll_idle_ms";
+constexpr uint64_t MAX_OUTPUT_SLACK_US = 10000;
+constexpr uint64_t MAX_BUSY_POLL_INTERVAL_US = 1000;
+constexpr uint64_t DEFAULT_BUSY_POLL_IDLE_MS = 1000;
+constexpr int32_t MAX_BUSY_POLL_CPU = 1023;
+constexpr uint32_t DEFAULT_CLIENT_WEIGHT = 1;
+constexpr uint32_t MAX_CLIENT_WEIGHT = 16;
+constexpr uint64_t NSEC_PER_USEC = 1000;
+constexpr uint64_t NSEC_PER_MSEC = 1000000;
 }  // namespace
 
 static std::shared_ptr<EventSubscriber> SubscribeCommonEvent(std::function<void()> callback);
+static void ApplyOutputParameters(DeviceConnectionForOutput &connection);
+static std::vector<std::pair<std::string, std::string>> GetParameterPairs(const char *key);
+static std::vector<std::pair<uint64_t, uint64_t>> GetUsbDinDevices();
 
 MidiDeviceManager::MidiDeviceManager() : eventSubscriber_(nullptr)
 {
     MIDI_INFO_LOG("MidiDeviceManager constructor");
-    drivers_.emplace(DeviceType::DEVICE_TYPE_USB, std::make_unique<UsbMidiTransportDeviceDriver>());
+    auto usbDriver = std::make_unique<UsbMidiTransportDeviceDriver>();
+    usbDriver->SetDinDevices(GetUsbDinDevices());
+    drivers_.emplace(DeviceType::DEVICE_TYPE_USB, std::move(usbDriver));
     drivers_.emplace(DeviceType::DEVICE_TYPE_BLE, std::make_unique<BleMidiTransportDeviceDriver>());
 }
 
@@ -78,6 +103,11 @@ void MidiDeviceManager::Init()
     };
     eventSubscriber_ = SubscribeCommonEvent(eventCallback);  // todo 工厂
 #endif
+    // without the dispatch thread input is still delivered on the driver thread, so keep going on failure
+    if (OHOS::system::GetBoolParameter(PARAM_INPUT_DISPATCH_THREAD, false) &&
+        SetInputDispatchThread(true) != OH_MIDI_STATUS_OK) {
+        MIDI_ERR_LOG("enable input dispatch thread fail");
+    }
     UpdateDevices();
     MIDI_INFO_LOG("MidiDeviceManager initialized successfully");
 }
@@ -95,6 +125,75 @@ static std::shared_ptr<EventSubscriber> SubscribeCommonEvent(std::function<void(
     return subscriber;
 }
 
+static void ApplyOutputParameters(DeviceConnectionForOutput &connection)
+{
+    // output tuning is a product decision, read when the port opens so a changed value applies to new ports
+    connection.SetPrecisionMode(OHOS::system::GetBoolParameter(PARAM_OUTPUT_PRECISION, false));
+    uint64_t slackUs = OHOS::system::GetUintParameter<uint64_t>(PARAM_OUTPUT_SLACK_US, 0, MAX_OUTPUT_SLACK_US);
+    connection.SetSchedulingSlack(slackUs * NSEC_PER_USEC);
+    connection.SetPerClientMaxBytesPerSecond(
+        OHOS::system::GetUintParameter<uint64_t>(PARAM_OUTPUT_CLIENT_MAX_BPS, 0, UINT32_MAX));
+    if (OHOS::system::GetBoolParameter(PARAM_OUTPUT_BUSY_POLL, false)) {
+        uint64_t intervalUs = OHOS::system::GetUintParameter<uint64_t>(PARAM_OUTPUT_BUSY_POLL_INTERVAL_US, 0,
+            MAX_BUSY_POLL_INTERVAL_US);
+        int32_t cpu = OHOS::system::GetIntParameter<int32_t>(PARAM_OUTPUT_BUSY_POLL_CPU, -1, -1, MAX_BUSY_POLL_CPU);
+        uint64_t idleMs = OHOS::system::GetUintParameter<uint64_t>(PARAM_OUTPUT_BUSY_POLL_IDLE_MS,
+            DEFAULT_BUSY_POLL_IDLE_MS, UINT32_MAX);
+        connection.SetBusyPoll(true, intervalUs * NSEC_PER_USEC, cpu, idleMs * NSEC_PER_MSEC);
+    }
+}
+
+// "a:b,c:d" list parameters, entries without a colon are skipped
+static std::vector<std::pair<std::string, std::string>> GetParameterPairs(const char *key)
+{
+    std::vector<std::pair<std::string, std::string>> pairs;
+    std::string value = OHOS::system::GetParameter(key, "");
+    size_t start = 0;
+    while (start < value.size()) {
+        size_t end = value.find(',', start);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        std::string entry = value.substr(start, end - start);
+        start = end + 1;
+        size_t colon = entry.find(':');
+        CHECK_AND_CONTINUE_LOG(colon != std::string::npos, "invalid entry %{public}s in %{public}s",
+            entry.c_str(), key);
+        pairs.emplace_back(entry.substr(0, colon), entry.substr(colon + 1));
+    }
+    return pairs;
+}
+
+// USB interfaces that bridge to DIN jacks cannot tell the HDI so, the product lists them as "vid:pid" in hex
+static std::vector<std::pair<uint64_t, uint64_t>> GetUsbDinDevices()
+{
+    std::vector<std::pair<uint64_t, uint64_t>> devices;
+    for (const auto &entry : GetParameterPairs(PARAM_USB_DIN_DEVICES)) {
+        uint64_t vendorId = 0;
+        uint64_t productId = 0;
+        CHECK_AND_CONTINUE_LOG(StringToHexNum(entry.first, vendorId) && StringToHexNum(entry.second, productId),
+            "invalid usb din device %{public}s:%{public}s", entry.first.c_str(), entry.second.c_str());
+        devices.emplace_back(vendorId, productId);
+    }
+    return devices;
+}
+
+uint32_t MidiDeviceManager::GetOutputClientWeight(uint32_t uid)
+{
+    // "uid:weight,uid:weight", unlisted apps and malformed entries get the default weight
+    for (const auto &entry : GetParameterPairs(PARAM_OUTPUT_CLIENT_WEIGHTS)) {
+        uint32_t entryUid = 0;
+        uint32_t weight = 0;
+        if (!StringToDecNum(entry.first, entryUid) || entryUid != uid || !StringToDecNum(entry.second, weight)) {
+            continue;
+        }
+        CHECK_AND_RETURN_RET_LOG(weight != 0 && weight <= MAX_CLIENT_WEIGHT, DEFAULT_CLIENT_WEIGHT,
+            "invalid output weight %{public}u for uid %{public}u", weight, uid);
+        return weight;
+    }
+    return DEFAULT_CLIENT_WEIGHT;
+}
+
 static bool isMidiDevice(USB::UsbDevice &usbDevice)
 {
     for (auto &usbConfig : usbDevice.GetConfigs()) {
@@ -381,10 +480,19 @@ int32_t MidiDeviceManager::OpenInputPort(
     auto connection = std::make_shared<DeviceConnectionForInput>(info);
     inputConnection = connection;
     std::weak_ptr<DeviceConnectionForInput> weakConnection = connection;
+    std::shared_ptr<MidiInputDispatcher> dispatcher;
+    {
+        std::lock_guard<std::mutex> lock(dispatcherMutex_);
+        dispatcher = inputDispatcher_;
+    }
     // register DeviceConnectionForInput::HandleDeviceUmpInput
     auto ret = driver->OpenInputPort(
-        device.midiDeviceInfo.driverDeviceId, static_cast<size_t>(portIndex), [weakConnection]
+        device.midiDeviceInfo.driverDeviceId, static_cast<size_t>(portIndex), [weakConnection, dispatcher]
         (std::vector<MidiEventInner> &events) {
+            // a full queue drops the batch, delivering it here would overtake the queued ones
+            if (dispatcher != nullptr && (dispatcher->Post(weakConnection, events) || dispatcher->IsRunning())) {
+                return;
+            }
             if (auto locked = weakConnection.lock()) {
                 locked->HandleDeviceUmpInput(events);
             }
@@ -411,12 +519,32 @@ int32_t MidiDeviceManager::OpenOutputPort(
         .portIndex = portIndex,
     };
     auto connection = std::make_shared<DeviceConnectionForOutput>(info);
+    ApplyOutputParameters(*connection);
     outputConnection = connection;
     auto ret = driver->OpenOutputPort(device.midiDeviceInfo.driverDeviceId, portIndex);
     CHECK_AND_RETURN_RET(ret == OH_MIDI_STATUS_OK, OH_MIDI_STATUS_INVALID_PORT);
     return ret;
 }
 
+int32_t MidiDeviceManager::SetInputDispatchThread(bool enable)
+{
+    std::lock_guard<std::mutex> lock(dispatcherMutex_);
+    if (!enable) {
+        // ports opened with the dispatcher go back to delivering on the driver thread once it stops
+        if (inputDispatcher_ != nullptr) {
+            inputDispatcher_->Stop();
+            inputDispatcher_ = nullptr;
+        }
+        return OH_MIDI_STATUS_OK;
+    }
+    CHECK_AND_RETURN_RET(inputDispatcher_ == nullptr, OH_MIDI_STATUS_OK);
+    auto dispatcher = std::make_shared<MidiInputDispatcher>();
+    CHECK_AND_RETURN_RET_LOG(dispatcher->Start() == OH_MIDI_STATUS_OK, OH_MIDI_STATUS_SYSTEM_ERROR,
+        "start input dispatch thread fail");
+    inputDispatcher_ = std::move(dispatcher);
+    return OH_MIDI_STATUS_OK;
+}
+
 int32_t MidiDeviceManager::CloseInputPort(int64_t deviceId, uint32_t portIndex)
 {
     MIDI_INFO_LOG("device: %{public}" PRId64 " portIndex: %{public}u", deviceId, portIndex);
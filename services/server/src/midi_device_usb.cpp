@@ -16,6 +16,9 @@
 #define LOG_TAG "UsbDeviceDriver"
 #endif
 
+#include <algorithm>
+
+#include "futex_tool.h"
 #include "midi_log.h"
 #include "midi_utils.h"
 #include "midi_device_usb.h"
@@ -24,9 +27,60 @@ using namespace OHOS::HDI::Midi::V1_0;
 
 namespace OHOS {
 namespace MIDI {
+namespace {
+constexpr int64_t SHM_WAIT_FOREVER = -1;
+constexpr int64_t SHM_WRITE_WAIT_NS = 1000000; // 1ms
+constexpr int32_t SHM_WRITE_MAX_WAITS = 20;
+// MidiMessage carries the due time to the HDI, a driver that sends on arrival is at most this early
+constexpr uint64_t USB_SCHEDULE_LOOKAHEAD_NS = 2000000; // 2ms
+} // namespace
 
 UsbMidiTransportDeviceDriver::UsbMidiTransportDeviceDriver() { midiHdi_ = IMidiInterface::Get(true); }
 
+UsbMidiTransportDeviceDriver::~UsbMidiTransportDeviceDriver()
+{
+    std::vector<PortKey> inputKeys;
+    std::vector<PortKey> outputKeys;
+    {
+        std::lock_guard<std::mutex> lock(shmMutex_);
+        for (const auto &entry : shmInputPorts_) {
+            inputKeys.push_back(entry.first);
+        }
+        for (const auto &entry : shmOutputRings_) {
+            outputKeys.push_back(entry.first);
+        }
+    }
+    for (const auto &key : inputKeys) {
+        DetachShmInput(key.first, key.second);
+    }
+    for (const auto &key : outputKeys) {
+        DetachShmOutput(key.first, key.second);
+    }
+}
+
+void UsbMidiTransportDeviceDriver::SetShmTransport(std::shared_ptr<UsbMidiShmTransport> transport)
+{
+    std::lock_guard<std::mutex> lock(shmMutex_);
+    shmTransport_ = std::move(transport);
+}
+
+void UsbMidiTransportDeviceDriver::SetDinDevices(std::vector<std::pair<uint64_t, uint64_t>> vendorProductIds)
+{
+    std::lock_guard<std::mutex> lock(dinMutex_);
+    dinVendorProductIds_ = std::move(vendorProductIds);
+}
+
+void UsbMidiTransportDeviceDriver::RecordDinDevice(int64_t deviceId, uint64_t vendorId, uint64_t productId)
+{
+    std::lock_guard<std::mutex> lock(dinMutex_);
+    auto it = std::find(dinVendorProductIds_.begin(), dinVendorProductIds_.end(), std::make_pair(vendorId, productId));
+    if (it == dinVendorProductIds_.end()) {
+        dinDeviceIds_.erase(deviceId);
+        return;
+    }
+    dinDeviceIds_.insert(deviceId);
+}
+
 static std::vector<MidiPortInfo> ConvertToDeviceInformation(const OHOS::HDI::Midi::V1_0::MidiDeviceInfo device)
 {
     std::vector<MidiPortInfo> portInfos;
@@ -68,6 +122,7 @@ std::vector<DeviceInformation> UsbMidiTransportDeviceDriver::GetRegisteredDevice
         StringToHexNum(device.vendorId, vendorId);
         devInfo.midiDeviceInfo.productId = productId;
         devInfo.midiDeviceInfo.vendorId = vendorId;
+        RecordDinDevice(device.deviceId, vendorId, productId);
         
         devInfo.portInfos = ConvertToDeviceInformation(device);
         deviceInfos.push_back(devInfo);
@@ -95,46 +150,255 @@ int32_t UsbMidiTransportDeviceDriver::CloseDevice(int64_t deviceId)
 int32_t UsbMidiTransportDeviceDriver::OpenInputPort(int64_t deviceId, uint32_t portIndex, UmpInputCallback cb)
 {
     CHECK_AND_RETURN_RET_LOG(midiHdi_ != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "midiHdi_ is nullptr");
+    // the HDI callback stays registered, the driver only uses it when the input ring is not attached
     auto usbCallback = sptr<UsbDriverCallback>::MakeSptr(cb);
-    return midiHdi_->OpenInputPort(deviceId, portIndex, usbCallback);
+    int32_t ret = midiHdi_->OpenInputPort(deviceId, portIndex, usbCallback);
+    CHECK_AND_RETURN_RET(ret == OH_MIDI_STATUS_OK, ret);
+    (void)AttachShmInput(deviceId, portIndex, cb);
+    return ret;
 }
 
 int32_t UsbMidiTransportDeviceDriver::CloseInputPort(int64_t deviceId, uint32_t portIndex)
 {
     CHECK_AND_RETURN_RET_LOG(midiHdi_ != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "midiHdi_ is nullptr");
+    DetachShmInput(deviceId, portIndex);
     return midiHdi_->CloseInputPort(deviceId, portIndex);
 }
 
 int32_t UsbMidiTransportDeviceDriver::OpenOutputPort(int64_t deviceId, uint32_t portIndex)
 {
     CHECK_AND_RETURN_RET_LOG(midiHdi_ != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "midiHdi_ is nullptr");
-    return midiHdi_->OpenOutputPort(deviceId, portIndex);
+    int32_t ret = midiHdi_->OpenOutputPort(deviceId, portIndex);
+    CHECK_AND_RETURN_RET(ret == OH_MIDI_STATUS_OK, ret);
+    AttachShmOutput(deviceId, portIndex);
+    return ret;
 }
 
 int32_t UsbMidiTransportDeviceDriver::CloseOutputPort(int64_t deviceId, uint32_t portIndex)
 {
     CHECK_AND_RETURN_RET_LOG(midiHdi_ != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "midiHdi_ is nullptr");
+    DetachShmOutput(deviceId, portIndex);
+    ReleaseOutputArena(deviceId, portIndex);
     return midiHdi_->CloseOutputPort(deviceId, portIndex);
 }
 
+void UsbMidiTransportDeviceDriver::AttachShmOutput(int64_t deviceId, uint32_t portIndex)
+{
+    DetachShmOutput(deviceId, portIndex);
+    std::shared_ptr<UsbMidiShmTransport> transport;
+    {
+        std::lock_guard<std::mutex> lock(shmMutex_);
+        transport = shmTransport_;
+    }
+    CHECK_AND_RETURN(transport != nullptr);
+    UsbMidiShmCapability capability = transport->GetCapability(deviceId, portIndex);
+    CHECK_AND_RETURN(capability.outputRing);
+    auto ring = MidiSharedRing::CreateFromLocal(capability.ringSize);
+    CHECK_AND_RETURN_LOG(ring != nullptr, "create output ring failed");
+    int32_t ret = transport->AttachOutputRing(deviceId, portIndex, ring);
+    CHECK_AND_RETURN_LOG(ret == OH_MIDI_STATUS_OK, "attach output ring failed: %{public}d, use hdi messages", ret);
+    std::lock_guard<std::mutex> lock(shmMutex_);
+    shmOutputRings_[{deviceId, portIndex}] = ring;
+}
+
+bool UsbMidiTransportDeviceDriver::AttachShmInput(int64_t deviceId, uint32_t portIndex, UmpInputCallback cb)
+{
+    DetachShmInput(deviceId, portIndex);
+    std::shared_ptr<UsbMidiShmTransport> transport;
+    {
+        std::lock_guard<std::mutex> lock(shmMutex_);
+        transport = shmTransport_;
+    }
+    CHECK_AND_RETURN_RET(transport != nullptr && cb != nullptr, false);
+    UsbMidiShmCapability capability = transport->GetCapability(deviceId, portIndex);
+    CHECK_AND_RETURN_RET(capability.inputRing, false);
+    auto port = std::make_unique<ShmInputPort>();
+    port->ring = MidiSharedRing::CreateFromLocal(capability.ringSize);
+    CHECK_AND_RETURN_RET_LOG(port->ring != nullptr, false, "create input ring failed");
+    port->callback = std::move(cb);
+    port->running.store(true);
+    port->reader = std::thread(&UsbMidiTransportDeviceDriver::ShmInputLoop, port.get());
+
+    int32_t ret = transport->AttachInputRing(deviceId, portIndex, port->ring);
+    if (ret != OH_MIDI_STATUS_OK) {
+        MIDI_ERR_LOG("attach input ring failed: %{public}d, use hdi messages", ret);
+        port->running.store(false);
+        (void)FutexTool::FutexWake(port->ring->GetFutex(), IS_PRE_EXIT);
+        port->reader.join();
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(shmMutex_);
+    shmInputPorts_[{deviceId, portIndex}] = std::move(port);
+    return true;
+}
+
+void UsbMidiTransportDeviceDriver::DetachShmOutput(int64_t deviceId, uint32_t portIndex)
+{
+    std::shared_ptr<UsbMidiShmTransport> transport;
+    {
+        std::lock_guard<std::mutex> lock(shmMutex_);
+        CHECK_AND_RETURN(shmOutputRings_.erase({deviceId, portIndex}) > 0);
+        transport = shmTransport_;
+    }
+    if (transport != nullptr) {
+        transport->DetachOutputRing(deviceId, portIndex);
+    }
+}
+
+void UsbMidiTransportDeviceDriver::DetachShmInput(int64_t deviceId, uint32_t portIndex)
+{
+    std::unique_ptr<ShmInputPort> port;
+    std::shared_ptr<UsbMidiShmTransport> transport;
+    {
+        std::lock_guard<std::mutex> lock(shmMutex_);
+        auto it = shmInputPorts_.find({deviceId, portIndex});
+        CHECK_AND_RETURN(it != shmInputPorts_.end());
+        port = std::move(it->second);
+        shmInputPorts_.erase(it);
+        transport = shmTransport_;
+    }
+    // the driver stops writing first, so no event is left behind the reader
+    if (transport != nullptr) {
+        transport->DetachInputRing(deviceId, portIndex);
+    }
+    port->running.store(false);
+    (void)FutexTool::FutexWake(port->ring->GetFutex(), IS_PRE_EXIT);
+    if (port->reader.joinable()) {
+        port->reader.join();
+    }
+}
+
+std::shared_ptr<MidiSharedRing> UsbMidiTransportDeviceDriver::FindShmOutputRing(int64_t deviceId,
+    uint32_t portIndex)
+{
+    std::lock_guard<std::mutex> lock(shmMutex_);
+    auto it = shmOutputRings_.find({deviceId, portIndex});
+    return it == shmOutputRings_.end() ? nullptr : it->second;
+}
+
+int32_t UsbMidiTransportDeviceDriver::WriteShmOutput(const std::shared_ptr<MidiSharedRing> &ring,
+    std::vector<MidiEventInner> &list)
+{
+    uint32_t total = static_cast<uint32_t>(list.size());
+    uint32_t written = 0;
+    int32_t waits = 0;
+    while (written < total) {
+        uint32_t writtenThis = 0;
+        MidiStatusCode ret = ring->TryWriteEvents(list.data() + written, total - written, &writtenThis);
+        written += writtenThis;
+        if (written == total) {
+            break;
+        }
+        CHECK_AND_RETURN_RET_LOG(ret == MidiStatusCode::WOULD_BLOCK, OH_MIDI_STATUS_SYSTEM_ERROR,
+            "write output ring failed: %{public}d", static_cast<int32_t>(ret));
+        CHECK_AND_CONTINUE(writtenThis == 0);
+        CHECK_AND_RETURN_RET_LOG(++waits <= SHM_WRITE_MAX_WAITS, OH_MIDI_STATUS_TIMEOUT,
+            "driver does not drain the output ring");
+        uint32_t needed = sizeof(ShmMidiEventHeader) + list[written].length * sizeof(uint32_t);
+        FutexCode wret = ring->WaitForSpace(SHM_WRITE_WAIT_NS, needed);
+        CHECK_AND_RETURN_RET(wret == FUTEX_SUCCESS || wret == FUTEX_TIMEOUT, OH_MIDI_STATUS_SYSTEM_ERROR);
+    }
+    return OH_MIDI_STATUS_OK;
+}
+
+void UsbMidiTransportDeviceDriver::ShmInputLoop(ShmInputPort *port)
+{
+    std::atomic<uint32_t> *futexPtr = port->ring->GetFutex();
+    std::vector<MidiEvent> events;
+    std::vector<std::vector<uint32_t>> payloads;
+    std::vector<MidiEventInner> innerEvents;
+    while (port->running.load()) {
+        (void)FutexTool::FutexWait(futexPtr, SHM_WAIT_FOREVER,
+            [port]() { return !port->running.load() || !port->ring->IsEmpty(); });
+        if (!port->running.load()) {
+            break;
+        }
+        events.clear();
+        payloads.clear();
+        port->ring->DrainToBatch(events, payloads, 0);
+        CHECK_AND_CONTINUE(!events.empty());
+        innerEvents.clear();
+        for (const auto &event : events) {
+            innerEvents.push_back({event.timestamp, event.length, event.data});
+        }
+        port->callback(innerEvents);
+    }
+}
+
 
 int32_t UsbMidiTransportDeviceDriver::HandleUmpInput(int64_t deviceId, uint32_t portIndex,
     std::vector<MidiEventInner> &list)
 {
+    // the dump allocates, skip it unless debug logs are on
+    if (HiLogIsLoggable(LOG_DOMAIN, LOG_TAG, LOG_DEBUG)) {
+        MIDI_DEBUG_LOG("%{public}s", DumpMidiEvents(list).c_str());
+    }
+    auto ring = FindShmOutputRing(deviceId, portIndex);
+    if (ring != nullptr) {
+        return WriteShmOutput(ring, list);
+    }
     CHECK_AND_RETURN_RET_LOG(midiHdi_ != nullptr, OH_MIDI_STATUS_SYSTEM_ERROR, "midiHdi_ is nullptr");
-    MIDI_DEBUG_LOG("%{public}s", DumpMidiEvents(list).c_str());
-    std::vector<OHOS::HDI::Midi::V1_0::MidiMessage> messages;
-    for (auto &event: list) {
-        OHOS::HDI::Midi::V1_0::MidiMessage msg;
-        msg.timestamp = static_cast<int64_t>(event.timestamp);
-        for (size_t i = 0; i < event.length; ++i) {
-            msg.data.push_back(event.data[i]);
+    auto arena = GetOutputArena(deviceId, portIndex);
+    std::lock_guard<std::mutex> lock(arena->mutex);
+    FillOutputArena(*arena, list);
+    return midiHdi_->SendMidiMessages(deviceId, portIndex, arena->messages);
+}
+
+std::shared_ptr<UsbMidiTransportDeviceDriver::UsbOutputArena> UsbMidiTransportDeviceDriver::GetOutputArena(
+    int64_t deviceId, uint32_t portIndex)
+{
+    std::lock_guard<std::mutex> lock(arenaMutex_);
+    auto &arena = outputArenas_[{deviceId, portIndex}];
+    if (arena == nullptr) {
+        arena = std::make_shared<UsbOutputArena>();
+    }
+    return arena;
+}
+
+void UsbMidiTransportDeviceDriver::ReleaseOutputArena(int64_t deviceId, uint32_t portIndex)
+{
+    std::lock_guard<std::mutex> lock(arenaMutex_);
+    outputArenas_.erase({deviceId, portIndex});
+}
+
+void UsbMidiTransportDeviceDriver::FillOutputArena(UsbOutputArena &arena, const std::vector<MidiEventInner> &list)
+{
+    auto &messages = arena.messages;
+    // park the payload buffers of surplus messages instead of freeing them with the message
+    while (messages.size() > list.size()) {
+        arena.spareData.push_back(std::move(messages.back().data));
+        messages.pop_back();
+    }
+    messages.reserve(list.size());
+    while (messages.size() < list.size()) {
+        messages.emplace_back();
+        if (!arena.spareData.empty()) {
+            messages.back().data = std::move(arena.spareData.back());
+            arena.spareData.pop_back();
         }
-        messages.emplace_back(msg);
     }
+    for (size_t i = 0; i < list.size(); ++i) {
+        const MidiEventInner &event = list[i];
+        messages[i].timestamp = static_cast<int64_t>(event.timestamp);
+        // assign reuses the capacity and grows to the exact length when it is short
+        messages[i].data.assign(event.data, event.data + event.length);
+    }
+}
 
-    int32_t ret = midiHdi_->SendMidiMessages(deviceId, portIndex, messages);
-    return ret;
+MidiDriverCapability UsbMidiTransportDeviceDriver::GetOutputCapability(int64_t deviceId, uint32_t portIndex)
+{
+    (void)portIndex;
+    MidiDriverCapability capability{};
+    capability.supportsScheduledOutput = true;
+    capability.lookaheadNs = USB_SCHEDULE_LOOKAHEAD_NS;
+    capability.asyncOutputDepth = MIDI_DEFAULT_ASYNC_OUTPUT_DEPTH;
+    std::lock_guard<std::mutex> lock(dinMutex_);
+    if (dinDeviceIds_.count(deviceId) > 0) {
+        // the interface forwards to a DIN jack, USB would accept bytes far faster than the cable carries them
+        capability.wireBytesPerSecond = MIDI_DIN_BYTES_PER_SECOND;
+        capability.wireFormat = MidiWireFormat::MIDI1_BYTE_STREAM;
+    }
+    return capability;
 }
 
 int32_t UsbDriverCallback::OnMidiDataReceived(const std::vector<OHOS::HDI::Midi::V1_0::MidiMessage> &messages)
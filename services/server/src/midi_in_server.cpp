@@ -95,6 +95,47 @@ int32_t MidiInServer::FlushOutputPort(int64_t deviceId, uint32_t portIndex)
     return MidiServiceController::GetInstance()->FlushOutputPort(clientId_, deviceId, portIndex);
 }
 
+int32_t MidiInServer::CancelScheduledEvents(int64_t deviceId, uint32_t portIndex, uint32_t tag,
+    uint64_t beginTimestamp, uint64_t endTimestamp)
+{
+    MIDI_INFO_LOG("deviceId[%{public}" PRId64 "] cancel portIndex[%{public}u] tag[%{public}u]", deviceId, portIndex,
+        tag);
+    CHECK_AND_RETURN_RET_LOG(tag <= UINT16_MAX, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, "invalid tag");
+    return MidiServiceController::GetInstance()->CancelScheduledEvents(clientId_, deviceId, portIndex,
+        static_cast<uint16_t>(tag), beginTimestamp, endTimestamp);
+}
+
+int32_t MidiInServer::OpenOutputTimeline(std::shared_ptr<MidiSharedTimeline> &timeline, int64_t deviceId,
+    uint32_t portIndex, uint32_t capacityBytes)
+{
+    MIDI_INFO_LOG("deviceId[%{public}" PRId64 "] timeline portIndex[%{public}u] capacity[%{public}u]", deviceId,
+        portIndex, capacityBytes);
+    return MidiServiceController::GetInstance()->OpenOutputTimeline(clientId_, timeline, deviceId, portIndex,
+        capacityBytes);
+}
+
+int32_t MidiInServer::SetOutputPortExclusive(int64_t deviceId, uint32_t portIndex, bool exclusive)
+{
+    MIDI_INFO_LOG("deviceId[%{public}" PRId64 "] portIndex[%{public}u] exclusive[%{public}d]", deviceId, portIndex,
+        exclusive);
+    return MidiServiceController::GetInstance()->SetOutputPortExclusive(clientId_, deviceId, portIndex, exclusive);
+}
+
+int32_t MidiInServer::OpenInputPortBroadcast(std::shared_ptr<MidiBroadcastRing> &ring, int64_t deviceId,
+    uint32_t portIndex)
+{
+    MIDI_INFO_LOG("deviceId[%{public}" PRId64 "] broadcast portIndex[%{public}u]", deviceId, portIndex);
+    return MidiServiceController::GetInstance()->OpenInputPortBroadcast(clientId_, ring, deviceId, portIndex);
+}
+
+int32_t MidiInServer::OpenInputPortWithFilter(std::shared_ptr<MidiSharedRing> &buffer, int64_t deviceId,
+    uint32_t portIndex, const MidiInputFilter &filter)
+{
+    MIDI_INFO_LOG("deviceId[%{public}" PRId64 "] filtered portIndex[%{public}u]", deviceId, portIndex);
+    return MidiServiceController::GetInstance()->OpenInputPortWithFilter(clientId_, buffer, deviceId, portIndex,
+        filter);
+}
+
 int32_t MidiInServer::CloseInputPort(int64_t deviceId, uint32_t portIndex)
 {
     MIDI_INFO_LOG("deviceId[%{public}" PRId64 "]--xx-->portIndex[%{public}u]", deviceId, portIndex);
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LOG_TAG
+#define LOG_TAG "MidiInputDispatcher"
+#endif
+
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+#include "futex_tool.h"
+#include "midi_device_connection.h"
+#include "midi_input_dispatcher.h"
+#include "midi_log.h"
+#include "native_midi_base.h"
+
+namespace OHOS {
+namespace MIDI {
+namespace {
+// typical driver batches fit without growing the slot buffers on the driver thread
+constexpr size_t SLOT_RESERVED_EVENTS = 32;
+constexpr size_t SLOT_RESERVED_WORDS = 128;
+} // namespace
+
+MidiInputDispatcher::MidiInputDispatcher(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)), slots_(std::make_unique<Slot[]>(capacity_)), futex_(IS_READY)
+{
+    for (size_t i = 0; i < capacity_; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+        slots_[i].events.reserve(SLOT_RESERVED_EVENTS);
+        slots_[i].words.reserve(SLOT_RESERVED_WORDS);
+    }
+}
+
+MidiInputDispatcher::~MidiInputDispatcher()
+{
+    Stop();
+}
+
+int32_t MidiInputDispatcher::Start(int32_t rtPriority)
+{
+    CHECK_AND_RETURN_RET(!IsRunning(), OH_MIDI_STATUS_OK);
+    futex_.store(IS_READY);
+    stopping_.store(false, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    worker_ = std::thread(&MidiInputDispatcher::ThreadMain, this);
+    ApplyPriority(rtPriority);
+    return OH_MIDI_STATUS_OK;
+}
+
+void MidiInputDispatcher::Stop()
+{
+    CHECK_AND_RETURN(IsRunning());
+    running_.store(false, std::memory_order_release);
+    stopping_.store(true, std::memory_order_release);
+    (void)FutexTool::FutexWake(&futex_);
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void MidiInputDispatcher::ApplyPriority(int32_t rtPriority)
+{
+    CHECK_AND_RETURN(rtPriority > 0);
+    sched_param param{};
+    param.sched_priority = std::min(rtPriority, sched_get_priority_max(SCHED_FIFO));
+    int ret = pthread_setschedparam(worker_.native_handle(), SCHED_FIFO, &param);
+    if (ret != 0) {
+        MIDI_WARNING_LOG("input dispatch keeps the default policy, error %{public}d", ret);
+    }
+}
+
+bool MidiInputDispatcher::Post(const std::weak_ptr<DeviceConnectionForInput> &target,
+    const std::vector<MidiEventInner> &events)
+{
+    CHECK_AND_RETURN_RET(IsRunning() && !events.empty(), false);
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while (true) {
+        slot = &slots_[pos % capacity_];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // the dispatch thread is a whole queue behind
+            droppedCount_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+    // the slot is ours until its sequence is published
+    slot->target = target;
+    slot->events.assign(events.begin(), events.end());
+    slot->words.clear();
+    for (auto &event : slot->events) {
+        if (event.data == nullptr) {
+            event.length = 0;
+        }
+        slot->words.insert(slot->words.end(), event.data, event.data + event.length);
+        event.data = nullptr;
+    }
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    // only a waiting dispatch thread costs a syscall
+    (void)FutexTool::FutexWake(&futex_);
+    return true;
+}
+
+bool MidiInputDispatcher::HasPending() const
+{
+    const Slot &slot = slots_[dequeuePos_ % capacity_];
+    return slot.sequence.load(std::memory_order_acquire) == dequeuePos_ + 1;
+}
+
+void MidiInputDispatcher::DispatchOne()
+{
+    Slot &slot = slots_[dequeuePos_ % capacity_];
+    size_t offset = 0;
+    for (auto &event : slot.events) {
+        event.data = event.length > 0 ? slot.words.data() + offset : nullptr;
+        offset += event.length;
+    }
+    if (auto connection = slot.target.lock()) {
+        connection->HandleDeviceUmpInput(slot.events);
+    }
+    slot.target.reset();
+    slot.sequence.store(dequeuePos_ + capacity_, std::memory_order_release);
+    dequeuePos_++;
+}
+
+void MidiInputDispatcher::ThreadMain()
+{
+    while (true) {
+        (void)FutexTool::FutexWait(&futex_, 0,
+            [this] { return HasPending() || stopping_.load(std::memory_order_acquire); });
+        while (HasPending()) {
+            DispatchOne();
+        }
+        if (stopping_.load(std::memory_order_acquire)) {
+            break;
+        }
+    }
+}
+} // namespace MIDI
+} // namespace OHOS
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LOG_TAG
+#define LOG_TAG "MidiOutputSubmitter"
+#endif
+
+#include <chrono>
+
+#include "native_midi_base.h"
+#include "midi_log.h"
+#include "midi_output_submitter.h"
+
+namespace OHOS {
+namespace MIDI {
+namespace {
+// an async driver that never completes must not hang the port close
+constexpr std::chrono::milliseconds STOP_COMPLETION_TIMEOUT{1000};
+} // namespace
+
+MidiOutputSubmitter::~MidiOutputSubmitter()
+{
+    Stop();
+}
+
+int32_t MidiOutputSubmitter::Start(MidiDeviceDriver *driver, int64_t deviceId, uint32_t portIndex, size_t depth,
+    std::function<void()> onComplete)
+{
+    CHECK_AND_RETURN_RET(!running_, OH_MIDI_STATUS_OK);
+    CHECK_AND_RETURN_RET_LOG(driver != nullptr && depth > 0, OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "invalid driver or depth");
+    driver_ = driver;
+    deviceId_ = deviceId;
+    portIndex_ = portIndex;
+    // batches a driver never completed stay with their callbacks, start over with fresh ones
+    state_ = std::make_shared<State>();
+    state_->onComplete = std::move(onComplete);
+    for (size_t i = 0; i < depth; i++) {
+        state_->pool.push_back(std::make_unique<Batch>());
+        state_->freeBatches.push_back(state_->pool.back().get());
+    }
+    running_ = true;
+    worker_ = std::thread(&MidiOutputSubmitter::ThreadMain, this);
+    return OH_MIDI_STATUS_OK;
+}
+
+void MidiOutputSubmitter::Stop()
+{
+    CHECK_AND_RETURN(running_);
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->stopping = true;
+    }
+    state_->cv.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    running_ = false;
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    if (!state_->cv.wait_for(lock, STOP_COMPLETION_TIMEOUT,
+        [this] { return state_->freeBatches.size() == state_->pool.size(); })) {
+        MIDI_ERR_LOG("%{public}zu output batches not completed", state_->pool.size() - state_->freeBatches.size());
+    }
+    // no call starts once stopping is set, the ones in progress only wake the producer
+    state_->cv.wait(lock, [this] { return state_->callbacksRunning == 0; });
+    // a late completion only returns its batch to the shared state
+    state_->onComplete = nullptr;
+}
+
+MidiOutputSubmitter::Batch *MidiOutputSubmitter::Acquire(bool wait)
+{
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    if (wait) {
+        state_->cv.wait(lock, [this] { return !state_->freeBatches.empty(); });
+    }
+    if (state_->freeBatches.empty()) {
+        state_->producerWaiting = true;
+        return nullptr;
+    }
+    Batch *batch = state_->freeBatches.back();
+    state_->freeBatches.pop_back();
+    return batch;
+}
+
+void MidiOutputSubmitter::Submit(Batch *batch)
+{
+    CHECK_AND_RETURN(batch != nullptr);
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->queue.push_back(batch);
+    }
+    state_->cv.notify_all();
+}
+
+void MidiOutputSubmitter::Release(Batch *batch)
+{
+    CHECK_AND_RETURN(batch != nullptr);
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->freeBatches.push_back(batch);
+    }
+    state_->cv.notify_all();
+}
+
+bool MidiOutputSubmitter::IsIdle()
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    const bool idle = state_->freeBatches.size() == state_->pool.size();
+    state_->producerWaiting = state_->producerWaiting || !idle;
+    return idle;
+}
+
+uint64_t MidiOutputSubmitter::GetFailedCount() const
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->failedCount;
+}
+
+void MidiOutputSubmitter::ThreadMain()
+{
+    std::shared_ptr<State> state = state_;
+    while (true) {
+        Batch *batch = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->cv.wait(lock, [&state] { return state->stopping || !state->queue.empty(); });
+            if (state->queue.empty()) {
+                break;
+            }
+            batch = state->queue.front();
+            state->queue.pop_front();
+        }
+        // a synchronous driver completes inside this call, only this thread waits for it
+        (void)driver_->SubmitUmpOutput(deviceId_, portIndex_, batch->events,
+            [state, batch](int32_t result) { Complete(state, batch, result); });
+    }
+}
+
+void MidiOutputSubmitter::Complete(const std::shared_ptr<State> &state, Batch *batch, int32_t result)
+{
+    bool wakeProducer = false;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (result != OH_MIDI_STATUS_OK) {
+            state->failedCount++;
+        }
+        batch->events.clear();
+        for (auto &payload : batch->payloads) {
+            payload.clear();
+        }
+        state->freeBatches.push_back(batch);
+        // a producer that is not waiting picks the batch up on its own
+        wakeProducer = state->producerWaiting && !state->stopping && state->onComplete;
+        if (wakeProducer) {
+            state->producerWaiting = false;
+            state->callbacksRunning++;
+        }
+    }
+    state->cv.notify_all();
+    CHECK_AND_RETURN(wakeProducer);
+    // Stop() waits for this call before it resets onComplete
+    state->onComplete();
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->callbacksRunning--;
+    }
+    state->cv.notify_all();
+}
+} // namespace MIDI
+} // namespace OHOS
@@ -368,6 +368,36 @@ int32_t MidiServiceController::OpenInputPort(
     MIDI_INFO_LOG(
         "clientId: %{public}u, deviceId: %{public}" PRId64 " portIndex: %{public}u", clientId, deviceId, portIndex);
     std::lock_guard lock(lock_);
+    return OpenInputPortInner(clientId, deviceId, portIndex, [clientId, deviceId, &buffer](auto &connection) {
+        return connection.AddClientConnection(clientId, deviceId, buffer);
+    });
+}
+
+int32_t MidiServiceController::OpenInputPortBroadcast(
+    uint32_t clientId, std::shared_ptr<MidiBroadcastRing> &ring, int64_t deviceId, uint32_t portIndex)
+{
+    MIDI_INFO_LOG(
+        "clientId: %{public}u, deviceId: %{public}" PRId64 " portIndex: %{public}u", clientId, deviceId, portIndex);
+    std::lock_guard lock(lock_);
+    return OpenInputPortInner(clientId, deviceId, portIndex, [clientId, &ring](auto &connection) {
+        return connection.AddBroadcastClient(clientId, ring);
+    });
+}
+
+int32_t MidiServiceController::OpenInputPortWithFilter(uint32_t clientId, std::shared_ptr<MidiSharedRing> &buffer,
+    int64_t deviceId, uint32_t portIndex, const MidiInputFilter &filter)
+{
+    MIDI_INFO_LOG(
+        "clientId: %{public}u, deviceId: %{public}" PRId64 " portIndex: %{public}u", clientId, deviceId, portIndex);
+    std::lock_guard lock(lock_);
+    return OpenInputPortInner(clientId, deviceId, portIndex, [clientId, deviceId, &buffer, &filter](auto &connection) {
+        return connection.AddFilteredClient(clientId, deviceId, buffer, filter);
+    });
+}
+
+int32_t MidiServiceController::OpenInputPortInner(uint32_t clientId, int64_t deviceId, uint32_t portIndex,
+    const std::function<int32_t(DeviceConnectionForInput &)> &attachClient)
+{
     CHECK_AND_RETURN_RET_LOG(clients_.find(clientId) != clients_.end(),
         OH_MIDI_STATUS_INVALID_CLIENT,
         "Client not found: %{public}u",
@@ -388,7 +418,8 @@ int32_t MidiServiceController::OpenInputPort(
     if (inputPort != inputPortConnections.end()) {
         CHECK_AND_RETURN_RET_LOG(inputPort->second->HasClientConnection(clientId) != true,
             OH_MIDI_STATUS_PORT_ALREADY_OPEN, "already connected inputport");
-        inputPort->second->AddClientConnection(clientId, deviceId, buffer);
+        auto ret = attachClient(*inputPort->second);
+        CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "connect inputport fail");
         MIDI_INFO_LOG("connect inputport success");
         return OH_MIDI_STATUS_OK;
     }
@@ -405,7 +436,12 @@ int32_t MidiServiceController::OpenInputPort(
     auto ret = deviceManager_->OpenInputPort(inputConnection, deviceId, portIndex);
     CHECK_AND_RETURN_RET_LOG(ret == OH_MIDI_STATUS_OK, ret, "open input port fail!");
 
-    inputConnection->AddClientConnection(clientId, deviceId, buffer);
+    ret = attachClient(*inputConnection);
+    if (ret != OH_MIDI_STATUS_OK) {
+        MIDI_ERR_LOG("connect inputport fail");
+        (void)deviceManager_->CloseInputPort(deviceId, portIndex);
+        return ret;
+    }
     resourceInfo.openPortCount++;
 
     inputPortConnections.emplace(portIndex, std::move(inputConnection));
@@ -440,6 +476,8 @@ int32_t MidiServiceController::OpenOutputPort(
         CHECK_AND_RETURN_RET_LOG(outputPort->second->HasClientConnection(clientId) != true,
             OH_MIDI_STATUS_PORT_ALREADY_OPEN, "already connected outputport");
         outputPort->second->AddClientConnection(clientId, deviceId, buffer);
+        outputPort->second->SetClientWeight(
+            clientId, deviceManager_->GetOutputClientWeight(clientResourceInfo_[clientId].uid));
         MIDI_INFO_LOG("connect outputport success");
         return OH_MIDI_STATUS_OK;
     }
@@ -458,6 +496,7 @@ int32_t MidiServiceController::OpenOutputPort(
     // start events handle thread of output port
     outputConnection->Start();
     outputConnection->AddClientConnection(clientId, deviceId, buffer);
+    outputConnection->SetClientWeight(clientId, deviceManager_->GetOutputClientWeight(resourceInfo.uid));
     resourceInfo.openPortCount++;
     outputPortConnections.emplace(portIndex, std::move(outputConnection));
     MIDI_INFO_LOG("OpenOutputPort Success");
@@ -491,6 +530,87 @@ int32_t MidiServiceController::FlushOutputPort(uint32_t clientId, int64_t device
     return OH_MIDI_STATUS_OK;
 }
 
+int32_t MidiServiceController::CancelScheduledEvents(uint32_t clientId, int64_t deviceId, uint32_t portIndex,
+    uint16_t tag, uint64_t beginTimestamp, uint64_t endTimestamp)
+{
+    MIDI_INFO_LOG("clientId: %{public}u, deviceId: %{public}" PRId64 " portIndex: %{public}u tag: %{public}u",
+        clientId, deviceId, portIndex, tag);
+    std::lock_guard lock(lock_);
+    CHECK_AND_RETURN_RET_LOG(clients_.find(clientId) != clients_.end(),
+        OH_MIDI_STATUS_INVALID_CLIENT,
+        "Client not found: %{public}u",
+        clientId);
+    auto it = deviceClientContexts_.find(deviceId);
+    CHECK_AND_RETURN_RET_LOG(it != deviceClientContexts_.end(),
+        OH_MIDI_STATUS_INVALID_DEVICE_HANDLE,
+        "device %{public}" PRId64 "not opened",
+        deviceId);
+    CHECK_AND_RETURN_RET_LOG(it->second->clients.find(clientId) != it->second->clients.end(),
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "client %{public}u doesn't open device %{public}" PRId64,
+        clientId,
+        deviceId);
+    auto &outputPortConnections = it->second->outputDeviceconnections_;
+    auto outputPort = outputPortConnections.find(portIndex);
+    CHECK_AND_RETURN_RET_LOG(outputPort != outputPortConnections.end(), OH_MIDI_STATUS_INVALID_PORT,
+        "output port %{public}u not opened", portIndex);
+    return outputPort->second->CancelClientEvents(clientId, tag, beginTimestamp, endTimestamp);
+}
+
+int32_t MidiServiceController::OpenOutputTimeline(uint32_t clientId, std::shared_ptr<MidiSharedTimeline> &timeline,
+    int64_t deviceId, uint32_t portIndex, uint32_t capacityBytes)
+{
+    MIDI_INFO_LOG("clientId: %{public}u, deviceId: %{public}" PRId64 " portIndex: %{public}u capacity: %{public}u",
+        clientId, deviceId, portIndex, capacityBytes);
+    std::lock_guard lock(lock_);
+    CHECK_AND_RETURN_RET_LOG(clients_.find(clientId) != clients_.end(),
+        OH_MIDI_STATUS_INVALID_CLIENT,
+        "Client not found: %{public}u",
+        clientId);
+    auto it = deviceClientContexts_.find(deviceId);
+    CHECK_AND_RETURN_RET_LOG(it != deviceClientContexts_.end(),
+        OH_MIDI_STATUS_INVALID_DEVICE_HANDLE,
+        "device %{public}" PRId64 "not opened",
+        deviceId);
+    CHECK_AND_RETURN_RET_LOG(it->second->clients.find(clientId) != it->second->clients.end(),
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "client %{public}u doesn't open device %{public}" PRId64,
+        clientId,
+        deviceId);
+    auto &outputPortConnections = it->second->outputDeviceconnections_;
+    auto outputPort = outputPortConnections.find(portIndex);
+    CHECK_AND_RETURN_RET_LOG(outputPort != outputPortConnections.end(), OH_MIDI_STATUS_INVALID_PORT,
+        "output port %{public}u not opened", portIndex);
+    return outputPort->second->CreateClientTimeline(clientId, capacityBytes, timeline);
+}
+
+int32_t MidiServiceController::SetOutputPortExclusive(uint32_t clientId, int64_t deviceId, uint32_t portIndex,
+    bool exclusive)
+{
+    MIDI_INFO_LOG("clientId: %{public}u, deviceId: %{public}" PRId64 " portIndex: %{public}u exclusive: %{public}d",
+        clientId, deviceId, portIndex, exclusive);
+    std::lock_guard lock(lock_);
+    CHECK_AND_RETURN_RET_LOG(clients_.find(clientId) != clients_.end(),
+        OH_MIDI_STATUS_INVALID_CLIENT,
+        "Client not found: %{public}u",
+        clientId);
+    auto it = deviceClientContexts_.find(deviceId);
+    CHECK_AND_RETURN_RET_LOG(it != deviceClientContexts_.end(),
+        OH_MIDI_STATUS_INVALID_DEVICE_HANDLE,
+        "device %{public}" PRId64 "not opened",
+        deviceId);
+    CHECK_AND_RETURN_RET_LOG(it->second->clients.find(clientId) != it->second->clients.end(),
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT,
+        "client %{public}u doesn't open device %{public}" PRId64,
+        clientId,
+        deviceId);
+    auto &outputPortConnections = it->second->outputDeviceconnections_;
+    auto outputPort = outputPortConnections.find(portIndex);
+    CHECK_AND_RETURN_RET_LOG(outputPort != outputPortConnections.end(), OH_MIDI_STATUS_INVALID_PORT,
+        "output port %{public}u not opened", portIndex);
+    return outputPort->second->SetClientExclusive(clientId, exclusive);
+}
+
 int32_t MidiServiceController::CloseInputPort(uint32_t clientId, int64_t deviceId, uint32_t portIndex)
 {
     MIDI_INFO_LOG(
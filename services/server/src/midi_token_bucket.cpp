@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "midi_utils.h"
+#include "midi_token_bucket.h"
+
+namespace OHOS {
+namespace MIDI {
+namespace {
+constexpr uint64_t DEFAULT_BURSTS_PER_SECOND = 10;
+} // namespace
+
+void MidiTokenBucket::Configure(uint64_t bytesPerSecond, uint64_t burstBytes)
+{
+    if (burstBytes == 0) {
+        burstBytes = std::max<uint64_t>(bytesPerSecond / DEFAULT_BURSTS_PER_SECOND, 1);
+    }
+    burstBytes_.store(burstBytes);
+    bytesPerSecond_.store(bytesPerSecond);
+}
+
+bool MidiTokenBucket::IsLimited(std::chrono::steady_clock::time_point now)
+{
+    const uint64_t rate = bytesPerSecond_.load();
+    if (rate == 0) {
+        return false;
+    }
+    const double burst = static_cast<double>(burstBytes_.load());
+    if (refillTime_.time_since_epoch().count() == 0) {
+        tokens_ = burst;
+    } else if (now > refillTime_) {
+        const double elapsedSeconds = std::chrono::duration<double>(now - refillTime_).count();
+        tokens_ = std::min(burst, tokens_ + elapsedSeconds * static_cast<double>(rate));
+    }
+    refillTime_ = std::max(refillTime_, now);
+    return tokens_ < 0;
+}
+
+void MidiTokenBucket::Charge(size_t bytes)
+{
+    if (bytesPerSecond_.load() == 0) {
+        return;
+    }
+    tokens_ -= static_cast<double>(bytes);
+}
+
+std::chrono::steady_clock::time_point MidiTokenBucket::GetResumeTime() const
+{
+    const uint64_t rate = bytesPerSecond_.load();
+    if (rate == 0 || tokens_ >= 0) {
+        return refillTime_;
+    }
+    const auto debtNs = static_cast<int64_t>(-tokens_ * MIDI_NS_PER_SECOND / static_cast<double>(rate));
+    return refillTime_ + std::chrono::nanoseconds(debtNs + 1);
+}
+} // namespace MIDI
+} // namespace OHOS
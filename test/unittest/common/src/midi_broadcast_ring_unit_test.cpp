@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "midi_broadcast_ring.h"
+
+using namespace OHOS;
+using namespace MIDI;
+using namespace testing::ext;
+
+class MidiBroadcastRingUnitTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+/**
+ * @tc.name   : Test MidiBroadcastRing Publish and Read
+ * @tc.number : MidiBroadcastRingRead_001
+ * @tc.desc   : Every cursor reads each event once, long events are split at UMP packet boundaries.
+ */
+HWTEST_F(MidiBroadcastRingUnitTest, MidiBroadcastRingRead_001, TestSize.Level0)
+{
+    EXPECT_EQ(nullptr, MidiBroadcastRing::CreateFromLocal(0));
+    EXPECT_EQ(nullptr, MidiBroadcastRing::CreateFromLocal(MIDI_BROADCAST_MAX_SLOTS + 1));
+    auto ring = MidiBroadcastRing::CreateFromLocal(16);
+    ASSERT_NE(nullptr, ring);
+
+    MidiBroadcastRing::Cursor early;
+    ring->AttachCursor(early);
+    uint32_t noteOn = 0x20903C64;
+    // three 2-word sysex7 packets and a 1-word note, packed greedily: slots of 4 and 3 words
+    std::vector<uint32_t> sysex{0x30160102, 0x03040506, 0x30260708, 0x090A0B0C, 0x30330D0E, 0x0F000000, noteOn};
+    std::vector<MidiEventInner> events = {{10, 1, &noteOn}, {20, sysex.size(), sysex.data()}};
+    EXPECT_EQ(3u, ring->Publish(events.data(), events.size()));
+
+    MidiBroadcastRing::Cursor late;
+    ring->AttachCursor(late);
+    EXPECT_FALSE(ring->HasEvents(late));
+    ASSERT_TRUE(ring->HasEvents(early));
+
+    std::vector<MidiEvent> out;
+    std::vector<std::vector<uint32_t>> payloads;
+    EXPECT_EQ(3u, ring->Read(early, out, payloads));
+    ASSERT_EQ(3u, out.size());
+    EXPECT_EQ(10u, out[0].timestamp);
+    EXPECT_EQ(noteOn, out[0].data[0]);
+    EXPECT_EQ(20u, out[1].timestamp);
+    EXPECT_EQ(4u, out[1].length);
+    EXPECT_EQ(20u, out[2].timestamp);
+    ASSERT_EQ(3u, out[2].length);
+    EXPECT_EQ(sysex[5], out[2].data[1]);
+    EXPECT_EQ(noteOn, out[2].data[2]);
+    EXPECT_EQ(0u, early.lost);
+    EXPECT_FALSE(ring->HasEvents(early));
+
+    out.clear();
+    payloads.clear();
+    EXPECT_EQ(0u, ring->Read(late, out, payloads));
+}
+
+/**
+ * @tc.name   : Test MidiBroadcastRing slow reader
+ * @tc.number : MidiBroadcastRingOverrun_001
+ * @tc.desc   : A reader lapped by the writer skips forward to the oldest event still held and counts the loss.
+ */
+HWTEST_F(MidiBroadcastRingUnitTest, MidiBroadcastRingOverrun_001, TestSize.Level0)
+{
+    constexpr uint32_t slotCount = 8;
+    auto ring = MidiBroadcastRing::CreateFromLocal(slotCount);
+    ASSERT_NE(nullptr, ring);
+    MidiBroadcastRing::Cursor cursor;
+    ring->AttachCursor(cursor);
+
+    std::vector<uint32_t> words(20);
+    std::vector<MidiEventInner> events;
+    for (uint32_t i = 0; i < words.size(); i++) {
+        words[i] = 0x20903C00 | i;
+    }
+    for (uint32_t i = 0; i < words.size(); i++) {
+        events.push_back({i, 1, &words[i]});
+    }
+    EXPECT_EQ(words.size(), ring->Publish(events.data(), events.size()));
+
+    std::vector<MidiEvent> out;
+    std::vector<std::vector<uint32_t>> payloads;
+    EXPECT_EQ(slotCount, ring->Read(cursor, out, payloads, 0));
+    EXPECT_EQ(words.size() - slotCount, cursor.lost);
+    EXPECT_EQ(words.size() - slotCount, out.front().timestamp);
+    EXPECT_EQ(words.back(), out.back().data[0]);
+}
+
+/**
+ * @tc.name   : Test MidiBroadcastRing Wait
+ * @tc.number : MidiBroadcastRingWait_001
+ * @tc.desc   : Wait times out while nothing is published and returns once a batch arrives.
+ */
+HWTEST_F(MidiBroadcastRingUnitTest, MidiBroadcastRingWait_001, TestSize.Level0)
+{
+    auto ring = MidiBroadcastRing::CreateFromLocal(16);
+    ASSERT_NE(nullptr, ring);
+    MidiBroadcastRing::Cursor cursor;
+    ring->AttachCursor(cursor);
+    auto hasEvents = [&ring, &cursor]() { return ring->HasEvents(cursor); };
+    constexpr int64_t shortWaitNs = 1000000;
+    EXPECT_EQ(FUTEX_TIMEOUT, ring->Wait(shortWaitNs, hasEvents));
+
+    uint32_t noteOn = 0x20903C64;
+    MidiEventInner event = {1, 1, &noteOn};
+    std::thread writer([&ring, &event]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ring->Publish(&event, 1);
+    });
+    constexpr int64_t longWaitNs = 2000000000;
+    EXPECT_EQ(FUTEX_SUCCESS, ring->Wait(longWaitNs, hasEvents));
+    writer.join();
+}
@@ -23,6 +23,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <sys/eventfd.h>
+#include <linux/futex.h>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
@@ -708,5 +709,161 @@ HWTEST_F(MidiSharedRingUnitTest, MidiSharedRingDrainToBatch_003, TestSize.Level0
     // After draining first event, read position should now point to corrupted header offset.
     EXPECT_EQ(corruptOff, ring.GetReadPosition());
 }
+
+/**
+ * @tc.name   : Test MidiSharedRing PeekAfter/MarkConsumed API
+ * @tc.number : MidiSharedRingPeekAfter_001
+ * @tc.desc   : events consumed out of order are skipped by PeekAfter and released by PeekNext,
+ *              a scan position lasts until the read position moves.
+ */
+HWTEST_F(MidiSharedRingUnitTest, MidiSharedRingPeekAfter_001, TestSize.Level0)
+{
+    MidiSharedRing ring(256);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, ring.Init(INVALID_FD));
+
+    std::vector<uint32_t> p1(1, 0x111);
+    std::vector<uint32_t> p2(1, 0x222);
+    std::vector<uint32_t> p3(1, 0x333);
+    MidiEventInner evs[3] = {MakeEvent(1, p1), MakeEvent(0, p2), MakeEvent(3, p3)};
+
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, ring.TryWriteEvents(evs, 3, &written, false));
+    ASSERT_EQ(3u, written);
+
+    MidiSharedRing::PeekedEvent head;
+    ASSERT_EQ(MidiStatusCode::OK, ring.PeekNext(head));
+    EXPECT_EQ(1u, head.timestamp);
+
+    MidiSharedRing::PeekedEvent second;
+    ASSERT_EQ(MidiStatusCode::OK, ring.PeekAfter(head, second));
+    EXPECT_EQ(0u, second.timestamp);
+    ring.MarkConsumed(second);
+    EXPECT_EQ(head.beginOffset, ring.GetReadPosition());
+
+    // consumed event is skipped when scanning again
+    MidiSharedRing::PeekedEvent third;
+    ASSERT_EQ(MidiStatusCode::OK, ring.PeekAfter(head, third));
+    EXPECT_EQ(3u, third.timestamp);
+    MidiSharedRing::PeekedEvent none;
+    EXPECT_EQ(MidiStatusCode::WOULD_BLOCK, ring.PeekAfter(third, none));
+
+    // the scan position is kept while the head stays
+    MidiSharedRing::PeekedEvent scanned;
+    EXPECT_FALSE(ring.GetScanPosition(scanned));
+    ring.SetScanPosition(third);
+    ASSERT_TRUE(ring.GetScanPosition(scanned));
+    EXPECT_EQ(third.beginOffset, scanned.beginOffset);
+
+    // committing the head releases the consumed event as well, and forgets the scan position
+    ring.CommitRead(head);
+    EXPECT_FALSE(ring.GetScanPosition(scanned));
+    MidiSharedRing::PeekedEvent next;
+    ASSERT_EQ(MidiStatusCode::OK, ring.PeekNext(next));
+    EXPECT_EQ(3u, next.timestamp);
+    EXPECT_EQ(third.beginOffset, ring.GetReadPosition());
+    ring.CommitRead(next);
+    EXPECT_TRUE(ring.IsEmpty());
+}
+
+/**
+ * @tc.name   : Test MidiSharedRing notification moderation
+ * @tc.number : MidiSharedRingNotifyModeration_001
+ * @tc.desc   : a napping reader is notified once per maxPendingEvents, an idle reader and a ring past its
+ *              high watermark at once, and every write again once moderation is off.
+ */
+HWTEST_F(MidiSharedRingUnitTest, MidiSharedRingNotifyModeration_001, TestSize.Level0)
+{
+    constexpr uint32_t RING_CAPACITY_BYTES = 1024;
+    auto fd = std::make_shared<UniqueFd>();
+    fd->Reset(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    auto ring = MidiSharedRing::CreateFromLocal(RING_CAPACITY_BYTES, fd);
+    ASSERT_NE(nullptr, ring);
+    auto readNotifications = [&fd]() -> uint64_t {
+        uint64_t counter = 0;
+        return ::read(fd->Get(), &counter, sizeof(counter)) == sizeof(counter) ? counter : 0;
+    };
+    std::vector<uint32_t> payload(1, 0x20903C64);
+    MidiEventInner event = MakeEvent(0, payload);
+
+    ring->SetNotifyModeration(4, MIDI_NOTIFY_MAX_DELAY_US);
+    EXPECT_EQ(static_cast<int64_t>(MIDI_NOTIFY_MAX_DELAY_US) * 1000, ring->GetNotifyDelayNs());
+    ring->SetReaderState(RING_READER_NAPPING);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(event));
+    }
+    EXPECT_EQ(0u, readNotifications());
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(event));
+    EXPECT_EQ(1u, readNotifications());
+
+    ring->SetReaderState(RING_READER_IDLE);
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(event));
+    EXPECT_EQ(1u, readNotifications());
+
+    // past the high watermark every write notifies, whatever the pending count
+    ring->SetNotifyModeration(0, MIDI_NOTIFY_MAX_DELAY_US);
+    ring->SetReaderState(RING_READER_NAPPING);
+    const uint32_t eventBytes = sizeof(ShmMidiEventHeader) + sizeof(uint32_t);
+    uint64_t notified = 0;
+    for (uint32_t used = eventBytes * 5; used + eventBytes < RING_CAPACITY_BYTES; used += eventBytes) {
+        ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(event));
+        notified += readNotifications();
+    }
+    EXPECT_GT(notified, 0u);
+
+    ring->Flush();
+    ring->SetNotifyModeration(4, 0);
+    EXPECT_EQ(0, ring->GetNotifyDelayNs());
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(event));
+    EXPECT_EQ(1u, readNotifications());
+}
+
+/**
+ * @tc.name   : Test MidiSharedRing wake suppression
+ * @tc.number : MidiSharedRingWakeSuppression_001
+ * @tc.desc   : an eventfd ring never wakes the futex for data, skips the eventfd while its reader is active
+ *              and reports those writes when the reader goes to sleep; reads wake only waiting writers.
+ */
+HWTEST_F(MidiSharedRingUnitTest, MidiSharedRingWakeSuppression_001, TestSize.Level0)
+{
+    auto fd = std::make_shared<UniqueFd>();
+    fd->Reset(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    auto ring = MidiSharedRing::CreateFromLocal(1024, fd);
+    ASSERT_NE(nullptr, ring);
+    auto readNotifications = [&fd]() -> uint64_t {
+        uint64_t counter = 0;
+        return ::read(fd->Get(), &counter, sizeof(counter)) == sizeof(counter) ? counter : 0;
+    };
+    int futexWakes = 0;
+    FutexTool::SetStubFunc([&futexWakes](std::atomic<uint32_t> *, int op, int, const struct timespec *) -> long {
+        futexWakes += (op == FUTEX_WAKE) ? 1 : 0;
+        return 0;
+    }, nullptr);
+    ring->GetFutex()->store(IS_NOT_READY);
+    std::vector<uint32_t> payload(1, 0x20903C64);
+    MidiEventInner event = MakeEvent(0, payload);
+
+    // a new ring starts out idle
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(event));
+    EXPECT_EQ(1u, readNotifications());
+
+    ring->MarkReaderActive();
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(event));
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(event));
+    EXPECT_EQ(0u, readNotifications());
+    EXPECT_TRUE(ring->MarkReaderSleeping(RING_READER_IDLE));
+    EXPECT_FALSE(ring->MarkReaderSleeping(RING_READER_IDLE));
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(event));
+    EXPECT_EQ(1u, readNotifications());
+
+    MidiSharedRing::PeekedEvent peeked;
+    ASSERT_EQ(MidiStatusCode::OK, ring->PeekNext(peeked));
+    ring->CommitRead(peeked);
+    EXPECT_EQ(0, futexWakes);
+    ring->GetControlHeader()->spaceWaiters.store(1);
+    ASSERT_EQ(MidiStatusCode::OK, ring->PeekNext(peeked));
+    ring->CommitRead(peeked);
+    EXPECT_EQ(1, futexWakes);
+    FutexTool::SetStubFunc(nullptr, nullptr);
+}
 } // namespace MIDI
 } // namespace OHOS
\ No newline at end of file
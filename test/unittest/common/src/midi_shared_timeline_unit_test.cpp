@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "midi_shared_timeline.h"
+
+using namespace OHOS;
+using namespace MIDI;
+using namespace testing::ext;
+
+namespace {
+std::vector<uint32_t> g_noteOnWords{0x20903C7F};
+
+MidiEventInner MakeTimelineEvent(uint64_t position, uint16_t tag = 0)
+{
+    MidiEventInner event{};
+    event.timestamp = position;
+    event.length = g_noteOnWords.size();
+    event.data = g_noteOnWords.data();
+    event.tag = tag;
+    return event;
+}
+} // namespace
+
+class MidiSharedTimelineUnitTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+/**
+ * @tc.name   : Test MidiSharedTimeline Append
+ * @tc.number : MidiSharedTimelineAppend_001
+ * @tc.desc   : Positions must not go backwards, a full timeline reports WOULD_BLOCK with a partial count.
+ */
+HWTEST_F(MidiSharedTimelineUnitTest, MidiSharedTimelineAppend_001, TestSize.Level0)
+{
+    EXPECT_EQ(nullptr, MidiSharedTimeline::CreateFromLocal(0));
+    EXPECT_EQ(nullptr, MidiSharedTimeline::CreateFromLocal(MIDI_TIMELINE_MAX_CAPACITY + 1));
+
+    constexpr uint32_t eventBytes = sizeof(ShmMidiEventHeader) + sizeof(uint32_t);
+    auto timeline = MidiSharedTimeline::CreateFromLocal(eventBytes * 3);
+    ASSERT_NE(nullptr, timeline);
+
+    uint32_t written = 0;
+    std::vector<MidiEventInner> events{MakeTimelineEvent(10), MakeTimelineEvent(5)};
+    EXPECT_EQ(MidiStatusCode::INVALID_ARGUMENT, timeline->Append(events.data(), events.size(), &written));
+    EXPECT_EQ(1u, written);
+
+    events = {MakeTimelineEvent(10), MakeTimelineEvent(20), MakeTimelineEvent(30)};
+    EXPECT_EQ(MidiStatusCode::WOULD_BLOCK, timeline->Append(events.data(), events.size(), &written));
+    EXPECT_EQ(2u, written);
+
+    // Clear starts over, positions may begin anywhere again
+    timeline->Clear();
+    events = {MakeTimelineEvent(1), MakeTimelineEvent(2), MakeTimelineEvent(3)};
+    EXPECT_EQ(MidiStatusCode::OK, timeline->Append(events.data(), events.size(), &written));
+    EXPECT_EQ(3u, written);
+}
+
+/**
+ * @tc.name   : Test MidiSharedTimeline Playback
+ * @tc.number : MidiSharedTimelinePlayback_001
+ * @tc.desc   : Due times follow the start timestamp and position, a stopped timeline yields nothing.
+ */
+HWTEST_F(MidiSharedTimelineUnitTest, MidiSharedTimelinePlayback_001, TestSize.Level0)
+{
+    auto timeline = MidiSharedTimeline::CreateFromLocal(1024);
+    ASSERT_NE(nullptr, timeline);
+    std::vector<MidiEventInner> events{MakeTimelineEvent(0, 1), MakeTimelineEvent(100, 2), MakeTimelineEvent(200, 3)};
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, timeline->Append(events.data(), events.size(), &written));
+
+    MidiSharedTimeline::Cursor cursor;
+    MidiSharedRing::PeekedEvent event{};
+    uint64_t due = 0;
+    EXPECT_FALSE(timeline->PeekNext(cursor, event, due));
+
+    // start from position 100 at time 5000
+    timeline->Start(5000, 100);
+    ASSERT_TRUE(timeline->PeekNext(cursor, event, due));
+    EXPECT_EQ(5000u, due);
+    EXPECT_EQ(2u, event.tag);
+    timeline->Advance(cursor, event);
+    ASSERT_TRUE(timeline->PeekNext(cursor, event, due));
+    EXPECT_EQ(5100u, due);
+    timeline->Advance(cursor, event);
+    EXPECT_FALSE(timeline->PeekNext(cursor, event, due));
+
+    // more events keep playing from where the cursor is
+    events = {MakeTimelineEvent(300)};
+    ASSERT_EQ(MidiStatusCode::OK, timeline->Append(events.data(), events.size(), &written));
+    ASSERT_TRUE(timeline->PeekNext(cursor, event, due));
+    EXPECT_EQ(5200u, due);
+
+    timeline->Stop();
+    EXPECT_FALSE(timeline->PeekNext(cursor, event, due));
+}
+
+/**
+ * @tc.name   : Test MidiSharedTimeline Loop
+ * @tc.number : MidiSharedTimelineLoop_001
+ * @tc.desc   : The loop region repeats with due times moving on by the loop length, an empty loop is not entered,
+ *               the loop begin offset is looked up again only when the loop moves.
+ */
+HWTEST_F(MidiSharedTimelineUnitTest, MidiSharedTimelineLoop_001, TestSize.Level0)
+{
+    auto timeline = MidiSharedTimeline::CreateFromLocal(1024);
+    ASSERT_NE(nullptr, timeline);
+    std::vector<MidiEventInner> events{MakeTimelineEvent(0), MakeTimelineEvent(100), MakeTimelineEvent(200),
+        MakeTimelineEvent(400)};
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, timeline->Append(events.data(), events.size(), &written));
+    timeline->SetLoop(100, 300);
+    timeline->Start(1000, 0);
+
+    MidiSharedTimeline::Cursor cursor;
+    MidiSharedRing::PeekedEvent event{};
+    uint64_t due = 0;
+    std::vector<uint64_t> dues;
+    for (int i = 0; i < 7; i++) {
+        ASSERT_TRUE(timeline->PeekNext(cursor, event, due));
+        dues.push_back(due);
+        timeline->Advance(cursor, event);
+    }
+    std::vector<uint64_t> expected{1000, 1100, 1200, 1300, 1400, 1500, 1600};
+    EXPECT_EQ(expected, dues);
+    // the loop begin is looked up once, later passes reuse its offset
+    ASSERT_TRUE(cursor.loopValid);
+    EXPECT_EQ(100u, cursor.loopBegin);
+    const uint32_t loopOffset = cursor.loopOffset;
+    EXPECT_GT(loopOffset, 0u);
+
+    // nothing between 250 and 300: the cursor stays put instead of spinning
+    timeline->SetLoop(250, 300);
+    EXPECT_FALSE(timeline->PeekNext(cursor, event, due));
+    EXPECT_EQ(250u, cursor.loopBegin);
+    EXPECT_GT(cursor.loopOffset, loopOffset);
+    timeline->SetLoop(0, 0);
+    ASSERT_TRUE(timeline->PeekNext(cursor, event, due));
+    EXPECT_EQ(400u, event.timestamp);
+}
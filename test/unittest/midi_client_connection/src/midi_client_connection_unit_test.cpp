@@ -143,6 +143,43 @@ HWTEST_F(MidiClientConnectionUnitTest, ClientConnectionInServerTrySendToClient_0
     EXPECT_EQ(OH_MIDI_STATUS_SYSTEM_ERROR, lastReturnCode);
 }
 
+/**
+ * @tc.name   : Test ClientConnectionInServer TrySendToClient batch
+ * @tc.number : ClientConnectionInServerTrySendToClient_003
+ * @tc.desc   : A batch lands in one write, an event that does not fit is dropped and later ones still go in.
+ */
+HWTEST_F(MidiClientConnectionUnitTest, ClientConnectionInServerTrySendToClient_003, TestSize.Level0)
+{
+    ClientConnectionInServer clientConnection(12, 24, 36);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, clientConnection.CreateRingBuffer());
+
+    // 7 events of 272 bytes fill most of the 2048 byte ring, the 8th does not fit but a 1 word event does
+    std::vector<uint32_t> bigPayload(64, 0xA5A5A5A5);
+    std::vector<uint32_t> smallPayload{0x20903C64};
+    std::vector<MidiEventInner> batch;
+    for (uint64_t timestamp = 1; timestamp <= 8; ++timestamp) {
+        batch.push_back(MakeMidiEventInner(timestamp, bigPayload));
+    }
+    batch.push_back(MakeMidiEventInner(9, smallPayload));
+
+    EXPECT_EQ(OH_MIDI_STATUS_SYSTEM_ERROR, clientConnection.TrySendToClient(batch.data(), batch.size()));
+
+    std::shared_ptr<MidiSharedRing> sharedRing = clientConnection.GetRingBuffer();
+    ASSERT_NE(nullptr, sharedRing);
+    std::vector<MidiEvent> events;
+    std::vector<std::vector<uint32_t>> payloads;
+    sharedRing->DrainToBatch(events, payloads, 0);
+    ASSERT_EQ(8u, events.size());
+    EXPECT_EQ(7u, events[6].timestamp);
+    EXPECT_EQ(9u, events[7].timestamp);
+    ASSERT_EQ(1u, events[7].length);
+    EXPECT_EQ(smallPayload[0], events[7].data[0]);
+
+    std::vector<MidiEventInner> fitting(batch.begin(), batch.begin() + 2);
+    EXPECT_EQ(OH_MIDI_STATUS_OK, clientConnection.TrySendToClient(fitting.data(), fitting.size()));
+    EXPECT_EQ(OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, clientConnection.TrySendToClient(nullptr, 0));
+}
+
 /**
  * @tc.name   : Test ClientConnectionInServer Pending Queue
  * @tc.number : ClientConnectionInServerPendingQueue_001
@@ -245,5 +282,157 @@ HWTEST_F(MidiClientConnectionUnitTest, ClientConnectionInServerPendingQueue_002,
     EXPECT_EQ(nullptr, clientConnection.PeekPendingTop());
 }
 
+/**
+ * @tc.name   : Test ClientConnectionInServer Rate Limit
+ * @tc.number : ClientConnectionInServerRateLimit_001
+ * @tc.desc   : Token bucket allows a 100ms burst, then throttles until the debt is paid back.
+ */
+HWTEST_F(MidiClientConnectionUnitTest, ClientConnectionInServerRateLimit_001, TestSize.Level0)
+{
+    ClientConnectionInServer clientConnection(1, 2, 3);
+    const auto nowTime = steady_clock::now();
+
+    // unlimited by default
+    EXPECT_FALSE(clientConnection.IsRateLimited(nowTime));
+    clientConnection.ChargeRate(1000000);
+    EXPECT_FALSE(clientConnection.IsRateLimited(nowTime));
+
+    clientConnection.SetMaxBytesPerSecond(1000); // burst 100 bytes
+    EXPECT_FALSE(clientConnection.IsRateLimited(nowTime));
+    clientConnection.ChargeRate(150);
+    EXPECT_TRUE(clientConnection.IsRateLimited(nowTime));
+
+    // 50 bytes of debt at 1000 bytes/s takes 50ms
+    const auto resumeTime = clientConnection.GetRateResumeTime();
+    EXPECT_GE(resumeTime, nowTime + milliseconds(50));
+    EXPECT_LT(resumeTime, nowTime + milliseconds(51));
+    EXPECT_TRUE(clientConnection.IsRateLimited(nowTime + milliseconds(40)));
+    EXPECT_FALSE(clientConnection.IsRateLimited(resumeTime));
+}
+
+/**
+ * @tc.name   : Test ClientConnectionInServer Deficit
+ * @tc.number : ClientConnectionInServerDeficit_001
+ * @tc.desc   : Weight is at least 1; deficit is added, used per event and reset.
+ */
+HWTEST_F(MidiClientConnectionUnitTest, ClientConnectionInServerDeficit_001, TestSize.Level0)
+{
+    ClientConnectionInServer clientConnection(1, 2, 3);
+    EXPECT_EQ(1u, clientConnection.GetWeight());
+    clientConnection.SetWeight(0);
+    EXPECT_EQ(1u, clientConnection.GetWeight());
+    clientConnection.SetWeight(3);
+    EXPECT_EQ(3u, clientConnection.GetWeight());
+
+    EXPECT_FALSE(clientConnection.HasDeficit());
+    clientConnection.AddDeficit(2);
+    EXPECT_TRUE(clientConnection.HasDeficit());
+    clientConnection.UseDeficit();
+    EXPECT_TRUE(clientConnection.HasDeficit());
+    clientConnection.UseDeficit();
+    EXPECT_FALSE(clientConnection.HasDeficit());
+    clientConnection.UseDeficit();
+    EXPECT_FALSE(clientConnection.HasDeficit());
+
+    clientConnection.AddDeficit(5);
+    clientConnection.ResetDeficit();
+    EXPECT_FALSE(clientConnection.HasDeficit());
+}
+
+/**
+ * @tc.name   : Test ClientConnectionInServer Cancel Scheduled
+ * @tc.number : ClientConnectionInServerCancel_001
+ * @tc.desc   : Events are cancelled by tag and by time range from the heap, heap order is kept.
+ */
+HWTEST_F(MidiClientConnectionUnitTest, ClientConnectionInServerCancel_001, TestSize.Level0)
+{
+    ClientConnectionInServer clientConnection(1, 2, 3);
+    const auto baseTime = steady_clock::now();
+    constexpr uint64_t eventCount = 32;
+    constexpr uint16_t clipTag = 7;
+    // timestamps 1..32 in a scrambled order, every third event belongs to the clip
+    for (uint64_t i = 0; i < eventCount; i++) {
+        const uint64_t timestamp = (i * 13) % eventCount + 1;
+        const uint16_t tag = (timestamp % 3 == 0) ? clipTag : 0;
+        ASSERT_TRUE(clientConnection.EnqueueNonRealtime({0x20903C7F}, baseTime + milliseconds(timestamp), timestamp,
+            tag));
+    }
+
+    EXPECT_EQ(10u, clientConnection.CancelScheduled(clipTag, 0, UINT64_MAX));
+    EXPECT_EQ(0u, clientConnection.CancelScheduled(clipTag, 0, UINT64_MAX));
+    // then everything left in 20..25, whatever its tag
+    EXPECT_EQ(4u, clientConnection.CancelScheduled(MIDI_EVENT_TAG_ANY, 20, 25));
+
+    std::vector<uint64_t> remaining;
+    ClientConnectionInServer::PendingEvent poppedEvent{};
+    while (clientConnection.PopPendingTop(poppedEvent)) {
+        remaining.push_back(poppedEvent.timestamp);
+    }
+    std::vector<uint64_t> expected;
+    for (uint64_t timestamp = 1; timestamp <= eventCount; timestamp++) {
+        if (timestamp % 3 != 0 && (timestamp < 20 || timestamp > 25)) {
+            expected.push_back(timestamp);
+        }
+    }
+    EXPECT_EQ(expected, remaining);
+}
+
+/**
+ * @tc.name   : Test ClientConnectionInServer Cancel Scheduled In Ring
+ * @tc.number : ClientConnectionInServerCancel_002
+ * @tc.desc   : Tagged events not yet drained from the ring are skipped, immediate events are kept.
+ */
+HWTEST_F(MidiClientConnectionUnitTest, ClientConnectionInServerCancel_002, TestSize.Level0)
+{
+    ClientConnectionInServer clientConnection(1, 2, 3);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, clientConnection.CreateRingBuffer());
+    auto ring = clientConnection.GetRingBuffer();
+    ASSERT_NE(nullptr, ring);
+
+    std::vector<uint32_t> payloadWords{0x20903C7F};
+    MidiEventInner tagged = MakeMidiEventInner(100, payloadWords);
+    tagged.tag = 5;
+    MidiEventInner otherTag = MakeMidiEventInner(200, payloadWords);
+    otherTag.tag = 6;
+    MidiEventInner immediate = MakeMidiEventInner(0, payloadWords);
+    immediate.tag = 5;
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(tagged, false));
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(otherTag, false));
+    ASSERT_EQ(MidiStatusCode::OK, ring->TryWriteEvent(immediate, false));
+
+    EXPECT_EQ(1u, clientConnection.CancelScheduled(5, 0, UINT64_MAX));
+
+    MidiSharedRing::PeekedEvent ringEvent{};
+    ASSERT_EQ(MidiStatusCode::OK, ring->PeekNext(ringEvent));
+    EXPECT_EQ(200u, ringEvent.timestamp);
+    EXPECT_EQ(6u, ringEvent.tag);
+    ring->CommitRead(ringEvent);
+    ASSERT_EQ(MidiStatusCode::OK, ring->PeekNext(ringEvent));
+    EXPECT_EQ(0u, ringEvent.timestamp);
+    ring->CommitRead(ringEvent);
+    EXPECT_EQ(MidiStatusCode::WOULD_BLOCK, ring->PeekNext(ringEvent));
+}
+
+/**
+ * @tc.name   : Test ClientConnectionInServer Latest Due
+ * @tc.number : ClientConnectionInServerLatestDue_001
+ * @tc.desc   : FindLatestDueUntil reports the latest pending due time not after the limit.
+ */
+HWTEST_F(MidiClientConnectionUnitTest, ClientConnectionInServerLatestDue_001, TestSize.Level0)
+{
+    ClientConnectionInServer clientConnection(1, 2, 3);
+    const auto baseTime = steady_clock::now();
+    steady_clock::time_point latestDue{};
+    EXPECT_FALSE(clientConnection.FindLatestDueUntil(baseTime, latestDue));
+
+    for (uint64_t offsetMs : {7, 1, 30, 3, 12, 5}) {
+        ASSERT_TRUE(clientConnection.EnqueueNonRealtime({0x20903C7F}, baseTime + milliseconds(offsetMs), offsetMs));
+    }
+    ASSERT_TRUE(clientConnection.FindLatestDueUntil(baseTime + milliseconds(10), latestDue));
+    EXPECT_EQ(baseTime + milliseconds(7), latestDue);
+    ASSERT_TRUE(clientConnection.FindLatestDueUntil(baseTime + milliseconds(1), latestDue));
+    EXPECT_EQ(baseTime + milliseconds(1), latestDue);
+    EXPECT_FALSE(clientConnection.FindLatestDueUntil(baseTime, latestDue));
+}
 } // namespace MIDI
 } // namespace OHOS
@@ -93,6 +93,39 @@ static void MidiReceivedTrampoline(void *userData, const OH_MIDIEvent *events, s
     }
 }
 
+class PeriodCapture {
+public:
+    void OnReceived(uint64_t periodFramePosition, const OH_MIDIPeriodEvent *events, size_t eventCount)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        periodFramePosition_ = periodFramePosition;
+        events_.assign(events, events + eventCount);
+        condition_.notify_all();
+    }
+
+    bool WaitForEvents(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return condition_.wait_for(lock, timeout, [this]() { return !events_.empty(); });
+    }
+
+    uint64_t periodFramePosition_ = 0;
+    std::vector<OH_MIDIPeriodEvent> events_;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+static void MidiPeriodTrampoline(void *userData, uint64_t periodFramePosition, const OH_MIDIPeriodEvent *events,
+    size_t eventCount)
+{
+    auto *capture = reinterpret_cast<PeriodCapture *>(userData);
+    if (capture != nullptr) {
+        capture->OnReceived(periodFramePosition, events, eventCount);
+    }
+}
+
 }  // namespace
 
 class MidiServiceMock : public MidiServiceInterface {
@@ -110,6 +143,19 @@ public:
     MOCK_METHOD(OH_MIDIStatusCode, OpenOutputPort,
         ((std::shared_ptr<MidiSharedRing>)&buffer, int64_t deviceId, uint32_t portIndex), (override));
     MOCK_METHOD(OH_MIDIStatusCode, FlushOutputPort, (int64_t deviceId, uint32_t portIndex), (override));
+    MOCK_METHOD(OH_MIDIStatusCode, CancelScheduledEvents,
+        (int64_t deviceId, uint32_t portIndex, uint16_t tag, uint64_t beginTimestamp, uint64_t endTimestamp),
+        (override));
+    MOCK_METHOD(OH_MIDIStatusCode, OpenOutputTimeline,
+        ((std::shared_ptr<MidiSharedTimeline>)&timeline, int64_t deviceId, uint32_t portIndex,
+        uint32_t capacityBytes), (override));
+    MOCK_METHOD(OH_MIDIStatusCode, SetOutputPortExclusive, (int64_t deviceId, uint32_t portIndex, bool exclusive),
+        (override));
+    MOCK_METHOD(OH_MIDIStatusCode, OpenInputPortBroadcast,
+        ((std::shared_ptr<MidiBroadcastRing>)&ring, int64_t deviceId, uint32_t portIndex), (override));
+    MOCK_METHOD(OH_MIDIStatusCode, OpenInputPortWithFilter,
+        ((std::shared_ptr<MidiSharedRing>)&buffer, int64_t deviceId, uint32_t portIndex,
+            const MidiInputFilter &filter), (override));
     MOCK_METHOD(OH_MIDIStatusCode, CloseInputPort, (int64_t deviceId, uint32_t portIndex), (override));
     MOCK_METHOD(OH_MIDIStatusCode, CloseOutputPort, (int64_t deviceId, uint32_t portIndex), (override));
     MOCK_METHOD(OH_MIDIStatusCode, DestroyMidiClient, (), (override));
@@ -574,6 +620,295 @@ HWTEST_F(MidiClientUnitTest, MidiDevicePrivate_OpenInputPort_003, TestSize.Level
     EXPECT_EQ(device->CloseInputPort(portIndex), OH_MIDI_STATUS_INVALID_PORT);
 }
 
+/**
+ * @tc.name: MidiDevicePrivate_OpenInputPortWithFilter_001
+ * @tc.desc: OpenInputPortWithFilter hands the filter to the service and receives like a plain input port.
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiClientUnitTest, MidiDevicePrivate_OpenInputPortWithFilter_001, TestSize.Level0)
+{
+    int64_t deviceId = 2004;
+    uint32_t portIndex = 3;
+    auto device = std::make_unique<MidiDevicePrivate>(mockService, deviceId);
+    OH_MIDIPortDescriptor descriptor;
+    descriptor.portIndex = portIndex;
+    descriptor.protocol = MIDI_PROTOCOL_1_0;
+    OH_MIDIInputFilter filter{};
+    filter.dropRealtime = true;
+    filter.droppedChannels = 0x8000;
+    CallbackCapture callbackCapture;
+
+    EXPECT_CALL(*mockService, OpenInputPortWithFilter(_, deviceId, portIndex, _))
+        .Times(1)
+        .WillOnce(Invoke([](std::shared_ptr<MidiSharedRing> &buffer, int64_t, uint32_t,
+            const MidiInputFilter &inputFilter) {
+            EXPECT_TRUE(inputFilter.dropRealtime);
+            EXPECT_EQ(inputFilter.droppedChannels, 0x8000);
+            EXPECT_EQ(inputFilter.droppedMessageTypes, 0);
+            buffer = MidiSharedRing::CreateFromLocal(256);
+            return OH_MIDI_STATUS_OK;
+        }));
+    EXPECT_CALL(*mockService, CloseInputPort(deviceId, portIndex)).Times(1).WillOnce(Return(OH_MIDI_STATUS_OK));
+
+    EXPECT_EQ(device->OpenInputPortWithFilter(descriptor, filter, MidiReceivedTrampoline, &callbackCapture),
+        OH_MIDI_STATUS_OK);
+    EXPECT_EQ(device->OpenInputPort(descriptor, MidiReceivedTrampoline, &callbackCapture),
+        OH_MIDI_STATUS_PORT_ALREADY_OPEN);
+    EXPECT_EQ(device->CloseInputPort(portIndex), OH_MIDI_STATUS_OK);
+}
+
+/**
+ * @tc.name: MidiDevicePrivate_SetPortNotifyModeration_001
+ * @tc.desc: Moderation is set on the ring of an open port, events held back by the writer still arrive.
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiClientUnitTest, MidiDevicePrivate_SetPortNotifyModeration_001, TestSize.Level0)
+{
+    int64_t deviceId = 2005;
+    uint32_t portIndex = 1;
+    auto device = std::make_unique<MidiDevicePrivate>(mockService, deviceId);
+    OH_MIDIPortDescriptor descriptor;
+    descriptor.portIndex = portIndex;
+    descriptor.protocol = MIDI_PROTOCOL_2_0;
+    CallbackCapture callbackCapture;
+    std::shared_ptr<MidiSharedRing> serverRing;
+
+    EXPECT_CALL(*mockService, OpenInputPort(_, deviceId, portIndex))
+        .Times(1)
+        .WillOnce(Invoke([&serverRing](std::shared_ptr<MidiSharedRing> &buffer, int64_t, uint32_t) {
+            buffer = MidiSharedRing::CreateFromLocal(256);
+            serverRing = buffer;
+            return OH_MIDI_STATUS_OK;
+        }));
+    EXPECT_CALL(*mockService, CloseInputPort(deviceId, portIndex)).Times(1).WillOnce(Return(OH_MIDI_STATUS_OK));
+    ASSERT_EQ(device->OpenInputPort(descriptor, MidiReceivedTrampoline, &callbackCapture), OH_MIDI_STATUS_OK);
+
+    EXPECT_EQ(device->SetPortNotifyModeration(portIndex, MIDI_PORT_DIRECTION_OUTPUT, 100, 5000),
+        OH_MIDI_STATUS_INVALID_PORT);
+    EXPECT_EQ(device->SetPortNotifyModeration(portIndex, MIDI_PORT_DIRECTION_INPUT, 100,
+        MIDI_NOTIFY_MAX_DELAY_US + 1), OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT);
+    EXPECT_EQ(device->SetPortNotifyModeration(portIndex, MIDI_PORT_DIRECTION_INPUT, 100, 5000), OH_MIDI_STATUS_OK);
+    ASSERT_NE(serverRing, nullptr);
+    EXPECT_EQ(serverRing->GetNotifyDelayNs(), 5000000);
+
+    // far below maxPendingEvents: a napping receiver collects them when its nap ends
+    uint32_t word = 0x20903C64;
+    MidiEventInner events[3] = {{0, 1, &word}, {0, 1, &word}, {0, 1, &word}};
+    uint32_t written = 0;
+    ASSERT_EQ(serverRing->TryWriteEvents(events, 3, &written), MidiStatusCode::OK);
+    EXPECT_TRUE(callbackCapture.WaitForAtLeast(3, std::chrono::milliseconds(1000)));
+    EXPECT_EQ(device->CloseInputPort(portIndex), OH_MIDI_STATUS_OK);
+}
+
+/**
+ * @tc.name: MidiPeriodClock_001
+ * @tc.desc: Times map to frames of the audio clock, events land one period late at their distance to its start.
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiClientUnitTest, MidiPeriodClock_001, TestSize.Level0)
+{
+    EXPECT_FALSE(MidiPeriodClock::IsValidConfig(0, 48000));
+    EXPECT_FALSE(MidiPeriodClock::IsValidConfig(256, 1000));
+    EXPECT_TRUE(MidiPeriodClock::IsValidConfig(256, 48000));
+
+    MidiPeriodClock clock(480, 48000);
+    Timestamp reference;
+    reference.framePosition = 96000;
+    reference.time.tv_sec = 10;
+    clock.SetReference(reference);
+    const int64_t referenceNs = 10000000000;
+    EXPECT_EQ(clock.FrameAt(referenceNs), 96000);
+    EXPECT_EQ(clock.FrameAt(referenceNs + 1000000), 96048);
+    EXPECT_EQ(clock.FrameAt(referenceNs - 1), 95999);
+    EXPECT_EQ(clock.FrameAt(clock.TimeOfFrame(96001)), 96001);
+    EXPECT_EQ(clock.NextPeriodStart(referenceNs), 96480);
+    EXPECT_EQ(clock.NextPeriodStart(referenceNs - 1), 96000);
+
+    uint32_t frameOffset = 0;
+    EXPECT_TRUE(clock.GetFrameOffset(clock.TimeOfFrame(96100), 96480, frameOffset));
+    EXPECT_EQ(frameOffset, 100u);
+    EXPECT_TRUE(clock.GetFrameOffset(clock.TimeOfFrame(95000), 96480, frameOffset));
+    EXPECT_EQ(frameOffset, 0u);
+    EXPECT_FALSE(clock.GetFrameOffset(clock.TimeOfFrame(96480), 96480, frameOffset));
+}
+
+/**
+ * @tc.name: MidiInputPort_ReadEvents_001
+ * @tc.desc: A port without callback has no thread, reads point into the ring and release it on the next read,
+ *           a read while another one holds the port returns no events.
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiClientUnitTest, MidiInputPort_ReadEvents_001, TestSize.Level0)
+{
+    MidiInputPort inputPort(nullptr, nullptr, MIDI_PROTOCOL_1_0);
+    std::shared_ptr<MidiSharedRing> localRing = MidiSharedRing::CreateFromLocal(128);
+    ASSERT_NE(localRing, nullptr);
+    inputPort.GetRingBuffer() = localRing;
+    ASSERT_TRUE(inputPort.StartReceiverThread());
+    EXPECT_FALSE(inputPort.receiverThread_.joinable());
+
+    OH_MIDIEvent events[4] = {};
+    size_t eventCount = 0;
+    EXPECT_EQ(inputPort.ReadEvents(events, 4, &eventCount), OH_MIDI_STATUS_OK);
+    EXPECT_EQ(eventCount, 0u);
+    std::vector<uint32_t> words{0x20903C64, 0x20803C00};
+    for (uint32_t word : words) {
+        ASSERT_EQ(MidiStatusCode::OK, localRing->TryWriteEvent(MakeMidiEventInner(1, {word}), true));
+    }
+    {
+        // another reader is busy with the port, the call returns at once with nothing
+        std::lock_guard<std::mutex> lock(inputPort.readMutex_);
+        eventCount = 1;
+        EXPECT_EQ(inputPort.ReadEvents(events, 4, &eventCount), OH_MIDI_STATUS_OK);
+        EXPECT_EQ(eventCount, 0u);
+    }
+    EXPECT_EQ(inputPort.ReadEvents(events, 1, &eventCount), OH_MIDI_STATUS_OK);
+    ASSERT_EQ(eventCount, 1u);
+    EXPECT_EQ(events[0].data[0], words[0]);
+    EXPECT_EQ(localRing->GetReadPosition(), 0u);
+    EXPECT_EQ(inputPort.ReadEvents(events, 4, &eventCount), OH_MIDI_STATUS_OK);
+    ASSERT_EQ(eventCount, 1u);
+    EXPECT_EQ(events[0].data[0], words[1]);
+
+    // several laps around the small ring, events ending right at its end included
+    for (uint32_t round = 0; round < 50; round++) {
+        std::vector<uint32_t> firstWords{0x20903C00 + round};
+        std::vector<uint32_t> secondWords{0x40903C00 + round, 0x80000000};
+        ASSERT_EQ(MidiStatusCode::OK, localRing->TryWriteEvent(MakeMidiEventInner(round, firstWords), true));
+        ASSERT_EQ(MidiStatusCode::OK, localRing->TryWriteEvent(MakeMidiEventInner(round, secondWords), true));
+        EXPECT_EQ(inputPort.ReadEvents(events, 4, &eventCount), OH_MIDI_STATUS_OK);
+        ASSERT_EQ(eventCount, 2u);
+        EXPECT_EQ(events[0].data[0], firstWords[0]);
+        ASSERT_EQ(events[1].length, secondWords.size());
+        EXPECT_EQ(events[1].data[0], secondWords[0]);
+        EXPECT_EQ(events[1].timestamp, round);
+        EXPECT_FALSE(localRing->IsEmpty());
+    }
+    EXPECT_EQ(inputPort.ReadEvents(events, 4, &eventCount), OH_MIDI_STATUS_OK);
+    EXPECT_EQ(eventCount, 0u);
+    EXPECT_TRUE(localRing->IsEmpty());
+
+    CallbackCapture callbackCapture;
+    MidiInputPort callbackPort(MidiReceivedTrampoline, &callbackCapture, MIDI_PROTOCOL_1_0);
+    callbackPort.GetRingBuffer() = MidiSharedRing::CreateFromLocal(128);
+    EXPECT_EQ(callbackPort.ReadEvents(events, 4, &eventCount), OH_MIDI_STATUS_INVALID_PORT);
+}
+
+/**
+ * @tc.name: MidiInputPort_ReadPeriodEvents_001
+ * @tc.desc: A periodic port without callback has no thread, each read returns the events before its period,
+ *           never more than the buffers reserved at open hold.
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiClientUnitTest, MidiInputPort_ReadPeriodEvents_001, TestSize.Level0)
+{
+    OH_MIDIPeriodConfig config{480, 48000};
+    MidiInputPort inputPort(config, nullptr, nullptr, MIDI_PROTOCOL_1_0);
+    std::shared_ptr<MidiSharedRing> localRing = MidiSharedRing::CreateFromLocal(512);
+    ASSERT_NE(localRing, nullptr);
+    inputPort.GetRingBuffer() = localRing;
+    ASSERT_TRUE(inputPort.StartReceiverThread());
+    EXPECT_FALSE(inputPort.receiverThread_.joinable());
+
+    Timestamp reference;
+    reference.time.tv_sec = 1;
+    inputPort.SetPeriodClock(reference);
+    MidiPeriodClock clock(480, 48000);
+    clock.SetReference(reference);
+
+    std::vector<uint32_t> payloadWords{0x20903C64};
+    for (int64_t frame : {500, 700, 1000}) {
+        MidiEventInner midiEventInner = MakeMidiEventInner(clock.TimeOfFrame(frame), payloadWords);
+        ASSERT_EQ(MidiStatusCode::OK, localRing->TryWriteEvent(midiEventInner, true));
+    }
+
+    OH_MIDIPeriodEvent events[4] = {};
+    size_t eventCount = 0;
+    EXPECT_EQ(inputPort.ReadPeriodEvents(960, events, 1, &eventCount), OH_MIDI_STATUS_OK);
+    ASSERT_EQ(eventCount, 1u);
+    EXPECT_EQ(events[0].frameOffset, 20u);
+    EXPECT_EQ(inputPort.ReadPeriodEvents(960, events, 4, &eventCount), OH_MIDI_STATUS_OK);
+    ASSERT_EQ(eventCount, 1u);
+    EXPECT_EQ(events[0].frameOffset, 220u);
+    EXPECT_EQ(events[0].event.data[0], payloadWords[0]);
+    EXPECT_EQ(inputPort.ReadPeriodEvents(1440, events, 4, &eventCount), OH_MIDI_STATUS_OK);
+    ASSERT_EQ(eventCount, 1u);
+    EXPECT_EQ(events[0].frameOffset, 40u);
+    EXPECT_TRUE(localRing->IsEmpty());
+
+    // a burst larger than the reserved buffers is split over reads instead of growing them
+    std::shared_ptr<MidiSharedRing> burstRing = MidiSharedRing::CreateFromLocal(6144);
+    ASSERT_NE(burstRing, nullptr);
+    inputPort.GetRingBuffer() = burstRing;
+    const size_t reservedEvents = inputPort.periodEvents_.capacity();
+    const size_t reservedWords = inputPort.periodWords_.capacity();
+    const size_t burstLength = 64;
+    const size_t burstCount = reservedWords / burstLength + 1;
+    std::vector<uint32_t> burstWords(burstLength, payloadWords[0]);
+    for (size_t i = 0; i < burstCount; i++) {
+        ASSERT_EQ(MidiStatusCode::OK, burstRing->TryWriteEvent(
+            MakeMidiEventInner(clock.TimeOfFrame(1500), burstWords), true));
+    }
+    std::vector<OH_MIDIPeriodEvent> burstEvents(burstCount);
+    EXPECT_EQ(inputPort.ReadPeriodEvents(1920, burstEvents.data(), burstCount, &eventCount), OH_MIDI_STATUS_OK);
+    EXPECT_EQ(eventCount, burstCount - 1);
+    EXPECT_EQ(burstEvents[burstCount - 2].event.data[burstLength - 1], payloadWords[0]);
+    EXPECT_EQ(inputPort.ReadPeriodEvents(1920, burstEvents.data(), burstCount, &eventCount), OH_MIDI_STATUS_OK);
+    EXPECT_EQ(eventCount, 1u);
+    EXPECT_EQ(inputPort.periodEvents_.capacity(), reservedEvents);
+    EXPECT_EQ(inputPort.periodWords_.capacity(), reservedWords);
+    EXPECT_TRUE(burstRing->IsEmpty());
+}
+
+/**
+ * @tc.name: MidiDevicePrivate_OpenInputPortPeriodic_001
+ * @tc.desc: A periodic port with callback delivers events with their frame offset once the next period starts.
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiClientUnitTest, MidiDevicePrivate_OpenInputPortPeriodic_001, TestSize.Level0)
+{
+    int64_t deviceId = 2006;
+    uint32_t portIndex = 2;
+    auto device = std::make_unique<MidiDevicePrivate>(mockService, deviceId);
+    OH_MIDIPortDescriptor descriptor;
+    descriptor.portIndex = portIndex;
+    descriptor.protocol = MIDI_PROTOCOL_2_0;
+    PeriodCapture periodCapture;
+    std::shared_ptr<MidiSharedRing> serverRing;
+
+    OH_MIDIPeriodConfig config{0, 48000};
+    EXPECT_EQ(device->OpenInputPortPeriodic(descriptor, config, MidiPeriodTrampoline, &periodCapture),
+        OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT);
+    EXPECT_CALL(*mockService, OpenInputPort(_, deviceId, portIndex))
+        .Times(1)
+        .WillOnce(Invoke([&serverRing](std::shared_ptr<MidiSharedRing> &buffer, int64_t, uint32_t) {
+            buffer = MidiSharedRing::CreateFromLocal(256);
+            serverRing = buffer;
+            return OH_MIDI_STATUS_OK;
+        }));
+    EXPECT_CALL(*mockService, CloseInputPort(deviceId, portIndex)).Times(1).WillOnce(Return(OH_MIDI_STATUS_OK));
+    config.framesPerPeriod = 480;
+    ASSERT_EQ(device->OpenInputPortPeriodic(descriptor, config, MidiPeriodTrampoline, &periodCapture),
+        OH_MIDI_STATUS_OK);
+    const uint64_t now = static_cast<uint64_t>(ClockTime::GetCurNano());
+    EXPECT_EQ(device->SetPeriodClock(portIndex, 48000, now), OH_MIDI_STATUS_OK);
+    OH_MIDIPeriodEvent events[1] = {};
+    size_t eventCount = 0;
+    EXPECT_EQ(device->ReadPeriodEvents(portIndex, 48000, events, 1, &eventCount), OH_MIDI_STATUS_INVALID_PORT);
+
+    ASSERT_NE(serverRing, nullptr);
+    uint32_t word = 0x20903C64;
+    MidiEventInner event{now, 1, &word};
+    ASSERT_EQ(serverRing->TryWriteEvent(event, true), MidiStatusCode::OK);
+    ASSERT_TRUE(periodCapture.WaitForEvents(std::chrono::milliseconds(1000)));
+    ASSERT_EQ(periodCapture.events_.size(), 1u);
+    EXPECT_EQ(periodCapture.events_[0].event.timestamp, now);
+    EXPECT_EQ(periodCapture.periodFramePosition_ % 480, 0u);
+    EXPECT_GT(periodCapture.periodFramePosition_, 48000u);
+    EXPECT_LT(periodCapture.events_[0].frameOffset, 480u);
+    EXPECT_EQ(device->CloseInputPort(portIndex), OH_MIDI_STATUS_OK);
+}
+
 /**
  * @tc.name: MidiInputPort_StartStop_001
  * @tc.desc: StartReceiverThread should fail if ringBuffer or callback is nullptr; Stop should be idempotent.
@@ -639,6 +974,39 @@ HWTEST_F(MidiClientUnitTest, MidiInputPort_ReceiverDispatch_001, TestSize.Level0
     EXPECT_TRUE(inputPort.StopReceiverThread());
 }
 
+/**
+ * @tc.name: MidiInputPort_BroadcastDispatch_001
+ * @tc.desc: A port reading a broadcast ring only delivers events published after it started.
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiClientUnitTest, MidiInputPort_BroadcastDispatch_001, TestSize.Level0)
+{
+    CallbackCapture callbackCapture;
+
+    MidiInputPort inputPort(MidiReceivedTrampoline, &callbackCapture, MIDI_PROTOCOL_2_0);
+    std::shared_ptr<MidiBroadcastRing> localRing = MidiBroadcastRing::CreateFromLocal(16);
+    ASSERT_NE(localRing, nullptr);
+
+    std::vector<uint32_t> earlyWords{0x20903C64};
+    MidiEventInner earlyEvent = MakeMidiEventInner(5, earlyWords);
+    ASSERT_EQ(localRing->Publish(&earlyEvent, 1), 1u);
+
+    inputPort.GetBroadcastRing() = localRing;
+    ASSERT_TRUE(inputPort.StartReceiverThread());
+
+    std::vector<uint32_t> payloadWords{0x40903C00, 0x80000000};
+    MidiEventInner midiEventInner = MakeMidiEventInner(20, payloadWords);
+    ASSERT_EQ(localRing->Publish(&midiEventInner, 1), 1u);
+
+    ASSERT_TRUE(callbackCapture.WaitForAtLeast(1, std::chrono::milliseconds(200)));
+    auto lastEvents = callbackCapture.GetLastEvents();
+    ASSERT_EQ(lastEvents.size(), 1u);
+    EXPECT_EQ(lastEvents[0].timestamp, 20u);
+    EXPECT_EQ(lastEvents[0].length, payloadWords.size());
+
+    EXPECT_TRUE(inputPort.StopReceiverThread());
+}
+
 /**
  * @tc.name: MidiInputPort_StartReceiverThread_002
  * @tc.desc: StartReceiverThread should fail if called twice (already start branch).
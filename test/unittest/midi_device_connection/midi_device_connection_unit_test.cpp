@@ -15,8 +15,11 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -27,6 +30,8 @@
 #include "gtest/gtest.h"
 
 #include "midi_device_connection.h"
+#include "midi_input_dispatcher.h"
+#include "midi_output_submitter.h"
 #include "midi_shared_ring.h"
 #include "native_midi_base.h"
 
@@ -58,6 +63,170 @@ static bool IsFdValid(int fd)
     return (flags != -1);
 }
 
+static uint64_t SteadyNowNs()
+{
+    return static_cast<uint64_t>(
+        duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+// Records every event handed to the driver, optionally reports a scheduling capability.
+class RecordingMidiDeviceDriver : public MidiDeviceDriver {
+public:
+    struct RecordedEvent {
+        uint64_t timestamp = 0;
+        uint64_t receivedNs = 0;
+        const uint32_t *dataPtr = nullptr;
+        std::vector<uint32_t> data;
+    };
+
+    std::vector<DeviceInformation> GetRegisteredDevices() override { return {}; }
+    int32_t OpenDevice(int64_t deviceId) override { return OH_MIDI_STATUS_OK; }
+    int32_t OpenDevice(std::string deviceAddr, BleDriverCallback deviceCallback) override
+    {
+        return OH_MIDI_STATUS_OK;
+    }
+    int32_t CloseDevice(int64_t deviceId) override { return OH_MIDI_STATUS_OK; }
+    int32_t OpenInputPort(int64_t deviceId, uint32_t portIndex, UmpInputCallback cb) override
+    {
+        return OH_MIDI_STATUS_OK;
+    }
+    int32_t OpenOutputPort(int64_t deviceId, uint32_t portIndex) override { return OH_MIDI_STATUS_OK; }
+    int32_t CloseInputPort(int64_t deviceId, uint32_t portIndex) override { return OH_MIDI_STATUS_OK; }
+    int32_t CloseOutputPort(int64_t deviceId, uint32_t portIndex) override { return OH_MIDI_STATUS_OK; }
+
+    int32_t HandleUmpInput(int64_t deviceId, uint32_t portIndex, std::vector<MidiEventInner> &list) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        submitCount_++;
+        for (const auto &event : list) {
+            RecordedEvent recorded;
+            recorded.timestamp = event.timestamp;
+            recorded.receivedNs = SteadyNowNs();
+            recorded.dataPtr = event.data;
+            recorded.data.assign(event.data, event.data + event.length);
+            events_.push_back(std::move(recorded));
+        }
+        return OH_MIDI_STATUS_OK;
+    }
+
+    MidiDriverCapability GetOutputCapability(int64_t deviceId, uint32_t portIndex) override
+    {
+        return capability_;
+    }
+
+    std::vector<RecordedEvent> GetEvents()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return events_;
+    }
+
+    size_t GetSubmitCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return submitCount_;
+    }
+
+    MidiDriverCapability capability_;
+
+private:
+    std::mutex mutex_;
+    std::vector<RecordedEvent> events_;
+    size_t submitCount_ = 0;
+};
+
+// Accepts output at once and completes it completionDelay later, like a driver with its own transfer queue.
+class AsyncRecordingMidiDeviceDriver : public RecordingMidiDeviceDriver {
+public:
+    explicit AsyncRecordingMidiDeviceDriver(milliseconds completionDelay) : completionDelay_(completionDelay)
+    {
+        capability_.asyncOutputDepth = MIDI_DEFAULT_ASYNC_OUTPUT_DEPTH;
+        completer_ = std::thread([this]() { CompleterMain(); });
+    }
+
+    ~AsyncRecordingMidiDeviceDriver() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(completerMutex_);
+            stopping_ = true;
+        }
+        completerCv_.notify_all();
+        completer_.join();
+    }
+
+    int32_t SubmitUmpOutput(int64_t deviceId, uint32_t portIndex, std::vector<MidiEventInner> &list,
+        UmpOutputDoneCallback done) override
+    {
+        (void)HandleUmpInput(deviceId, portIndex, list);
+        {
+            std::lock_guard<std::mutex> lock(completerMutex_);
+            pending_.emplace_back(steady_clock::now() + completionDelay_, std::move(done));
+        }
+        completerCv_.notify_all();
+        return OH_MIDI_STATUS_OK;
+    }
+
+private:
+    void CompleterMain()
+    {
+        std::unique_lock<std::mutex> lock(completerMutex_);
+        while (true) {
+            completerCv_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                return;
+            }
+            const auto deadline = pending_.front().first;
+            completerCv_.wait_until(lock, deadline, [this]() { return stopping_; });
+            auto done = std::move(pending_.front().second);
+            pending_.pop_front();
+            lock.unlock();
+            done(OH_MIDI_STATUS_OK);
+            lock.lock();
+        }
+    }
+
+    milliseconds completionDelay_;
+    std::mutex completerMutex_;
+    std::condition_variable completerCv_;
+    std::deque<std::pair<steady_clock::time_point, UmpOutputDoneCallback>> pending_;
+    bool stopping_ = false;
+    std::thread completer_;
+};
+
+// Accepts output and keeps the completions until the test runs them, like a driver that stopped responding.
+class HoldingMidiDeviceDriver : public RecordingMidiDeviceDriver {
+public:
+    int32_t SubmitUmpOutput(int64_t deviceId, uint32_t portIndex, std::vector<MidiEventInner> &list,
+        UmpOutputDoneCallback done) override
+    {
+        (void)HandleUmpInput(deviceId, portIndex, list);
+        std::lock_guard<std::mutex> lock(heldMutex_);
+        held_.push_back(std::move(done));
+        return OH_MIDI_STATUS_OK;
+    }
+
+    size_t GetHeldCount()
+    {
+        std::lock_guard<std::mutex> lock(heldMutex_);
+        return held_.size();
+    }
+
+    void CompleteHeld(int32_t result)
+    {
+        std::vector<UmpOutputDoneCallback> held;
+        {
+            std::lock_guard<std::mutex> lock(heldMutex_);
+            held.swap(held_);
+        }
+        for (auto &done : held) {
+            done(result);
+        }
+    }
+
+private:
+    std::mutex heldMutex_;
+    std::vector<UmpOutputDoneCallback> held_;
+};
+
 //==================== UniqueFd ====================//
 
 /**
@@ -230,6 +399,215 @@ HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForInput_001, TestSize.Le
     EXPECT_EQ(payloadWords3.size(), static_cast<size_t>(peekedEventAfterRemove.length));
 }
 
+/**
+ * @tc.name   : Test DeviceConnectionForInput batch broadcast
+ * @tc.number : DeviceConnectionForInput_002
+ * @tc.desc   : A full USB packet of events reaches every client ring complete and in order.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForInput_002, TestSize.Level1)
+{
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.deviceId = 2;
+    deviceConnectionInfo.direction = MidiPortDirection::INPUT;
+    deviceConnectionInfo.portIndex = 0;
+    DeviceConnectionForInput inputConnection(deviceConnectionInfo);
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer1;
+    std::shared_ptr<MidiSharedRing> clientRingBuffer2;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, inputConnection.AddClientConnection(1, 1000, clientRingBuffer1));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, inputConnection.AddClientConnection(2, 1001, clientRingBuffer2));
+
+    constexpr uint32_t eventCount = 64;
+    std::vector<uint32_t> payloadWords(eventCount);
+    std::vector<MidiEventInner> deviceEvents;
+    for (uint32_t i = 0; i < eventCount; ++i) {
+        payloadWords[i] = 0x20903C00u | i;
+    }
+    for (uint32_t i = 0; i < eventCount; ++i) {
+        deviceEvents.push_back({i + 1, 1, &payloadWords[i]});
+    }
+    inputConnection.HandleDeviceUmpInput(deviceEvents);
+
+    for (auto *ringPointer : {clientRingBuffer1.get(), clientRingBuffer2.get()}) {
+        std::vector<MidiEvent> events;
+        std::vector<std::vector<uint32_t>> payloads;
+        ringPointer->DrainToBatch(events, payloads, 0);
+        ASSERT_EQ(eventCount, events.size());
+        for (uint32_t i = 0; i < eventCount; ++i) {
+            EXPECT_EQ(i + 1, events[i].timestamp);
+            EXPECT_EQ(payloadWords[i], events[i].data[0]);
+        }
+    }
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForInput input filter
+ * @tc.number : DeviceConnectionForInput_003
+ * @tc.desc   : A filtered client only gets the events its filter lets through, other clients get all of them.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForInput_003, TestSize.Level1)
+{
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.deviceId = 2;
+    deviceConnectionInfo.direction = MidiPortDirection::INPUT;
+    deviceConnectionInfo.portIndex = 0;
+    DeviceConnectionForInput inputConnection(deviceConnectionInfo);
+
+    MidiInputFilter filter;
+    filter.dropRealtime = true;
+    filter.droppedChannels = 1u << 9;         // drums
+    filter.droppedChannelStatus = 1u << 0xB;  // control change
+    filter.droppedGroups = 1u << 1;
+    std::shared_ptr<MidiSharedRing> filteredRing;
+    std::shared_ptr<MidiSharedRing> plainRing;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, inputConnection.AddFilteredClient(1, 1000, filteredRing, filter));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, inputConnection.AddClientConnection(2, 1001, plainRing));
+
+    std::vector<uint32_t> payloadWords{
+        0x10F80000, // timing clock
+        0x20903C64, // note on, channel 0
+        0x10FE0000, // active sensing
+        0x20993C64, // note on, channel 9
+        0x20B00740, // control change
+        0x21903C64, // note on, group 1
+        0x10F20000, // song position
+        0x20803C00, // note off, channel 0
+    };
+    std::vector<MidiEventInner> deviceEvents;
+    for (uint32_t i = 0; i < payloadWords.size(); ++i) {
+        deviceEvents.push_back({i + 1, 1, &payloadWords[i]});
+    }
+    inputConnection.HandleDeviceUmpInput(deviceEvents);
+
+    std::vector<MidiEvent> events;
+    std::vector<std::vector<uint32_t>> payloads;
+    filteredRing->DrainToBatch(events, payloads, 0);
+    ASSERT_EQ(3u, events.size());
+    EXPECT_EQ(0x20903C64u, events[0].data[0]);
+    EXPECT_EQ(0x10F20000u, events[1].data[0]);
+    EXPECT_EQ(0x20803C00u, events[2].data[0]);
+
+    events.clear();
+    payloads.clear();
+    plainRing->DrainToBatch(events, payloads, 0);
+    EXPECT_EQ(payloadWords.size(), events.size());
+
+    // every event dropped: no write and no wakeup for the filtered client
+    filter = MidiInputFilter();
+    filter.droppedMessageTypes = 0xFFFF;
+    std::shared_ptr<MidiSharedRing> mutedRing;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, inputConnection.AddFilteredClient(3, 1002, mutedRing, filter));
+    inputConnection.HandleDeviceUmpInput(deviceEvents);
+    MidiSharedRing::PeekedEvent peekedEvent{};
+    EXPECT_EQ(MidiStatusCode::WOULD_BLOCK, mutedRing->PeekNext(peekedEvent));
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForInput client churn
+ * @tc.number : DeviceConnectionForInput_004
+ * @tc.desc   : Clients opening and closing the port on another thread do not disturb delivery to a steady client.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForInput_004, TestSize.Level1)
+{
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.deviceId = 2;
+    deviceConnectionInfo.direction = MidiPortDirection::INPUT;
+    deviceConnectionInfo.portIndex = 0;
+    DeviceConnectionForInput inputConnection(deviceConnectionInfo);
+
+    std::shared_ptr<MidiSharedRing> steadyRing;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, inputConnection.AddClientConnection(1, 1000, steadyRing));
+
+    std::atomic<bool> stop{false};
+    std::thread churn([&inputConnection, &stop]() {
+        while (!stop.load()) {
+            std::shared_ptr<MidiSharedRing> ring;
+            (void)inputConnection.AddClientConnection(2, 1001, ring);
+            inputConnection.RemoveClientConnection(2);
+        }
+    });
+
+    constexpr uint32_t batchCount = 500;
+    uint32_t payloadWord = 0x20903C64;
+    std::vector<MidiEventInner> deviceEvents{{0, 1, &payloadWord}};
+    size_t received = 0;
+    for (uint32_t i = 0; i < batchCount; ++i) {
+        deviceEvents[0].timestamp = i + 1;
+        inputConnection.HandleDeviceUmpInput(deviceEvents);
+        std::vector<MidiEvent> events;
+        std::vector<std::vector<uint32_t>> payloads;
+        steadyRing->DrainToBatch(events, payloads, 0);
+        received += events.size();
+    }
+    stop.store(true);
+    churn.join();
+
+    EXPECT_EQ(batchCount, received);
+    EXPECT_TRUE(inputConnection.HasClientConnection(1));
+    EXPECT_FALSE(inputConnection.HasClientConnection(2));
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForInput dispatch thread
+ * @tc.number : DeviceConnectionForInput_005
+ * @tc.desc   : Batches posted from several driver threads reach the client through the dispatch thread,
+ *              the posting thread may reuse its buffers at once.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForInput_005, TestSize.Level1)
+{
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.deviceId = 2;
+    deviceConnectionInfo.direction = MidiPortDirection::INPUT;
+    deviceConnectionInfo.portIndex = 0;
+    auto inputConnection = std::make_shared<DeviceConnectionForInput>(deviceConnectionInfo);
+    std::shared_ptr<MidiSharedRing> clientRing;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, inputConnection->AddClientConnection(1, 1000, clientRing));
+
+    MidiInputDispatcher dispatcher(1024);
+    uint32_t payloadWord = 0x20903C64;
+    std::vector<MidiEventInner> deviceEvents{{1, 1, &payloadWord}};
+    EXPECT_FALSE(dispatcher.Post(inputConnection, deviceEvents));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, dispatcher.Start(0));
+
+    constexpr uint32_t producerCount = 2;
+    constexpr uint32_t batchCount = 40; // all fit in the client ring at once
+    std::vector<std::thread> producers;
+    std::weak_ptr<DeviceConnectionForInput> target = inputConnection;
+    for (uint32_t p = 0; p < producerCount; ++p) {
+        producers.emplace_back([&dispatcher, target]() {
+            for (uint32_t i = 0; i < batchCount; ++i) {
+                uint32_t word = 0x20903C00 | (i & 0x7F);
+                std::vector<MidiEventInner> events{{i + 1, 1, &word}};
+                (void)dispatcher.Post(target, events);
+                word = 0;
+            }
+        });
+    }
+
+    size_t received = 0;
+    bool payloadsIntact = true;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (received < producerCount * batchCount && std::chrono::steady_clock::now() < deadline) {
+        std::vector<MidiEvent> events;
+        std::vector<std::vector<uint32_t>> payloads;
+        clientRing->DrainToBatch(events, payloads, 0);
+        for (const auto &event : events) {
+            payloadsIntact = payloadsIntact && event.length == 1 && (event.data[0] & 0xFFFFFF00) == 0x20903C00;
+        }
+        received += events.size();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    dispatcher.Stop();
+
+    EXPECT_EQ(producerCount * batchCount, received);
+    EXPECT_TRUE(payloadsIntact);
+    EXPECT_EQ(0u, dispatcher.GetDroppedCount());
+    EXPECT_FALSE(dispatcher.Post(inputConnection, deviceEvents));
+}
+
 //==================== DeviceConnectionForOutput ====================//
 
 /**
@@ -357,8 +735,9 @@ HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_003, TestSize.L
  */
 HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_004, TestSize.Level1)
 {
+    RecordingMidiDeviceDriver driver;
     DeviceConnectionInfo deviceConnectionInfo{};
-    deviceConnectionInfo.driver = nullptr;
+    deviceConnectionInfo.driver = &driver;
     deviceConnectionInfo.deviceId = 4;
     deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
     deviceConnectionInfo.portIndex = 0;
@@ -391,8 +770,6 @@ HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_004, TestSize.L
     ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(realtimeLargePayload, true));
     ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(nonRealtimeEvent, true));
 
-    EXPECT_EQ(clientRingBuffer->IsEmpty(), false);
-
     // Wake worker via notify eventfd
     const int notifyEventFileDescriptor = outputConnection.GetNotifyEventFdForClients();
     ASSERT_GE(notifyEventFileDescriptor, 0);
@@ -400,9 +777,1092 @@ HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_004, TestSize.L
     const uint64_t one = 1;
     ASSERT_EQ(sizeof(one), static_cast<size_t>(::write(notifyEventFileDescriptor, &one, sizeof(one))));
 
+    // the worker may take the events as soon as they are written, wait until the driver has them;
+    // the empty realtime event carries nothing to send
+    for (int i = 0; i < 100 && driver.GetEvents().size() < 2; i++) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(2u, recorded.size());
+    EXPECT_EQ(realtimeLargePayloadWords, recorded[0].data);
+    EXPECT_EQ(nonRealtimePayloadWords, recorded[1].data);
+
+    // an event due later is still held by the port when the client flushes, it is never sent
+    const uint64_t laterNs = SteadyNowNs() + duration_cast<nanoseconds>(milliseconds(20)).count();
+    MidiEventInner laterEvent = MakeMidiEventInner(laterNs, nonRealtimePayloadWords);
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(laterEvent, true));
     outputConnection.FlushClientCache(clientId);
     EXPECT_EQ(clientRingBuffer->GetReadPosition(), 0);
     EXPECT_EQ(clientRingBuffer->GetWritePosition(), 0);
+    std::this_thread::sleep_for(milliseconds(40));
+    EXPECT_EQ(2u, driver.GetEvents().size());
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Lookahead
+ * @tc.number : DeviceConnectionForOutput_005
+ * @tc.desc   : Driver with scheduling capability should receive future events early, in one batch, timestamps kept.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_005, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+    driver.capability_.supportsScheduledOutput = true;
+    driver.capability_.lookaheadNs = duration_cast<nanoseconds>(seconds(1)).count();
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 6;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(10, 1234, clientRingBuffer));
+    ASSERT_NE(nullptr, clientRingBuffer);
+
+    const uint64_t baseNs = SteadyNowNs() + duration_cast<nanoseconds>(milliseconds(200)).count();
+    std::vector<uint32_t> payloadWords1{0x20903C7F};
+    std::vector<uint32_t> payloadWords2{0x20803C00};
+    const uint64_t timestamp2 = baseNs + duration_cast<nanoseconds>(milliseconds(100)).count();
+    std::vector<MidiEventInner> events{MakeMidiEventInner(baseNs, payloadWords1),
+        MakeMidiEventInner(timestamp2, payloadWords2)};
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvents(events.data(), events.size(), &written, true));
+    ASSERT_EQ(2u, written);
+
+    std::this_thread::sleep_for(milliseconds(50));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(2u, recorded.size());
+    EXPECT_EQ(1u, driver.GetSubmitCount());
+    EXPECT_EQ(baseNs, recorded[0].timestamp);
+    EXPECT_EQ(payloadWords1, recorded[0].data);
+    EXPECT_EQ(timestamp2, recorded[1].timestamp);
+    EXPECT_EQ(payloadWords2, recorded[1].data);
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Without Lookahead
+ * @tc.number : DeviceConnectionForOutput_006
+ * @tc.desc   : Driver without scheduling capability should only receive an event once it is due.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_006, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 7;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(10, 1234, clientRingBuffer));
+    ASSERT_NE(nullptr, clientRingBuffer);
+
+    const uint64_t dueNs = SteadyNowNs() + duration_cast<nanoseconds>(milliseconds(100)).count();
+    std::vector<uint32_t> payloadWords{0x20903C7F};
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(dueNs, payloadWords), true));
+
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_TRUE(driver.GetEvents().empty());
+
+    std::this_thread::sleep_for(milliseconds(200));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(1u, recorded.size());
+    EXPECT_EQ(dueNs, recorded[0].timestamp);
+    EXPECT_GE(SteadyNowNs(), dueNs);
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Precision Mode
+ * @tc.number : DeviceConnectionForOutput_007
+ * @tc.desc   : In precision mode events are never sent early and the adaptive margin stays within bounds.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_007, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 8;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    outputConnection.SetPrecisionMode(true);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(10, 1234, clientRingBuffer));
+    ASSERT_NE(nullptr, clientRingBuffer);
+
+    const uint64_t stepNs = duration_cast<nanoseconds>(milliseconds(5)).count();
+    const uint64_t firstDueNs = SteadyNowNs() + duration_cast<nanoseconds>(milliseconds(20)).count();
+    std::vector<uint32_t> payloadWords{0x20903C7F};
+    const uint32_t eventCount = 4;
+    for (uint32_t i = 0; i < eventCount; i++) {
+        ASSERT_EQ(MidiStatusCode::OK,
+            clientRingBuffer->TryWriteEvent(MakeMidiEventInner(firstDueNs + i * stepNs, payloadWords), true));
+    }
+
+    std::this_thread::sleep_for(milliseconds(100));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(eventCount, recorded.size());
+    for (const auto &event : recorded) {
+        EXPECT_GE(event.receivedNs, event.timestamp);
+    }
+    EXPECT_GE(outputConnection.precisionMargin_, DeviceConnectionForOutput::kPrecisionMarginMin);
+    EXPECT_LE(outputConnection.precisionMargin_, DeviceConnectionForOutput::kPrecisionMarginMax);
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Scheduling Slack
+ * @tc.number : DeviceConnectionForOutput_008
+ * @tc.desc   : Events due within the slack window of one wakeup should reach the driver in a single submission,
+ *              none of them before it is due, while a lone event is not delayed. Precision mode ignores the slack.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_008, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 9;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    outputConnection.SetSchedulingSlack(duration_cast<nanoseconds>(milliseconds(50)).count());
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(10, 1234, clientRingBuffer));
+    ASSERT_NE(nullptr, clientRingBuffer);
+
+    const uint64_t stepNs = duration_cast<nanoseconds>(milliseconds(10)).count();
+    const uint64_t firstDueNs = SteadyNowNs() + duration_cast<nanoseconds>(milliseconds(100)).count();
+    std::vector<uint32_t> payloadWords{0x20903C7F};
+    std::vector<MidiEventInner> events;
+    const uint32_t eventCount = 3;
+    for (uint32_t i = 0; i < eventCount; i++) {
+        events.push_back(MakeMidiEventInner(firstDueNs + i * stepNs, payloadWords));
+    }
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvents(events.data(), events.size(), &written, true));
+    ASSERT_EQ(eventCount, written);
+
+    std::this_thread::sleep_for(milliseconds(200));
+
+    // nothing else is due within the window of a lone event, it is not held back for the slack
+    const uint64_t loneDueNs = SteadyNowNs() + duration_cast<nanoseconds>(milliseconds(20)).count();
+    ASSERT_EQ(MidiStatusCode::OK,
+        clientRingBuffer->TryWriteEvent(MakeMidiEventInner(loneDueNs, payloadWords), true));
+    std::this_thread::sleep_for(milliseconds(100));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(eventCount + 1, recorded.size());
+    EXPECT_EQ(2u, driver.GetSubmitCount());
+    for (uint32_t i = 0; i < eventCount; i++) {
+        EXPECT_EQ(firstDueNs + i * stepNs, recorded[i].timestamp);
+        EXPECT_GE(recorded[i].receivedNs, recorded[i].timestamp);
+    }
+    EXPECT_EQ(loneDueNs, recorded[eventCount].timestamp);
+    EXPECT_GE(recorded[eventCount].receivedNs, loneDueNs);
+    EXPECT_LT(recorded[eventCount].receivedNs, loneDueNs + duration_cast<nanoseconds>(milliseconds(25)).count());
+
+    outputConnection.SetPrecisionMode(true);
+    EXPECT_EQ(0u, outputConnection.GetSchedulingSlackNs());
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Realtime Lane
+ * @tc.number : DeviceConnectionForOutput_009
+ * @tc.desc   : Immediate events should overtake scheduled events blocked by a full pending heap.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_009, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 10;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    outputConnection.SetPerClientMaxPendingEvents(1);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(10, 1234, clientRingBuffer));
+    ASSERT_NE(nullptr, clientRingBuffer);
+
+    // two far future events: the second one cannot enter the pending heap
+    const uint64_t futureNs = SteadyNowNs() + duration_cast<nanoseconds>(seconds(10)).count();
+    std::vector<uint32_t> scheduledWords{0x20903C7F};
+    std::vector<uint32_t> realtimeWords{0x20B00740};
+    std::vector<MidiEventInner> events{MakeMidiEventInner(futureNs, scheduledWords),
+        MakeMidiEventInner(futureNs, scheduledWords), MakeMidiEventInner(0, realtimeWords)};
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvents(events.data(), events.size(), &written, true));
+    ASSERT_EQ(3u, written);
+
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(1u, recorded.size());
+    EXPECT_EQ(0u, recorded[0].timestamp);
+    EXPECT_EQ(realtimeWords, recorded[0].data);
+
+    // the blocked scheduled event is still at the head of the ring
+    MidiSharedRing::PeekedEvent head{};
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->PeekNext(head));
+    EXPECT_EQ(futureNs, head.timestamp);
+    clientRingBuffer->CommitRead(head);
+    // the realtime event behind it was already consumed and is skipped
+    EXPECT_EQ(MidiStatusCode::WOULD_BLOCK, clientRingBuffer->PeekNext(head));
+    EXPECT_TRUE(clientRingBuffer->IsEmpty());
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Fair Draining
+ * @tc.number : DeviceConnectionForOutput_010
+ * @tc.desc   : A client with a deep ring should not delay another client's event beyond one event budget.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_010, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 11;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    const size_t eventBudget = 4;
+    outputConnection.SetPerWakeupEventBudget(eventBudget);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> busyRing;
+    std::shared_ptr<MidiSharedRing> quietRing;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, busyRing));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(2, 1001, quietRing));
+
+    std::vector<uint32_t> busyWords{0x20903C7F};
+    std::vector<uint32_t> quietWords{0x20B00740};
+    const uint32_t busyCount = 40;
+    for (uint32_t i = 0; i < busyCount; i++) {
+        ASSERT_EQ(MidiStatusCode::OK, busyRing->TryWriteEvent(MakeMidiEventInner(0, busyWords), false));
+    }
+    ASSERT_EQ(MidiStatusCode::OK, quietRing->TryWriteEvent(MakeMidiEventInner(0, quietWords), true));
+
+    std::this_thread::sleep_for(milliseconds(50));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(busyCount + 1, recorded.size());
+    size_t quietIndex = recorded.size();
+    for (size_t i = 0; i < recorded.size(); i++) {
+        if (recorded[i].data == quietWords) {
+            quietIndex = i;
+        }
+    }
+    EXPECT_LE(quietIndex, eventBudget);
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Weighted Draining
+ * @tc.number : DeviceConnectionForOutput_010_1
+ * @tc.desc   : A client with weight 2 drains twice the event budget in a round.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_010_1, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 11;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    const size_t eventBudget = 4;
+    outputConnection.SetPerWakeupEventBudget(eventBudget);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> heavyRing;
+    std::shared_ptr<MidiSharedRing> lightRing;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, heavyRing));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(2, 1001, lightRing));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.SetClientWeight(1, 2));
+    EXPECT_EQ(OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, outputConnection.SetClientWeight(3, 2));
+
+    std::vector<uint32_t> heavyWords{0x20903C7F};
+    std::vector<uint32_t> lightWords{0x20B00740};
+    const uint32_t eventCount = 8;
+    for (uint32_t i = 0; i < eventCount; i++) {
+        const bool last = (i + 1 == eventCount);
+        ASSERT_EQ(MidiStatusCode::OK, heavyRing->TryWriteEvent(MakeMidiEventInner(0, heavyWords), false));
+        ASSERT_EQ(MidiStatusCode::OK, lightRing->TryWriteEvent(MakeMidiEventInner(0, lightWords), last));
+    }
+
+    std::this_thread::sleep_for(milliseconds(50));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(eventCount * 2, recorded.size());
+    // the first round sends 2 * budget heavy events and budget light ones
+    size_t heavyInFirstRound = 0;
+    for (size_t i = 0; i < eventBudget * 3; i++) {
+        heavyInFirstRound += (recorded[i].data == heavyWords) ? 1 : 0;
+    }
+    EXPECT_EQ(eventBudget * 2, heavyInFirstRound);
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Client Rate Limit
+ * @tc.number : DeviceConnectionForOutput_011
+ * @tc.desc   : A client over its bytes-per-second cap is throttled and resumed by the timer.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_011, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 12;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    // 400 bytes/s: a burst of 40 bytes (10 one-word events), then one event every 10ms
+    outputConnection.SetPerClientMaxBytesPerSecond(400);
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+
+    std::vector<uint32_t> payloadWords{0x20903C7F};
+    const uint32_t eventCount = 20;
+    for (uint32_t i = 0; i < eventCount; i++) {
+        ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, payloadWords), true));
+    }
+
+    std::this_thread::sleep_for(milliseconds(30));
+    const size_t earlyCount = driver.GetEvents().size();
+    EXPECT_GE(earlyCount, 10u);
+    EXPECT_LT(earlyCount, eventCount);
+
+    std::this_thread::sleep_for(milliseconds(200));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+    EXPECT_EQ(eventCount, driver.GetEvents().size());
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Direct Send
+ * @tc.number : DeviceConnectionForOutput_012
+ * @tc.desc   : Events larger than the send cache go to the driver straight from the client ring, in order;
+ *              the cache is shrunk here, default client rings never hold an event that large.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_012, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 13;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    outputConnection.SetMaxSendCacheBytes(8);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+
+    std::vector<uint32_t> smallWords{0x20903C7F};
+    std::vector<uint32_t> largeWords{0x30160102, 0x03040506, 0x30260708, 0x090A0B0C, 0x30330D0E, 0x0F000000};
+    std::vector<MidiEventInner> events{MakeMidiEventInner(0, smallWords), MakeMidiEventInner(0, largeWords)};
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvents(events.data(), events.size(), &written, true));
+
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(2u, recorded.size());
+    EXPECT_EQ(smallWords, recorded[0].data);
+    EXPECT_EQ(largeWords, recorded[1].data);
+
+    // the large payload was not copied, the driver saw the ring memory
+    const uint8_t *ringBegin = clientRingBuffer->GetDataBase();
+    const uint8_t *ringEnd = ringBegin + clientRingBuffer->GetCapacity();
+    const uint8_t *largeData = reinterpret_cast<const uint8_t *>(recorded[1].dataPtr);
+    EXPECT_TRUE(largeData >= ringBegin && largeData < ringEnd);
+    EXPECT_TRUE(clientRingBuffer->IsEmpty());
+}
+
+//==================== MidiCoalesceIndex ====================//
+
+/**
+ * @tc.name   : Test MidiCoalesceIndex GetKey
+ * @tc.number : MidiCoalesceIndexGetKey_001
+ * @tc.desc   : Only value-type channel messages get a key, order sensitive controllers do not.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, MidiCoalesceIndexGetKey_001, TestSize.Level1)
+{
+    const uint32_t volumeCh0 = 0x20B00740;
+    const uint32_t volumeCh1 = 0x20B10740;
+    const uint32_t pitchBend = 0x20E00040;
+    const uint32_t noteOn = 0x20903C7F;
+    const uint32_t dataEntry = 0x20B00640;
+    const uint32_t allNotesOff = 0x20B07B00;
+    const uint32_t sustain = 0x20B0407F;
+    const uint32_t sysex[2] = {0x30160102, 0x03040506};
+    const uint32_t midi2Cc[2] = {0x40B00700, 0x80000000};
+
+    EXPECT_NE(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(&volumeCh0, 1));
+    EXPECT_NE(MidiCoalesceIndex::GetKey(&volumeCh0, 1), MidiCoalesceIndex::GetKey(&volumeCh1, 1));
+    EXPECT_NE(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(&pitchBend, 1));
+    EXPECT_NE(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(midi2Cc, 2));
+    EXPECT_EQ(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(&noteOn, 1));
+    EXPECT_EQ(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(&dataEntry, 1));
+    EXPECT_EQ(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(&allNotesOff, 1));
+    EXPECT_EQ(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(&sustain, 1));
+    EXPECT_EQ(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(sysex, 2));
+    EXPECT_EQ(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(midi2Cc, 1));
+    EXPECT_EQ(MidiCoalesceIndex::INVALID_KEY, MidiCoalesceIndex::GetKey(nullptr, 1));
+}
+
+/**
+ * @tc.name   : Test MidiCoalesceIndex Exchange
+ * @tc.number : MidiCoalesceIndexExchange_001
+ * @tc.desc   : Exchange returns the previous position of a key until Clear.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, MidiCoalesceIndexExchange_001, TestSize.Level1)
+{
+    MidiCoalesceIndex index;
+    uint32_t oldIndex = 0;
+    EXPECT_FALSE(index.Exchange(MidiCoalesceIndex::INVALID_KEY, 0, oldIndex));
+    EXPECT_FALSE(index.Exchange(100, 1, oldIndex));
+    EXPECT_FALSE(index.Exchange(200, 2, oldIndex));
+    ASSERT_TRUE(index.Exchange(100, 3, oldIndex));
+    EXPECT_EQ(1u, oldIndex);
+    ASSERT_TRUE(index.Exchange(100, 4, oldIndex));
+    EXPECT_EQ(3u, oldIndex);
+
+    index.Clear();
+    EXPECT_FALSE(index.Exchange(100, 5, oldIndex));
+
+    // a crowded table stops indexing instead of failing
+    for (uint32_t key = 0; key < 1024; key++) {
+        (void)index.Exchange(key, key, oldIndex);
+    }
+    EXPECT_TRUE(index.Exchange(1, 7, oldIndex));
+
+    // a note on channel 0 pins the volume before it, channel 1 and the values after the note still merge
+    index.Clear();
+    const uint32_t volumeCh0 = 0x20B00764;
+    const uint32_t volumeCh1 = 0x20B10764;
+    const uint32_t noteOnCh0 = 0x20903C7F;
+    const uint32_t sysex[2] = {0x30010000, 0x00000000};
+    EXPECT_FALSE(index.Exchange(&volumeCh0, 1, 0, oldIndex));
+    EXPECT_FALSE(index.Exchange(&volumeCh1, 1, 1, oldIndex));
+    EXPECT_FALSE(index.Exchange(&noteOnCh0, 1, 2, oldIndex));
+    EXPECT_FALSE(index.Exchange(&volumeCh0, 1, 3, oldIndex));
+    ASSERT_TRUE(index.Exchange(&volumeCh1, 1, 4, oldIndex));
+    EXPECT_EQ(1u, oldIndex);
+    ASSERT_TRUE(index.Exchange(&volumeCh0, 1, 5, oldIndex));
+    EXPECT_EQ(3u, oldIndex);
+    // SysEx on the group pins every channel
+    EXPECT_FALSE(index.Exchange(sysex, 2, 6, oldIndex));
+    EXPECT_FALSE(index.Exchange(&volumeCh1, 1, 7, oldIndex));
+    EXPECT_FALSE(index.Exchange(&volumeCh0, 1, 8, oldIndex));
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Coalescing
+ * @tc.number : DeviceConnectionForOutput_013
+ * @tc.desc   : Unsent controller values are replaced by newer ones, but never across a note on the same channel,
+ *               switch controllers, data entry and values behind a barrier are all kept in order.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_013, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 14;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    outputConnection.SetCoalescing(true, duration_cast<nanoseconds>(milliseconds(10)).count());
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+
+    // volume twice, note on, volume, data entry twice, sustain on and off, volume on channel 1 twice
+    std::vector<std::vector<uint32_t>> words{{0x20B00701}, {0x20B00702}, {0x20903C7F}, {0x20B00703},
+        {0x20B00610}, {0x20B00620}, {0x20B0407F}, {0x20B04000}, {0x20B10701}, {0x20B10702}};
+    std::vector<MidiEventInner> events;
+    for (const auto &payload : words) {
+        events.push_back(MakeMidiEventInner(0, payload));
+    }
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvents(events.data(), events.size(), &written, true));
+
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    std::vector<std::vector<uint32_t>> expected{words[1], words[2], words[3], words[4], words[5], words[6],
+        words[7], words[9]};
+    ASSERT_EQ(expected.size(), recorded.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ(expected[i], recorded[i].data) << "index " << i;
+    }
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Wire Pacing
+ * @tc.number : DeviceConnectionForOutput_014
+ * @tc.desc   : Output is paced to the link rate the driver reports, the backlog is resumed by the timer.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_014, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+    // 300 bytes/s on a MIDI 1.0 link: a burst of 30 bytes (10 note-ons), then one note-on every 10ms
+    driver.capability_.wireBytesPerSecond = 300;
+    driver.capability_.wireBurstBytes = 30;
+    driver.capability_.wireFormat = MidiWireFormat::MIDI1_BYTE_STREAM;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 15;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+
+    std::vector<uint32_t> payloadWords{0x20903C7F};
+    const uint32_t eventCount = 20;
+    for (uint32_t i = 0; i < eventCount; i++) {
+        ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, payloadWords), true));
+    }
+
+    std::this_thread::sleep_for(milliseconds(30));
+    const size_t earlyCount = driver.GetEvents().size();
+    EXPECT_GE(earlyCount, 10u);
+    EXPECT_LT(earlyCount, eventCount);
+
+    std::this_thread::sleep_for(milliseconds(200));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+    EXPECT_EQ(eventCount, driver.GetEvents().size());
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput MIDI 1.0 Wire Bytes
+ * @tc.number : DeviceConnectionForOutputWireBytes_001
+ * @tc.desc   : UMP packets are counted at their encoded MIDI 1.0 length.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutputWireBytes_001, TestSize.Level1)
+{
+    std::vector<uint32_t> noteOn{0x20903C7F};
+    std::vector<uint32_t> programChange{0x20C00500};
+    std::vector<uint32_t> clockAndSongPosition{0x10F80000, 0x10F20102};
+    std::vector<uint32_t> midi2NoteOn{0x40903C00, 0xFFFF0000};
+    std::vector<uint32_t> sysExStartEnd{0x30160102, 0x03040506, 0x30330D0E, 0x0F000000};
+    std::vector<uint32_t> utilityNoop{0x00000000};
+
+    EXPECT_EQ(3u, DeviceConnectionForOutput::GetMidi1WireBytes(noteOn.data(), noteOn.size()));
+    EXPECT_EQ(2u, DeviceConnectionForOutput::GetMidi1WireBytes(programChange.data(), programChange.size()));
+    EXPECT_EQ(4u, DeviceConnectionForOutput::GetMidi1WireBytes(clockAndSongPosition.data(),
+        clockAndSongPosition.size()));
+    EXPECT_EQ(3u, DeviceConnectionForOutput::GetMidi1WireBytes(midi2NoteOn.data(), midi2NoteOn.size()));
+    // F0 + 6 bytes, then 3 bytes + F7
+    EXPECT_EQ(11u, DeviceConnectionForOutput::GetMidi1WireBytes(sysExStartEnd.data(), sysExStartEnd.size()));
+    EXPECT_EQ(0u, DeviceConnectionForOutput::GetMidi1WireBytes(utilityNoop.data(), utilityNoop.size()));
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Cancel Tagged Events
+ * @tc.number : DeviceConnectionForOutput_015
+ * @tc.desc   : Cancelling a tag drops only that clip's scheduled events, the others are still sent on time.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_015, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 16;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+
+    std::vector<uint32_t> clipWords{0x20903C7F};
+    std::vector<uint32_t> trackWords{0x20913E7F};
+    const uint64_t dueNs = SteadyNowNs() + duration_cast<nanoseconds>(milliseconds(50)).count();
+    for (uint64_t i = 0; i < 4; i++) {
+        MidiEventInner clipEvent = MakeMidiEventInner(dueNs + i, clipWords);
+        clipEvent.tag = 1;
+        MidiEventInner trackEvent = MakeMidiEventInner(dueNs + i, trackWords);
+        trackEvent.tag = 2;
+        ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(clipEvent, true));
+        ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(trackEvent, true));
+    }
+
+    std::this_thread::sleep_for(milliseconds(10));
+    EXPECT_EQ(OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, outputConnection.CancelClientEvents(99, 1, 0, UINT64_MAX));
+    EXPECT_EQ(OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, outputConnection.CancelClientEvents(1, 1, 2, 1));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.CancelClientEvents(1, 1, 0, UINT64_MAX));
+
+    std::this_thread::sleep_for(milliseconds(100));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(4u, recorded.size());
+    for (const auto &event : recorded) {
+        EXPECT_EQ(trackWords, event.data);
+    }
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Timeline
+ * @tc.number : DeviceConnectionForOutput_016
+ * @tc.desc   : A looping timeline is played on time by the worker and goes quiet once stopped.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_016, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 17;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+    std::shared_ptr<MidiSharedTimeline> timeline;
+    EXPECT_NE(OH_MIDI_STATUS_OK, outputConnection.CreateClientTimeline(99, 1024, timeline));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.CreateClientTimeline(1, 1024, timeline));
+    ASSERT_NE(nullptr, timeline);
+    std::shared_ptr<MidiSharedTimeline> again;
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.CreateClientTimeline(1, 1024, again));
+    EXPECT_EQ(timeline, again);
+    EXPECT_NE(OH_MIDI_STATUS_OK, outputConnection.CreateClientTimeline(1, 2048, again));
+
+    const uint64_t stepNs = duration_cast<nanoseconds>(milliseconds(10)).count();
+    std::vector<uint32_t> noteWords{0x20903C7F};
+    std::vector<MidiEventInner> events;
+    for (uint64_t i = 0; i < 3; i++) {
+        events.push_back(MakeMidiEventInner(i * stepNs, noteWords));
+    }
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, timeline->Append(events.data(), events.size(), &written));
+    timeline->SetLoop(0, 3 * stepNs);
+    const uint64_t startNs = SteadyNowNs() + duration_cast<nanoseconds>(milliseconds(20)).count();
+    timeline->Start(startNs, 0);
+
+    std::this_thread::sleep_for(milliseconds(95));
+    timeline->Stop();
+    std::this_thread::sleep_for(milliseconds(30));
+    auto recorded = driver.GetEvents();
+    std::this_thread::sleep_for(milliseconds(30));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    // 0, 10, ..., 70 ms after start
+    ASSERT_GE(recorded.size(), 7u);
+    for (size_t i = 0; i < recorded.size(); i++) {
+        EXPECT_EQ(noteWords, recorded[i].data);
+        EXPECT_GE(recorded[i].receivedNs, startNs + i * stepNs);
+    }
+    EXPECT_EQ(recorded.size(), driver.GetEvents().size());
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Exclusive Direct Mode
+ * @tc.number : DeviceConnectionForOutput_017
+ * @tc.desc   : A sole exclusive client has its ring payloads handed to the driver in place and on time,
+ *              a second client switches the port back to shared mode.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_017, TestSize.Level1)
+{
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 18;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+    EXPECT_EQ(OH_MIDI_STATUS_GENERIC_INVALID_ARGUMENT, outputConnection.SetClientExclusive(99, true));
+    EXPECT_FALSE(outputConnection.IsDirectMode());
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.SetClientExclusive(1, true));
+    EXPECT_TRUE(outputConnection.IsDirectMode());
+
+    std::vector<uint32_t> noteWords{0x20903C7F};
+    const uint64_t dueNs = SteadyNowNs() + duration_cast<nanoseconds>(milliseconds(30)).count();
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, noteWords), true));
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(dueNs, noteWords), true));
+    std::this_thread::sleep_for(milliseconds(80));
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(2u, recorded.size());
+    const uint8_t *ringBegin = clientRingBuffer->GetDataBase();
+    const uint8_t *ringEnd = ringBegin + clientRingBuffer->GetCapacity();
+    for (const auto &event : recorded) {
+        EXPECT_EQ(noteWords, event.data);
+        const uint8_t *dataPtr = reinterpret_cast<const uint8_t *>(event.dataPtr);
+        EXPECT_TRUE(dataPtr >= ringBegin && dataPtr < ringEnd);
+    }
+    EXPECT_GE(recorded[1].receivedNs, dueNs);
+    EXPECT_TRUE(clientRingBuffer->IsEmpty());
+
+    std::shared_ptr<MidiSharedRing> otherRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(2, 1000, otherRingBuffer));
+    EXPECT_FALSE(outputConnection.IsDirectMode());
+    outputConnection.RemoveClientConnection(2);
+    EXPECT_TRUE(outputConnection.IsDirectMode());
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.SetClientExclusive(1, false));
+    EXPECT_FALSE(outputConnection.IsDirectMode());
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Async Submission
+ * @tc.number : DeviceConnectionForOutput_018
+ * @tc.desc   : With an async driver a scheduled event goes out on time while an earlier batch is in flight,
+ *              once the in-flight depth is reached the next one waits for a completion.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_018, TestSize.Level1)
+{
+    constexpr milliseconds completionDelay(60);
+    AsyncRecordingMidiDeviceDriver driver(completionDelay);
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 19;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+    ASSERT_TRUE(outputConnection.submitter_.IsRunning());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+
+    std::vector<uint32_t> noteWords{0x20903C7F};
+    const uint64_t startNs = SteadyNowNs();
+    const uint64_t firstDueNs = startNs + duration_cast<nanoseconds>(milliseconds(10)).count();
+    const uint64_t secondDueNs = startNs + duration_cast<nanoseconds>(milliseconds(20)).count();
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, noteWords), true));
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(firstDueNs, noteWords), true));
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(secondDueNs, noteWords), true));
+
+    std::this_thread::sleep_for(milliseconds(200));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(3u, recorded.size());
+    EXPECT_EQ(3u, driver.GetSubmitCount());
+    // the first batch is still in flight, the second one does not wait for it
+    EXPECT_GE(recorded[1].receivedNs, firstDueNs);
+    EXPECT_LT(recorded[1].receivedNs, recorded[0].receivedNs + duration_cast<nanoseconds>(completionDelay).count());
+    // both batches are busy, the third goes out when the first completes
+    EXPECT_GE(recorded[2].receivedNs, recorded[0].receivedNs + duration_cast<nanoseconds>(completionDelay).count());
+    EXPECT_EQ(0u, outputConnection.submitter_.GetFailedCount());
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Zero-Copy SysEx
+ * @tc.number : DeviceConnectionForOutput_021
+ * @tc.desc   : With the default send cache and an async driver, SysEx from a shared port is copied,
+ *              while an exclusive client has it handed to the driver in place from its ring.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_021, TestSize.Level1)
+{
+    AsyncRecordingMidiDeviceDriver driver(milliseconds(1));
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 22;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+    ASSERT_TRUE(outputConnection.submitter_.IsRunning());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+    const uint8_t *ringBegin = clientRingBuffer->GetDataBase();
+    const uint8_t *ringEnd = ringBegin + clientRingBuffer->GetCapacity();
+    std::vector<uint32_t> sysexWords{0x30160102, 0x03040506, 0x30260708, 0x090A0B0C, 0x30330D0E, 0x0F000000};
+
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, sysexWords), true));
+    std::this_thread::sleep_for(milliseconds(20));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.SetClientExclusive(1, true));
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, sysexWords), true));
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(2u, recorded.size());
+    for (const auto &event : recorded) {
+        EXPECT_EQ(sysexWords, event.data);
+    }
+    const uint8_t *sharedPtr = reinterpret_cast<const uint8_t *>(recorded[0].dataPtr);
+    const uint8_t *directPtr = reinterpret_cast<const uint8_t *>(recorded[1].dataPtr);
+    EXPECT_FALSE(sharedPtr >= ringBegin && sharedPtr < ringEnd);
+    EXPECT_TRUE(directPtr >= ringBegin && directPtr < ringEnd);
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Direct Batch In Flight
+ * @tc.number : DeviceConnectionForOutput_022
+ * @tc.desc   : While the driver holds a direct batch, flush and cancel return at once; the flush drops
+ *              what was written before it once the batch completes and keeps what is written after.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_022, TestSize.Level1)
+{
+    HoldingMidiDeviceDriver driver;
+    driver.capability_.asyncOutputDepth = MIDI_DEFAULT_ASYNC_OUTPUT_DEPTH;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 23;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.SetClientExclusive(1, true));
+
+    std::vector<uint32_t> sentWords{0x20903C7F};
+    std::vector<uint32_t> flushedWords{0x20803C00};
+    std::vector<uint32_t> keptWords{0x20904040};
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, sentWords), true));
+    std::this_thread::sleep_for(milliseconds(20));
+    ASSERT_EQ(1u, driver.GetHeldCount());
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, flushedWords), true));
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_EQ(1u, driver.GetEvents().size());
+
+    const auto callStart = steady_clock::now();
+    outputConnection.FlushClientCache(1);
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.CancelClientEvents(1, MIDI_EVENT_TAG_ANY, 1, UINT64_MAX));
+    EXPECT_LT(steady_clock::now() - callStart, milliseconds(20));
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, keptWords), true));
+
+    driver.CompleteHeld(OH_MIDI_STATUS_OK);
+    std::this_thread::sleep_for(milliseconds(20));
+    auto recorded = driver.GetEvents();
+    ASSERT_EQ(2u, recorded.size());
+    EXPECT_EQ(sentWords, recorded[0].data);
+    EXPECT_EQ(keptWords, recorded[1].data);
+    driver.CompleteHeld(OH_MIDI_STATUS_OK);
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_TRUE(clientRingBuffer->IsEmpty());
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+}
+
+/**
+ * @tc.name   : Test MidiOutputSubmitter Stop
+ * @tc.number : MidiOutputSubmitterStop_001
+ * @tc.desc   : A batch the driver completes after Stop() gave up waiting and the submitter is gone
+ *              is returned safely, onComplete is not called any more.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, MidiOutputSubmitterStop_001, TestSize.Level1)
+{
+    HoldingMidiDeviceDriver driver;
+    std::atomic<uint32_t> completions{0};
+    std::vector<uint32_t> noteWords{0x20903C7F};
+    {
+        MidiOutputSubmitter submitter;
+        ASSERT_EQ(OH_MIDI_STATUS_OK, submitter.Start(&driver, 1, 0, 1, [&completions]() { completions++; }));
+        MidiOutputSubmitter::Batch *batch = submitter.Acquire(false);
+        ASSERT_NE(nullptr, batch);
+        batch->payloads.push_back(noteWords);
+        batch->events.push_back(MidiEventInner{0, noteWords.size(), batch->payloads.back().data(), 0});
+        submitter.Submit(batch);
+        EXPECT_EQ(nullptr, submitter.Acquire(false));
+        submitter.Stop();
+        EXPECT_FALSE(submitter.IsRunning());
+    }
+    ASSERT_EQ(1u, driver.GetHeldCount());
+    driver.CompleteHeld(OH_MIDI_STATUS_OK);
+    EXPECT_EQ(0u, completions.load());
+    EXPECT_EQ(1u, driver.GetEvents().size());
+}
+
+/**
+ * @tc.name   : Test MidiOutputSubmitter Completion Wakeup
+ * @tc.number : MidiOutputSubmitterWake_001
+ * @tc.desc   : onComplete is called only for a completion the producer waits for, after Acquire(false)
+ *              found no free batch or IsIdle() returned false.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, MidiOutputSubmitterWake_001, TestSize.Level1)
+{
+    HoldingMidiDeviceDriver driver;
+    std::atomic<uint32_t> completions{0};
+    std::vector<uint32_t> noteWords{0x20903C7F};
+    MidiOutputSubmitter submitter;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, submitter.Start(&driver, 1, 0, 1, [&completions]() { completions++; }));
+    auto submitNote = [&submitter, &driver, &noteWords]() {
+        MidiOutputSubmitter::Batch *batch = submitter.Acquire(false);
+        ASSERT_NE(nullptr, batch);
+        batch->events.push_back(MidiEventInner{0, noteWords.size(), noteWords.data(), 0});
+        submitter.Submit(batch);
+        for (int i = 0; i < 100 && driver.GetHeldCount() == 0; i++) {
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+        ASSERT_EQ(1u, driver.GetHeldCount());
+    };
+
+    submitNote();
+    driver.CompleteHeld(OH_MIDI_STATUS_OK);
+    EXPECT_EQ(0u, completions.load());
+
+    submitNote();
+    EXPECT_EQ(nullptr, submitter.Acquire(false));
+    driver.CompleteHeld(OH_MIDI_STATUS_OK);
+    EXPECT_EQ(1u, completions.load());
+
+    submitNote();
+    EXPECT_FALSE(submitter.IsIdle());
+    driver.CompleteHeld(OH_MIDI_STATUS_OK);
+    EXPECT_EQ(2u, completions.load());
+    EXPECT_TRUE(submitter.IsIdle());
+    submitter.Stop();
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Worker Syscalls
+ * @tc.number : DeviceConnectionForOutput_019
+ * @tc.desc   : A wakeup that leaves the earliest deadline unchanged costs the worker its epoll_wait and one read,
+ *              the timerfd is not re-armed; every event handed to the driver is counted.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_019, TestSize.Level1)
+{
+    constexpr uint64_t wakeups = 10;
+    constexpr uint32_t eventCount = 20;
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 20;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+    std::vector<uint32_t> noteWords{0x20903C7F};
+    const uint64_t farDueNs = SteadyNowNs() + duration_cast<nanoseconds>(seconds(10)).count();
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(farDueNs, noteWords), true));
+    std::this_thread::sleep_for(milliseconds(50));
+
+    const uint64_t syscallsBefore = outputConnection.GetWorkerSyscallCount();
+    for (uint64_t i = 0; i < wakeups; i++) {
+        outputConnection.WakeWorkerByEventFd();
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+    EXPECT_LE(outputConnection.GetWorkerSyscallCount() - syscallsBefore, wakeups * 2);
+
+    std::vector<MidiEventInner> events(eventCount, MakeMidiEventInner(0, noteWords));
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvents(events.data(), eventCount, &written, true));
+    std::this_thread::sleep_for(milliseconds(50));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
+    EXPECT_EQ(eventCount, driver.GetEvents().size());
+    EXPECT_EQ(eventCount, outputConnection.GetSentEventCount());
+}
+
+/**
+ * @tc.name   : Test DeviceConnectionForOutput Busy Poll
+ * @tc.number : DeviceConnectionForOutput_020
+ * @tc.desc   : A woken worker polls the client rings, events written meanwhile go out without a worker syscall;
+ *              after the idle timeout the worker waits for notifications again and still gets the next event.
+ */
+HWTEST_F(MidiDeviceConnectionUnitTest, DeviceConnectionForOutput_020, TestSize.Level1)
+{
+    constexpr milliseconds idleTimeout(200);
+    RecordingMidiDeviceDriver driver;
+
+    DeviceConnectionInfo deviceConnectionInfo{};
+    deviceConnectionInfo.driver = &driver;
+    deviceConnectionInfo.deviceId = 21;
+    deviceConnectionInfo.direction = MidiPortDirection::OUTPUT;
+    deviceConnectionInfo.portIndex = 0;
+
+    DeviceConnectionForOutput outputConnection(deviceConnectionInfo);
+    outputConnection.SetBusyPoll(true, 0, -1, duration_cast<nanoseconds>(idleTimeout).count());
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.Start());
+
+    std::shared_ptr<MidiSharedRing> clientRingBuffer;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, outputConnection.AddClientConnection(1, 1000, clientRingBuffer));
+    std::vector<uint32_t> noteWords{0x20903C7F};
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, noteWords), true));
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_TRUE(outputConnection.IsBusyPolling());
+    EXPECT_EQ(RING_READER_POLLING, clientRingBuffer->GetControlHeader()->readerState.load());
+
+    const uint64_t syscallsBefore = outputConnection.GetWorkerSyscallCount();
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, noteWords), true));
+    }
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_EQ(6u, driver.GetEvents().size());
+    EXPECT_EQ(syscallsBefore, outputConnection.GetWorkerSyscallCount());
+
+    std::this_thread::sleep_for(idleTimeout * 2);
+    EXPECT_FALSE(outputConnection.IsBusyPolling());
+    EXPECT_NE(RING_READER_POLLING, clientRingBuffer->GetControlHeader()->readerState.load());
+    ASSERT_EQ(MidiStatusCode::OK, clientRingBuffer->TryWriteEvent(MakeMidiEventInner(0, noteWords), true));
+    std::this_thread::sleep_for(milliseconds(20));
+    EXPECT_EQ(7u, driver.GetEvents().size());
+    EXPECT_EQ(OH_MIDI_STATUS_OK, outputConnection.Stop());
 }
 } // namespace MIDI
 } // namespace OHOS
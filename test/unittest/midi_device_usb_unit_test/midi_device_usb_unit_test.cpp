@@ -16,9 +16,17 @@
 #include "midi_device_driver.h"
 #include "midi_device_usb.h"
 #include "midi_info.h"
+#include "midi_log.h"
+#include "midi_usb_shm_transport.h"
 #include "native_midi_base.h"
 #include "v1_0/imidi_interface.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -249,4 +257,388 @@ HWTEST_F(MidiDeviceUsbUnitTest, CloseInputPort001, TestSize.Level0)
     EXPECT_CALL(*mockMidiHdi, CloseInputPort(deviceId, portIndex)).WillOnce(Return(OH_MIDI_STATUS_OK));
 
     EXPECT_EQ(OH_MIDI_STATUS_OK, driver.CloseInputPort(deviceId, portIndex));
-}
\ No newline at end of file
+}
+class FakeUsbShmDriver : public UsbMidiShmTransport {
+public:
+    FakeUsbShmDriver()
+    {
+        capability.outputRing = true;
+        capability.inputRing = true;
+    }
+
+    UsbMidiShmCapability GetCapability(int64_t deviceId, uint32_t portIndex) override
+    {
+        (void)deviceId;
+        (void)portIndex;
+        return capability;
+    }
+
+    int32_t AttachOutputRing(int64_t deviceId, uint32_t portIndex,
+        const std::shared_ptr<MidiSharedRing> &ring) override
+    {
+        (void)deviceId;
+        (void)portIndex;
+        attachCount++;
+        CHECK_AND_RETURN_RET(attachResult == OH_MIDI_STATUS_OK, attachResult);
+        outputRing = ring;
+        return OH_MIDI_STATUS_OK;
+    }
+
+    int32_t AttachInputRing(int64_t deviceId, uint32_t portIndex,
+        const std::shared_ptr<MidiSharedRing> &ring) override
+    {
+        (void)deviceId;
+        (void)portIndex;
+        attachCount++;
+        CHECK_AND_RETURN_RET(attachResult == OH_MIDI_STATUS_OK, attachResult);
+        inputRing = ring;
+        return OH_MIDI_STATUS_OK;
+    }
+
+    void DetachOutputRing(int64_t deviceId, uint32_t portIndex) override
+    {
+        (void)deviceId;
+        (void)portIndex;
+        outputRing = nullptr;
+    }
+
+    void DetachInputRing(int64_t deviceId, uint32_t portIndex) override
+    {
+        (void)deviceId;
+        (void)portIndex;
+        inputRing = nullptr;
+    }
+
+    UsbMidiShmCapability capability;
+    int32_t attachResult = OH_MIDI_STATUS_OK;
+    uint32_t attachCount = 0;
+    std::shared_ptr<MidiSharedRing> outputRing;
+    std::shared_ptr<MidiSharedRing> inputRing;
+};
+
+/**
+ * @tc.name: ShmOutput001
+ * @tc.desc: output of a port with an attached ring lands in the ring without any HDI message
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiDeviceUsbUnitTest, ShmOutput001, TestSize.Level0)
+{
+    constexpr int64_t deviceId = 100;
+    constexpr uint32_t portIndex = 1;
+    sptr<MockIMidiInterface> mockMidiHdi = sptr<MockIMidiInterface>::MakeSptr();
+    auto fakeDriver = std::make_shared<FakeUsbShmDriver>();
+    UsbMidiTransportDeviceDriver driver;
+    driver.midiHdi_ = mockMidiHdi;
+    driver.SetShmTransport(fakeDriver);
+
+    EXPECT_CALL(*mockMidiHdi, OpenOutputPort(deviceId, portIndex)).WillOnce(Return(OH_MIDI_STATUS_OK));
+    EXPECT_CALL(*mockMidiHdi, SendMidiMessages(_, _, _)).Times(0);
+    EXPECT_CALL(*mockMidiHdi, CloseOutputPort(deviceId, portIndex)).WillOnce(Return(OH_MIDI_STATUS_OK));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, driver.OpenOutputPort(deviceId, portIndex));
+    ASSERT_NE(nullptr, fakeDriver->outputRing);
+
+    uint32_t noteOn = 0x20903C64u;
+    uint32_t sysex[2] = {0x30160102u, 0x03040506u};
+    std::vector<MidiEventInner> list = {{0, 1, &noteOn}, {5, 2, sysex}};
+    EXPECT_EQ(OH_MIDI_STATUS_OK, driver.HandleUmpInput(deviceId, portIndex, list));
+
+    std::vector<MidiEvent> events;
+    std::vector<std::vector<uint32_t>> payloads;
+    fakeDriver->outputRing->DrainToBatch(events, payloads, 0);
+    ASSERT_EQ(2u, events.size());
+    EXPECT_EQ(noteOn, events[0].data[0]);
+    EXPECT_EQ(5u, events[1].timestamp);
+    ASSERT_EQ(2u, events[1].length);
+    EXPECT_EQ(sysex[1], events[1].data[1]);
+
+    EXPECT_EQ(OH_MIDI_STATUS_OK, driver.CloseOutputPort(deviceId, portIndex));
+    EXPECT_EQ(nullptr, fakeDriver->outputRing);
+}
+
+/**
+ * @tc.name: ShmOutput002
+ * @tc.desc: the driver refuses the ring, output falls back to HDI messages
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiDeviceUsbUnitTest, ShmOutput002, TestSize.Level0)
+{
+    constexpr int64_t deviceId = 100;
+    constexpr uint32_t portIndex = 1;
+    sptr<MockIMidiInterface> mockMidiHdi = sptr<MockIMidiInterface>::MakeSptr();
+    auto fakeDriver = std::make_shared<FakeUsbShmDriver>();
+    fakeDriver->attachResult = OH_MIDI_STATUS_SYSTEM_ERROR;
+    UsbMidiTransportDeviceDriver driver;
+    driver.midiHdi_ = mockMidiHdi;
+    driver.SetShmTransport(fakeDriver);
+
+    EXPECT_CALL(*mockMidiHdi, OpenOutputPort(deviceId, portIndex)).WillOnce(Return(OH_MIDI_STATUS_OK));
+    EXPECT_CALL(*mockMidiHdi, SendMidiMessages(deviceId, portIndex, SizeIs(1))).WillOnce(Return(OH_MIDI_STATUS_OK));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, driver.OpenOutputPort(deviceId, portIndex));
+    EXPECT_EQ(nullptr, fakeDriver->outputRing);
+
+    uint32_t noteOn = 0x20903C64u;
+    std::vector<MidiEventInner> list = {{0, 1, &noteOn}};
+    EXPECT_EQ(OH_MIDI_STATUS_OK, driver.HandleUmpInput(deviceId, portIndex, list));
+}
+
+/**
+ * @tc.name: ShmOutput003
+ * @tc.desc: the driver has no output ring for the port, no ring is offered and output uses HDI messages
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiDeviceUsbUnitTest, ShmOutput003, TestSize.Level0)
+{
+    constexpr int64_t deviceId = 100;
+    constexpr uint32_t portIndex = 1;
+    sptr<MockIMidiInterface> mockMidiHdi = sptr<MockIMidiInterface>::MakeSptr();
+    auto fakeDriver = std::make_shared<FakeUsbShmDriver>();
+    fakeDriver->capability.outputRing = false;
+    UsbMidiTransportDeviceDriver driver;
+    driver.midiHdi_ = mockMidiHdi;
+    driver.SetShmTransport(fakeDriver);
+
+    EXPECT_CALL(*mockMidiHdi, OpenOutputPort(deviceId, portIndex)).WillOnce(Return(OH_MIDI_STATUS_OK));
+    EXPECT_CALL(*mockMidiHdi, SendMidiMessages(deviceId, portIndex, SizeIs(1))).WillOnce(Return(OH_MIDI_STATUS_OK));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, driver.OpenOutputPort(deviceId, portIndex));
+    EXPECT_EQ(0u, fakeDriver->attachCount);
+
+    uint32_t noteOn = 0x20903C64u;
+    std::vector<MidiEventInner> list = {{0, 1, &noteOn}};
+    EXPECT_EQ(OH_MIDI_STATUS_OK, driver.HandleUmpInput(deviceId, portIndex, list));
+}
+
+/**
+ * @tc.name: ShmInput001
+ * @tc.desc: events the driver writes into the input ring reach the input callback
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiDeviceUsbUnitTest, ShmInput001, TestSize.Level0)
+{
+    constexpr int64_t deviceId = 100;
+    constexpr uint32_t portIndex = 1;
+    sptr<MockIMidiInterface> mockMidiHdi = sptr<MockIMidiInterface>::MakeSptr();
+    auto fakeDriver = std::make_shared<FakeUsbShmDriver>();
+    UsbMidiTransportDeviceDriver driver;
+    driver.midiHdi_ = mockMidiHdi;
+    driver.SetShmTransport(fakeDriver);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<uint32_t> received;
+    UmpInputCallback inputCallback = [&](std::vector<MidiEventInner> &events) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &event : events) {
+            received.insert(received.end(), event.data, event.data + event.length);
+        }
+        cv.notify_all();
+    };
+
+    EXPECT_CALL(*mockMidiHdi, OpenInputPort(deviceId, portIndex, _)).WillOnce(Return(OH_MIDI_STATUS_OK));
+    EXPECT_CALL(*mockMidiHdi, CloseInputPort(deviceId, portIndex)).WillOnce(Return(OH_MIDI_STATUS_OK));
+    ASSERT_EQ(OH_MIDI_STATUS_OK, driver.OpenInputPort(deviceId, portIndex, inputCallback));
+    ASSERT_NE(nullptr, fakeDriver->inputRing);
+
+    uint32_t words[3] = {0x20903C64u, 0x20803C00u, 0x20B00740u};
+    std::vector<MidiEventInner> list = {{1, 1, &words[0]}, {2, 1, &words[1]}, {3, 1, &words[2]}};
+    uint32_t written = 0;
+    ASSERT_EQ(MidiStatusCode::OK, fakeDriver->inputRing->TryWriteEvents(list.data(), list.size(), &written));
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(1), [&]() { return received.size() == 3; }));
+    }
+    EXPECT_EQ(words[0], received[0]);
+    EXPECT_EQ(words[2], received[2]);
+
+    EXPECT_EQ(OH_MIDI_STATUS_OK, driver.CloseInputPort(deviceId, portIndex));
+    EXPECT_EQ(nullptr, fakeDriver->inputRing);
+}
+
+namespace {
+thread_local bool g_countAllocations = false;
+thread_local size_t g_allocationCount = 0;
+} // namespace
+
+void *operator new(size_t size)
+{
+    if (g_countAllocations) {
+        ++g_allocationCount;
+    }
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept
+{
+    (void)size;
+    free(ptr);
+}
+
+// gmock allocates while matching a call, so the allocation test records sends by hand
+class RecordingMidiInterface : public HDI::Midi::V1_0::IMidiInterface {
+public:
+    int32_t GetDeviceList(std::vector<HDI::Midi::V1_0::MidiDeviceInfo> &deviceList) override
+    {
+        (void)deviceList;
+        return OH_MIDI_STATUS_OK;
+    }
+    int32_t OpenDevice(int64_t deviceId) override
+    {
+        (void)deviceId;
+        return OH_MIDI_STATUS_OK;
+    }
+    int32_t CloseDevice(int64_t deviceId) override
+    {
+        (void)deviceId;
+        return OH_MIDI_STATUS_OK;
+    }
+    int32_t OpenInputPort(int64_t deviceId, uint32_t portId,
+        const sptr<HDI::Midi::V1_0::IMidiCallback> &dataCallback) override
+    {
+        (void)deviceId;
+        (void)portId;
+        (void)dataCallback;
+        return OH_MIDI_STATUS_OK;
+    }
+    int32_t OpenOutputPort(int64_t deviceId, uint32_t portId) override
+    {
+        (void)deviceId;
+        (void)portId;
+        return OH_MIDI_STATUS_OK;
+    }
+    int32_t CloseInputPort(int64_t deviceId, uint32_t portId) override
+    {
+        (void)deviceId;
+        (void)portId;
+        return OH_MIDI_STATUS_OK;
+    }
+    int32_t CloseOutputPort(int64_t deviceId, uint32_t portId) override
+    {
+        (void)deviceId;
+        (void)portId;
+        return OH_MIDI_STATUS_OK;
+    }
+    int32_t SendMidiMessages(int64_t deviceId, uint32_t portId,
+        const std::vector<HDI::Midi::V1_0::MidiMessage> &messages) override
+    {
+        (void)deviceId;
+        (void)portId;
+        ++sendCount;
+        messageCount = messages.size();
+        wordCount = 0;
+        for (const auto &message : messages) {
+            wordCount += message.data.size();
+        }
+        lastWord = messages.empty() || messages.back().data.empty() ? 0 : messages.back().data.back();
+        return OH_MIDI_STATUS_OK;
+    }
+
+    size_t sendCount = 0;
+    size_t messageCount = 0;
+    size_t wordCount = 0;
+    uint32_t lastWord = 0;
+};
+
+/**
+ * @tc.name: HandleUmpInput001
+ * @tc.desc: once the port arena has seen the batch shapes, sending batches performs no heap allocation
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiDeviceUsbUnitTest, HandleUmpInput001, TestSize.Level0)
+{
+    constexpr int64_t deviceId = 100;
+    constexpr uint32_t portIndex = 1;
+    sptr<RecordingMidiInterface> midiHdi = sptr<RecordingMidiInterface>::MakeSptr();
+    UsbMidiTransportDeviceDriver driver;
+    driver.midiHdi_ = midiHdi;
+    ASSERT_EQ(OH_MIDI_STATUS_OK, driver.OpenOutputPort(deviceId, portIndex));
+
+    uint32_t noteOn = 0x20903C64u;
+    uint32_t sysex[2] = {0x30160102u, 0x03040506u};
+    uint32_t stream[4] = {0xF0000001u, 0x00000002u, 0x00000003u, 0x00000004u};
+    std::vector<MidiEventInner> bigBatch = {{0, 1, &noteOn}, {1, 2, sysex}, {2, 4, stream}};
+    std::vector<MidiEventInner> smallBatch = {{3, 4, stream}, {4, 1, &noteOn}};
+
+    // warm up: the small batch parks buffers that the next big batch takes back
+    EXPECT_EQ(OH_MIDI_STATUS_OK, driver.HandleUmpInput(deviceId, portIndex, bigBatch));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, driver.HandleUmpInput(deviceId, portIndex, smallBatch));
+    EXPECT_EQ(OH_MIDI_STATUS_OK, driver.HandleUmpInput(deviceId, portIndex, bigBatch));
+
+    g_allocationCount = 0;
+    g_countAllocations = true;
+    int32_t bigRet = driver.HandleUmpInput(deviceId, portIndex, bigBatch);
+    size_t bigWords = midiHdi->wordCount;
+    int32_t smallRet = driver.HandleUmpInput(deviceId, portIndex, smallBatch);
+    g_countAllocations = false;
+
+    EXPECT_EQ(0u, g_allocationCount);
+    EXPECT_EQ(OH_MIDI_STATUS_OK, bigRet);
+    EXPECT_EQ(OH_MIDI_STATUS_OK, smallRet);
+    EXPECT_EQ(7u, bigWords);
+    EXPECT_EQ(5u, midiHdi->sendCount);
+    EXPECT_EQ(2u, midiHdi->messageCount);
+    EXPECT_EQ(5u, midiHdi->wordCount);
+    EXPECT_EQ(noteOn, midiHdi->lastWord);
+    EXPECT_EQ(OH_MIDI_STATUS_OK, driver.CloseOutputPort(deviceId, portIndex));
+}
+
+/**
+ * @tc.name: GetOutputCapability001
+ * @tc.desc: USB output ports take timestamped messages ahead of time and submit asynchronously
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiDeviceUsbUnitTest, GetOutputCapability001, TestSize.Level0)
+{
+    UsbMidiTransportDeviceDriver driver;
+    MidiDriverCapability capability = driver.GetOutputCapability(100, 1);
+    EXPECT_TRUE(capability.supportsScheduledOutput);
+    EXPECT_GT(capability.lookaheadNs, 0u);
+    EXPECT_EQ(MIDI_DEFAULT_ASYNC_OUTPUT_DEPTH, capability.asyncOutputDepth);
+    EXPECT_EQ(0u, capability.wireBytesPerSecond);
+}
+
+/**
+ * @tc.name: GetOutputCapability002
+ * @tc.desc: only a device listed as wired to DIN jacks reports the DIN rate
+ * @tc.type: FUNC
+ */
+HWTEST_F(MidiDeviceUsbUnitTest, GetOutputCapability002, TestSize.Level0)
+{
+    sptr<MockIMidiInterface> mockMidiHdi = sptr<MockIMidiInterface>::MakeSptr();
+    UsbMidiTransportDeviceDriver driver;
+    driver.midiHdi_ = mockMidiHdi;
+    driver.SetDinDevices({{0x5678, 0x1234}});
+
+    const int64_t dinDeviceId = 100;
+    const int64_t otherDeviceId = 101;
+    EXPECT_CALL(*mockMidiHdi, GetDeviceList(_))
+        .Times(1)
+        .WillOnce(Invoke([&](std::vector<HDI::Midi::V1_0::MidiDeviceInfo> &deviceList) {
+            HDI::Midi::V1_0::MidiDeviceInfo device{};
+            device.protocol = HDI::Midi::V1_0::MIDI_PROTOCOL_1_0;
+            device.deviceId = dinDeviceId;
+            device.vendorId = "0x5678";
+            device.productId = "0x1234";
+            deviceList.push_back(device);
+            device.deviceId = otherDeviceId;
+            device.productId = "0x1235";
+            deviceList.push_back(device);
+            return OH_MIDI_STATUS_OK;
+        }));
+    ASSERT_EQ(2u, driver.GetRegisteredDevices().size());
+
+    MidiDriverCapability capability = driver.GetOutputCapability(dinDeviceId, 0);
+    EXPECT_EQ(MIDI_DIN_BYTES_PER_SECOND, capability.wireBytesPerSecond);
+    EXPECT_EQ(MidiWireFormat::MIDI1_BYTE_STREAM, capability.wireFormat);
+    capability = driver.GetOutputCapability(otherDeviceId, 0);
+    EXPECT_EQ(0u, capability.wireBytesPerSecond);
+    EXPECT_EQ(MidiWireFormat::UMP, capability.wireFormat);
+}
@@ -45,6 +45,14 @@ public:
     MOCK_METHOD(int32_t, CloseInputPort, (int64_t, uint32_t), (override));
     MOCK_METHOD(int32_t, CloseOutputPort, (int64_t, uint32_t), (override));
     MOCK_METHOD(int32_t, DestroyMidiClient, (), (override));
+    MOCK_METHOD(int32_t, CancelScheduledEvents, (int64_t, uint32_t, uint32_t, uint64_t, uint64_t), (override));
+    MOCK_METHOD(int32_t, OpenOutputTimeline, (std::shared_ptr<MidiSharedTimeline> &, int64_t, uint32_t, uint32_t),
+        (override));
+    MOCK_METHOD(int32_t, SetOutputPortExclusive, (int64_t, uint32_t, bool), (override));
+    MOCK_METHOD(int32_t, OpenInputPortBroadcast, (std::shared_ptr<MidiBroadcastRing> &, int64_t, uint32_t),
+        (override));
+    MOCK_METHOD(int32_t, OpenInputPortWithFilter,
+        (std::shared_ptr<MidiSharedRing> &, int64_t, uint32_t, const MidiInputFilter &), (override));
     MOCK_METHOD(sptr<IRemoteObject>, AsObject, (), (override));
 };
 